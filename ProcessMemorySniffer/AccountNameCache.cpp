@@ -0,0 +1,76 @@
+#include <Windows.h>
+#include <sddl.h>
+
+#include "AccountNameCache.hpp"
+#include "ProcessInfo.hpp"
+#include "ResourceCounters.hpp"
+
+#pragma comment(lib, "Advapi32.lib")
+
+/// <summary>
+/// Well-known SIDs owning most system processes, with the names LookupAccountSidW reports for them on an English system.
+/// </summary>
+constexpr struct
+{
+	const wchar_t* sid;
+	const wchar_t* name;
+} WELL_KNOWN_ACCOUNTS[] = {
+	{ L"S-1-5-18", L"NT AUTHORITY\\SYSTEM" },
+	{ L"S-1-5-19", L"NT AUTHORITY\\LOCAL SERVICE" },
+	{ L"S-1-5-20", L"NT AUTHORITY\\NETWORK SERVICE" },
+};
+
+/// <summary>
+/// Constructs the cache and seeds it with the well-known service accounts.
+/// </summary>
+AccountNameCache::AccountNameCache()
+{
+	for (const auto& account : WELL_KNOWN_ACCOUNTS)
+	{
+		names_.emplace(account.sid, account.name);
+	}
+}
+
+/// <summary>
+/// Returns the account name for a string SID, looking it up with LookupAccountSidW the first time the SID is seen.
+/// </summary>
+/// <param name="sid">The string SID, e.g. "S-1-5-21-...-1001". An empty string stands for an unknown owner, PENDING_METADATA for one not resolved yet.</param>
+/// <returns>"DOMAIN\user" if the SID could be resolved, otherwise the SID itself ("<unknown>" for an empty SID). The reference stays valid for the lifetime of the cache.</returns>
+const std::wstring& AccountNameCache::resolve(const std::wstring& sid)
+{
+	if (sid == PENDING_METADATA)
+	{
+		// Not cached, so the placeholder never reaches the accounts saved to a MetadataCache.
+		static const std::wstring PENDING = PENDING_METADATA;
+		return PENDING;
+	}
+
+	if (const auto it = names_.find(sid); it != names_.end())
+	{
+		return it->second;
+	}
+
+	std::wstring name = sid.empty() ? L"<unknown>" : sid;
+	PSID binarySid = nullptr;
+
+	if (!sid.empty() && ::ConvertStringSidToSidW(sid.c_str(), &binarySid))
+	{
+		wchar_t account[256];
+		wchar_t domain[256];
+		DWORD accountLength = static_cast<DWORD>(std::size(account));
+		DWORD domainLength = static_cast<DWORD>(std::size(domain));
+		SID_NAME_USE use{};
+
+		countSystemCall();
+		if (::LookupAccountSidW(nullptr, binarySid, account, &accountLength, domain, &domainLength, &use))
+		{
+			name = domainLength > 0
+				? std::wstring(domain, domainLength) + L"\\" + std::wstring(account, accountLength)
+				: std::wstring(account, accountLength);
+		}
+
+		::LocalFree(binarySid);
+	}
+
+	return names_.emplace(sid, std::move(name)).first->second;
+}
\ No newline at end of file
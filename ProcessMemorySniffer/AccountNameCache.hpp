@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// Resolves string SIDs (the Windows analogue of a uid) to "DOMAIN\user" account names, calling LookupAccountSidW at most once per SID.
+/// Well-known service SIDs are seeded from a static table so they never reach LSA; SIDs that cannot be resolved (no domain controller,
+/// containers without the host's accounts, deleted users) are cached as their SID string so the lookup is not retried.
+/// </summary>
+class AccountNameCache
+{
+public:
+	AccountNameCache();
+
+	[[nodiscard]] const std::wstring& resolve(const std::wstring& sid);
+
+	/// <summary>
+	/// Adds an account name resolved elsewhere, e.g. by a previous run; a name already known is kept.
+	/// </summary>
+	/// <param name="sid">The string SID.</param>
+	/// <param name="name">The account name.</param>
+	void prime(std::wstring sid, std::wstring name)
+	{
+		names_.try_emplace(std::move(sid), std::move(name));
+	}
+
+	/// <summary>
+	/// Returns every name known to the cache, keyed by string SID; unresolvable SIDs map to themselves.
+	/// </summary>
+	[[nodiscard]] const std::unordered_map<std::wstring, std::wstring>& names() const noexcept
+	{
+		return names_;
+	}
+
+private:
+	/// <summary>
+	/// Resolved account names keyed by string SID.
+	/// </summary>
+	std::unordered_map<std::wstring, std::wstring> names_;
+};
\ No newline at end of file
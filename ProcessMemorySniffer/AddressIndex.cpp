@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <bit>
+
+#include "AddressIndex.hpp"
+
+/// <summary>
+/// Builds the index from a region list. The list is sorted by base address if it is not already (RegionQueryService returns it sorted), then laid out in Eytzinger order with an in-order walk of the implicit tree.
+/// </summary>
+/// <param name="regions">The non-overlapping regions to index. Ownership is taken; the regions are exposed through regions().</param>
+AddressIndex::AddressIndex(std::vector<MemoryRegion> regions) : regions_(std::move(regions))
+{
+	const auto byBase = [](const MemoryRegion& a, const MemoryRegion& b)
+		{
+			return a.base < b.base;
+		};
+
+	if (!std::is_sorted(regions_.begin(), regions_.end(), byBase))
+	{
+		std::sort(regions_.begin(), regions_.end(), byBase);
+	}
+
+	const std::size_t n = regions_.size();
+	bases_.resize(n + 1);
+	order_.resize(n + 1);
+
+	// Iterative in-order traversal of the implicit tree rooted at slot 1: the i-th visited slot receives the i-th smallest base.
+	std::size_t next = 0;
+	std::size_t k = 1;
+	std::vector<std::size_t> stack;
+
+	while (next < n)
+	{
+		while (k <= n)
+		{
+			stack.push_back(k);
+			k = 2 * k;
+		}
+
+		k = stack.back();
+		stack.pop_back();
+
+		bases_[k] = regions_[next].base;
+		order_[k] = static_cast<std::uint32_t>(next);
+		next++;
+
+		k = 2 * k + 1;
+	}
+}
+
+/// <summary>
+/// Finds the region containing an address.
+/// </summary>
+/// <param name="address">The address to resolve.</param>
+/// <returns>A pointer to the region containing address, or nullptr if the address lies in free space.</returns>
+const MemoryRegion* AddressIndex::find(std::uintptr_t address) const noexcept
+{
+	const std::size_t n = regions_.size();
+	std::size_t k = 1;
+
+	// Descend to a leaf, going right whenever the slot's base is <= address. The comparison result feeds the index, not a branch.
+	while (k <= n)
+	{
+		k = 2 * k + static_cast<std::size_t>(bases_[k] <= address);
+	}
+
+	// Strip the trailing right turns plus the final left turn; what remains is the slot of the first base > address, or 0 if there is none.
+	k >>= std::countr_one(k) + 1;
+
+	const std::size_t upper = k == 0 ? n : order_[k];
+
+	if (upper == 0)
+	{
+		return nullptr;
+	}
+
+	const MemoryRegion& candidate = regions_[upper - 1];
+
+	return address < candidate.end() ? &candidate : nullptr;
+}
+
+/// <summary>
+/// Resolves a stream of addresses sorted in ascending order with a single linear merge against the sorted region list, which is cheaper than independent lookups once the stream is dense.
+/// </summary>
+/// <param name="addresses">The addresses to resolve, sorted in ascending order.</param>
+/// <param name="results">Receives one entry per address: the containing region or nullptr. It is cleared first.</param>
+void AddressIndex::findSorted(std::span<const std::uintptr_t> addresses, std::vector<const MemoryRegion*>& results) const
+{
+	results.clear();
+	results.reserve(addresses.size());
+
+	std::size_t r = 0;
+
+	for (const std::uintptr_t address : addresses)
+	{
+		while (r < regions_.size() && regions_[r].end() <= address)
+		{
+			r++;
+		}
+
+		const bool inside = r < regions_.size() && regions_[r].base <= address;
+		results.push_back(inside ? &regions_[r] : nullptr);
+	}
+}
\ No newline at end of file
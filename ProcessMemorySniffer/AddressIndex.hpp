@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "MemoryRegion.hpp"
+
+/// <summary>
+/// Immutable index answering "which region does this address belong to" for the region list of one process.
+/// Single lookups descend an Eytzinger (breadth-first) layout of the region base addresses, which keeps the hot top levels of the
+/// implicit search tree in a few cache lines and replaces the data-dependent branch of a binary search with index arithmetic.
+/// Sorted address streams can be resolved in one linear merge with findSorted().
+/// </summary>
+class AddressIndex
+{
+public:
+	AddressIndex() = default;
+
+	explicit AddressIndex(std::vector<MemoryRegion> regions);
+
+	[[nodiscard]] const MemoryRegion* find(std::uintptr_t address) const noexcept;
+
+	void findSorted(std::span<const std::uintptr_t> addresses, std::vector<const MemoryRegion*>& results) const;
+
+	/// <summary>
+	/// Returns the indexed regions, sorted by base address.
+	/// </summary>
+	/// <returns>A const reference to the region list.</returns>
+	[[nodiscard]] const std::vector<MemoryRegion>& regions() const noexcept
+	{
+		return regions_;
+	}
+
+	/// <summary>
+	/// Returns whether the index contains no regions.
+	/// </summary>
+	/// <returns>true if no region was indexed.</returns>
+	[[nodiscard]] bool empty() const noexcept
+	{
+		return regions_.empty();
+	}
+
+private:
+	/// <summary>
+	/// The indexed regions, sorted by base address and non-overlapping.
+	/// </summary>
+	std::vector<MemoryRegion>	regions_;
+
+	/// <summary>
+	/// Region base addresses in Eytzinger order. One-based: slot 0 is unused so that the children of slot k are 2k and 2k + 1.
+	/// </summary>
+	std::vector<std::uintptr_t>	bases_;
+
+	/// <summary>
+	/// Maps each Eytzinger slot to the index of its region in regions_.
+	/// </summary>
+	std::vector<std::uint32_t>	order_;
+};
\ No newline at end of file
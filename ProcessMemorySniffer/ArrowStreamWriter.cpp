@@ -0,0 +1,397 @@
+#include <Windows.h>
+
+#include "ArrowStreamWriter.hpp"
+#include "TextEncoding.hpp"
+
+/// <summary>
+/// Arrow metadata version V5.
+/// </summary>
+constexpr std::int16_t METADATA_VERSION = 4;
+
+/// <summary>
+/// MessageHeader union type codes.
+/// </summary>
+constexpr std::uint8_t HEADER_SCHEMA = 1;
+constexpr std::uint8_t HEADER_DICTIONARY_BATCH = 2;
+constexpr std::uint8_t HEADER_RECORD_BATCH = 3;
+
+/// <summary>
+/// Type union type codes.
+/// </summary>
+constexpr std::uint8_t TYPE_INT = 2;
+constexpr std::uint8_t TYPE_UTF8 = 5;
+constexpr std::uint8_t TYPE_TIMESTAMP = 10;
+
+/// <summary>
+/// TimeUnit MILLISECOND.
+/// </summary>
+constexpr std::int16_t TIME_UNIT_MILLISECOND = 1;
+
+/// <summary>
+/// Dictionary ids of the name and user_sid columns.
+/// </summary>
+constexpr std::int64_t NAME_DICTIONARY = 0;
+constexpr std::int64_t USER_DICTIONARY = 1;
+
+/// <summary>
+/// Alignment and padding of body buffers.
+/// </summary>
+constexpr std::size_t BUFFER_ALIGNMENT = 64;
+
+/// <summary>
+/// Marks the start of every encapsulated message.
+/// </summary>
+constexpr std::uint32_t CONTINUATION = 0xFFFFFFFF;
+
+/// <summary>
+/// Rounds a size up to a multiple of BUFFER_ALIGNMENT.
+/// </summary>
+/// <param name="size">The size in bytes.</param>
+/// <returns>The padded size.</returns>
+static std::size_t padded(std::size_t size) noexcept
+{
+	return (size + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+}
+
+/// <summary>
+/// Returns the byte size of a vector's contents.
+/// </summary>
+template <typename T>
+static std::size_t byteSize(const std::vector<T>& values) noexcept
+{
+	return values.size() * sizeof(T);
+}
+
+/// <summary>
+/// Builds an Int type table.
+/// </summary>
+/// <param name="builder">The builder.</param>
+/// <param name="bitWidth">The width in bits.</param>
+/// <param name="isSigned">Whether the integer is signed.</param>
+/// <returns>The table offset.</returns>
+static FlatBufferBuilder::Offset buildIntType(FlatBufferBuilder& builder, std::int32_t bitWidth, bool isSigned)
+{
+	builder.startTable();
+	builder.addScalar<std::int32_t>(0, bitWidth);
+	builder.addScalar<std::uint8_t>(1, isSigned ? 1 : 0);
+	return builder.endTable();
+}
+
+/// <summary>
+/// Builds a Field table. Children are always written (empty), as Arrow readers reject fields without a children vector.
+/// </summary>
+/// <param name="builder">The builder.</param>
+/// <param name="name">The column name.</param>
+/// <param name="nullable">Whether the column may contain nulls.</param>
+/// <param name="typeType">The Type union code.</param>
+/// <param name="type">The type table.</param>
+/// <param name="dictionary">The DictionaryEncoding table, or 0 for a plain column.</param>
+/// <returns>The table offset.</returns>
+static FlatBufferBuilder::Offset buildField(FlatBufferBuilder& builder, std::string_view name, bool nullable,
+	std::uint8_t typeType, FlatBufferBuilder::Offset type, FlatBufferBuilder::Offset dictionary = 0)
+{
+	const auto nameOffset = builder.createString(name);
+	const auto children = builder.createOffsetVector({});
+
+	builder.startTable();
+	builder.addOffset(0, nameOffset);
+	builder.addScalar<std::uint8_t>(1, nullable ? 1 : 0);
+	builder.addScalar<std::uint8_t>(2, typeType);
+	builder.addOffset(3, type);
+
+	if (dictionary != 0)
+	{
+		builder.addOffset(4, dictionary);
+	}
+
+	builder.addOffset(5, children);
+	return builder.endTable();
+}
+
+/// <summary>
+/// Builds a dictionary-encoded utf8 Field with int32 indices.
+/// </summary>
+/// <param name="builder">The builder.</param>
+/// <param name="name">The column name.</param>
+/// <param name="nullable">Whether the column may contain nulls.</param>
+/// <param name="id">The dictionary id.</param>
+/// <returns>The table offset.</returns>
+static FlatBufferBuilder::Offset buildDictionaryField(FlatBufferBuilder& builder, std::string_view name, bool nullable, std::int64_t id)
+{
+	const auto indexType = buildIntType(builder, 32, true);
+
+	builder.startTable();
+	builder.addScalar<std::int64_t>(0, id);
+	builder.addOffset(1, indexType);
+	const auto encoding = builder.endTable();
+
+	builder.startTable();
+	const auto utf8 = builder.endTable();
+
+	return buildField(builder, name, nullable, TYPE_UTF8, utf8, encoding);
+}
+
+/// <summary>
+/// Builds a Message table around a header and finishes the buffer.
+/// </summary>
+/// <param name="builder">The builder.</param>
+/// <param name="headerType">The MessageHeader union code.</param>
+/// <param name="header">The header table.</param>
+/// <param name="bodyLength">The length of the message body in bytes.</param>
+/// <returns>The encoded metadata.</returns>
+static std::vector<std::uint8_t> finishMessage(FlatBufferBuilder& builder, std::uint8_t headerType,
+	FlatBufferBuilder::Offset header, std::int64_t bodyLength)
+{
+	builder.startTable();
+	builder.addScalar<std::int64_t>(3, bodyLength);
+	builder.addOffset(2, header);
+	builder.addScalar<std::int16_t>(0, METADATA_VERSION);
+	builder.addScalar<std::uint8_t>(1, headerType);
+	return builder.finish(builder.endTable());
+}
+
+/// <summary>
+/// Constructs a writer.
+/// </summary>
+/// <param name="out">The buffer the stream is written to, e.g. over standard output or a file. Must outlive the writer.</param>
+ArrowStreamWriter::ArrowStreamWriter(OutputBuffer& out) : out_(out)
+{ }
+
+/// <summary>
+/// Writes one tick as a record batch, preceded by the schema on the first call and by dictionary batches for names and SIDs not sent before.
+/// </summary>
+/// <param name="processes">The processes collected on the tick.</param>
+/// <param name="tick">The zero-based tick number.</param>
+/// <param name="timestampMs">The collection time in milliseconds since the Unix epoch.</param>
+void ArrowStreamWriter::writeBatch(const std::vector<ProcessInfo>& processes, std::size_t tick, std::uint64_t timestampMs)
+{
+	const std::size_t n = processes.size();
+
+	ticks_.assign(n, tick);
+	timestamps_.assign(n, static_cast<std::int64_t>(timestampMs));
+	pids_.resize(n);
+	nameIndices_.resize(n);
+	nameValidity_.assign((n + 7) / 8, 0);
+	userIndices_.resize(n);
+	userValidity_.assign((n + 7) / 8, 0);
+	workingSets_.resize(n);
+	privates_.resize(n);
+
+	std::int64_t nameNulls = 0;
+	std::int64_t userNulls = 0;
+
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const ProcessInfo& p = processes[i];
+
+		pids_[i] = p.pid;
+		workingSets_[i] = p.workingSetBytes;
+		privates_[i] = p.privateBytes;
+
+		// A pending row's name and SID are placeholders, not data; they are written as nulls and never enter the dictionaries.
+		if (p.metadataPending)
+		{
+			nameIndices_[i] = 0;
+			nameNulls++;
+		}
+		else
+		{
+			nameIndices_[i] = static_cast<std::int32_t>(names_.intern(p.name));
+			nameValidity_[i / 8] |= static_cast<std::uint8_t>(1u << (i % 8));
+		}
+
+		if (p.userSid.empty() || p.metadataPending)
+		{
+			userIndices_[i] = 0;
+			userNulls++;
+		}
+		else
+		{
+			userIndices_[i] = static_cast<std::int32_t>(users_.intern(p.userSid));
+			userValidity_[i / 8] |= static_cast<std::uint8_t>(1u << (i % 8));
+		}
+	}
+
+	const bool first = !started_;
+
+	if (first)
+	{
+		writeSchema();
+		started_ = true;
+	}
+
+	writeDictionary(NAME_DICTIONARY, names_, namesSent_, first);
+	writeDictionary(USER_DICTIONARY, users_, usersSent_, first);
+
+	// Body layout: per column a validity buffer (empty when the column has no nulls) followed by its values.
+	std::vector<std::pair<const void*, std::size_t>> body = {
+		{ nullptr, 0 }, { ticks_.data(), byteSize(ticks_) },
+		{ nullptr, 0 }, { timestamps_.data(), byteSize(timestamps_) },
+		{ nullptr, 0 }, { pids_.data(), byteSize(pids_) },
+		{ nameNulls > 0 ? nameValidity_.data() : nullptr, nameNulls > 0 ? nameValidity_.size() : 0 }, { nameIndices_.data(), byteSize(nameIndices_) },
+		{ userNulls > 0 ? userValidity_.data() : nullptr, userNulls > 0 ? userValidity_.size() : 0 }, { userIndices_.data(), byteSize(userIndices_) },
+		{ nullptr, 0 }, { workingSets_.data(), byteSize(workingSets_) },
+		{ nullptr, 0 }, { privates_.data(), byteSize(privates_) },
+	};
+
+	std::vector<BufferSpec> buffers;
+	std::int64_t offset = 0;
+
+	for (const auto& [data, size] : body)
+	{
+		buffers.push_back({ offset, static_cast<std::int64_t>(size) });
+		offset += static_cast<std::int64_t>(padded(size));
+	}
+
+	const auto length = static_cast<std::int64_t>(n);
+	const std::vector<FieldNode> nodes = {
+		{ length, 0 }, { length, 0 }, { length, 0 }, { length, nameNulls }, { length, userNulls }, { length, 0 }, { length, 0 },
+	};
+
+	FlatBufferBuilder builder;
+	const auto batch = buildRecordBatch(builder, length, nodes, buffers);
+	writeMessage(finishMessage(builder, HEADER_RECORD_BATCH, batch, offset), body);
+}
+
+/// <summary>
+/// Writes the end-of-stream marker. The stream is complete after this call.
+/// </summary>
+void ArrowStreamWriter::finish()
+{
+	const std::uint32_t endOfStream[] = { CONTINUATION, 0 };
+	out_.append(std::string_view(reinterpret_cast<const char*>(endOfStream), sizeof(endOfStream)));
+	out_.flush();
+}
+
+/// <summary>
+/// Writes the Schema message describing the seven columns.
+/// </summary>
+void ArrowStreamWriter::writeSchema()
+{
+	FlatBufferBuilder builder;
+	std::vector<FlatBufferBuilder::Offset> fields;
+
+	fields.push_back(buildField(builder, "tick", false, TYPE_INT, buildIntType(builder, 64, false)));
+
+	const auto timezone = builder.createString("UTC");
+	builder.startTable();
+	builder.addScalar<std::int16_t>(0, TIME_UNIT_MILLISECOND);
+	builder.addOffset(1, timezone);
+	const auto timestamp = builder.endTable();
+	fields.push_back(buildField(builder, "timestamp", false, TYPE_TIMESTAMP, timestamp));
+
+	fields.push_back(buildField(builder, "pid", false, TYPE_INT, buildIntType(builder, 32, false)));
+	fields.push_back(buildDictionaryField(builder, "name", true, NAME_DICTIONARY));
+	fields.push_back(buildDictionaryField(builder, "user_sid", true, USER_DICTIONARY));
+	fields.push_back(buildField(builder, "working_set_bytes", false, TYPE_INT, buildIntType(builder, 64, false)));
+	fields.push_back(buildField(builder, "private_bytes", false, TYPE_INT, buildIntType(builder, 64, false)));
+
+	const auto fieldVector = builder.createOffsetVector(fields);
+
+	builder.startTable();
+	builder.addOffset(1, fieldVector);
+	builder.addScalar<std::int16_t>(0, 0);
+	const auto schema = builder.endTable();
+
+	writeMessage(finishMessage(builder, HEADER_SCHEMA, schema, 0), {});
+}
+
+/// <summary>
+/// Writes the strings interned since the last dictionary batch of a dictionary as a utf8 DictionaryBatch. The first batch of each dictionary is always written, even if empty, because readers need every dictionary before the first record batch; later batches are deltas and are skipped when there is nothing new.
+/// </summary>
+/// <param name="id">The dictionary id.</param>
+/// <param name="strings">The interned dictionary values.</param>
+/// <param name="sent">The number of values already sent; advanced to strings.size().</param>
+/// <param name="first">Whether this is the first batch of the dictionary.</param>
+void ArrowStreamWriter::writeDictionary(std::int64_t id, const StringInterner& strings, std::size_t& sent, bool first)
+{
+	if (!first && sent == strings.size())
+	{
+		return;
+	}
+
+	std::vector<std::int32_t> offsets;
+	std::string data;
+	offsets.reserve(strings.size() - sent + 1);
+	offsets.push_back(0);
+
+	for (std::size_t i = sent; i < strings.size(); i++)
+	{
+		data += toUtf8(strings.lookup(static_cast<StringId>(i)));
+		offsets.push_back(static_cast<std::int32_t>(data.size()));
+	}
+
+	const auto length = static_cast<std::int64_t>(strings.size() - sent);
+	sent = strings.size();
+
+	const std::vector<std::pair<const void*, std::size_t>> body = {
+		{ nullptr, 0 }, { offsets.data(), byteSize(offsets) }, { data.data(), data.size() },
+	};
+
+	std::vector<BufferSpec> buffers;
+	std::int64_t offset = 0;
+
+	for (const auto& [bytes, size] : body)
+	{
+		buffers.push_back({ offset, static_cast<std::int64_t>(size) });
+		offset += static_cast<std::int64_t>(padded(size));
+	}
+
+	FlatBufferBuilder builder;
+	const auto batch = buildRecordBatch(builder, length, { { length, 0 } }, buffers);
+
+	builder.startTable();
+	builder.addScalar<std::int64_t>(0, id);
+	builder.addOffset(1, batch);
+	builder.addScalar<std::uint8_t>(2, first ? 0 : 1);
+	const auto dictionaryBatch = builder.endTable();
+
+	writeMessage(finishMessage(builder, HEADER_DICTIONARY_BATCH, dictionaryBatch, offset), body);
+}
+
+/// <summary>
+/// Builds a RecordBatch table.
+/// </summary>
+/// <param name="builder">The builder.</param>
+/// <param name="length">The number of rows.</param>
+/// <param name="nodes">One node per column.</param>
+/// <param name="buffers">The body buffers, in column order.</param>
+/// <returns>The table offset.</returns>
+FlatBufferBuilder::Offset ArrowStreamWriter::buildRecordBatch(FlatBufferBuilder& builder, std::int64_t length,
+	const std::vector<FieldNode>& nodes, const std::vector<BufferSpec>& buffers)
+{
+	const auto nodeVector = builder.createVector(nodes.data(), sizeof(FieldNode), nodes.size(), 8);
+	const auto bufferVector = builder.createVector(buffers.data(), sizeof(BufferSpec), buffers.size(), 8);
+
+	builder.startTable();
+	builder.addScalar<std::int64_t>(0, length);
+	builder.addOffset(1, nodeVector);
+	builder.addOffset(2, bufferVector);
+	return builder.endTable();
+}
+
+/// <summary>
+/// Writes an encapsulated message: continuation marker, metadata length, metadata padded to 8 bytes, then the body buffers each padded to BUFFER_ALIGNMENT. Body buffers are copied straight from the column vectors into the output buffer.
+/// </summary>
+/// <param name="metadata">The encoded Message FlatBuffer.</param>
+/// <param name="body">The body buffers as (data, size) pairs.</param>
+void ArrowStreamWriter::writeMessage(std::vector<std::uint8_t> metadata, const std::vector<std::pair<const void*, std::size_t>>& body)
+{
+	metadata.resize((metadata.size() + 7) / 8 * 8, 0);
+
+	const std::uint32_t prefix[] = { CONTINUATION, static_cast<std::uint32_t>(metadata.size()) };
+	out_.append(std::string_view(reinterpret_cast<const char*>(prefix), sizeof(prefix)));
+	out_.append(std::string_view(reinterpret_cast<const char*>(metadata.data()), metadata.size()));
+
+	static constexpr char zeros[BUFFER_ALIGNMENT] = {};
+
+	for (const auto& [data, size] : body)
+	{
+		if (size > 0)
+		{
+			out_.append(std::string_view(static_cast<const char*>(data), size));
+		}
+
+		out_.append(std::string_view(zeros, padded(size) - size));
+	}
+}
\ No newline at end of file
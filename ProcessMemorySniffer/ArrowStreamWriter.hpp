@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FlatBufferBuilder.hpp"
+#include "OutputBuffer.hpp"
+#include "ProcessInfo.hpp"
+#include "StringInterner.hpp"
+
+/// <summary>
+/// Writes snapshots in the Apache Arrow IPC streaming format without depending on the Arrow library.
+/// The stream starts with a Schema message; every tick becomes one RecordBatch with the columns
+/// tick (uint64), timestamp (timestamp[ms, UTC]), pid (uint32), name (dictionary&lt;int32, utf8&gt;, null while the metadata is
+/// pending), user_sid (dictionary&lt;int32, utf8&gt;, null when unknown or pending), working_set_bytes (uint64) and private_bytes (uint64).
+/// Names and SIDs are interned for the lifetime of the stream; only entries not sent before go out, as delta DictionaryBatch
+/// messages ahead of the batch that first uses them. Column buffers are reused across ticks and written straight from memory,
+/// each padded to 64 bytes as the format recommends.
+/// </summary>
+class ArrowStreamWriter
+{
+public:
+	explicit ArrowStreamWriter(OutputBuffer& out);
+
+	void writeBatch(const std::vector<ProcessInfo>& processes, std::size_t tick, std::uint64_t timestampMs);
+
+	void finish();
+
+private:
+	/// <summary>
+	/// Location of one buffer within a message body.
+	/// </summary>
+	struct BufferSpec
+	{
+		std::int64_t offset;
+		std::int64_t length;
+	};
+
+	/// <summary>
+	/// Length and null count of one column within a record batch.
+	/// </summary>
+	struct FieldNode
+	{
+		std::int64_t length;
+		std::int64_t nullCount;
+	};
+
+	void writeSchema();
+
+	void writeDictionary(std::int64_t id, const StringInterner& strings, std::size_t& sent, bool first);
+
+	FlatBufferBuilder::Offset buildRecordBatch(FlatBufferBuilder& builder, std::int64_t length,
+		const std::vector<FieldNode>& nodes, const std::vector<BufferSpec>& buffers);
+
+	void writeMessage(std::vector<std::uint8_t> metadata, const std::vector<std::pair<const void*, std::size_t>>& body);
+
+	/// <summary>
+	/// The buffer the stream is written to.
+	/// </summary>
+	OutputBuffer&				out_;
+
+	/// <summary>
+	/// Whether the schema and initial dictionaries have been written.
+	/// </summary>
+	bool						started_{ false };
+
+	/// <summary>
+	/// Interned process names; the values of dictionary 0.
+	/// </summary>
+	StringInterner				names_;
+
+	/// <summary>
+	/// Interned owner SIDs; the values of dictionary 1.
+	/// </summary>
+	StringInterner				users_;
+
+	/// <summary>
+	/// The number of names already sent in dictionary batches.
+	/// </summary>
+	std::size_t					namesSent_{ 0 };
+
+	/// <summary>
+	/// The number of SIDs already sent in dictionary batches.
+	/// </summary>
+	std::size_t					usersSent_{ 0 };
+
+	/// <summary>
+	/// Column buffers, reused across ticks.
+	/// </summary>
+	std::vector<std::uint64_t>	ticks_;
+	std::vector<std::int64_t>	timestamps_;
+	std::vector<std::uint32_t>	pids_;
+	std::vector<std::int32_t>	nameIndices_;
+	std::vector<std::uint8_t>	nameValidity_;
+	std::vector<std::int32_t>	userIndices_;
+	std::vector<std::uint8_t>	userValidity_;
+	std::vector<std::uint64_t>	workingSets_;
+	std::vector<std::uint64_t>	privates_;
+};
\ No newline at end of file
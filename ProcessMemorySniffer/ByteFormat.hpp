@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+/// <summary>
+/// The binary units a byte quantity can be shown in.
+/// </summary>
+enum class ByteUnit : std::uint8_t
+{
+	B,
+	KiB,
+	MiB,
+	GiB,
+	TiB,
+	PiB,
+	EiB
+};
+
+/// <summary>
+/// The most decimals a formatted quantity can have.
+/// </summary>
+constexpr unsigned MAX_BYTE_DECIMALS = 3;
+
+/// <summary>
+/// 10^decimals, indexed by the number of decimals.
+/// </summary>
+constexpr std::uint64_t BYTE_DECIMAL_SCALES[MAX_BYTE_DECIMALS + 1] = { 1, 10, 100, 1000 };
+
+/// <summary>
+/// The unit suffixes, indexed by ByteUnit.
+/// </summary>
+constexpr std::string_view BYTE_UNIT_SUFFIXES[] = { "B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB" };
+
+/// <summary>
+/// A formatted byte quantity such as "12.34 MiB", held inline so formatting never allocates.
+/// </summary>
+/// <typeparam name="CharT">char for byte-oriented output (OutputBuffer), wchar_t for the console renderers.</typeparam>
+template <typename CharT>
+struct BasicFormattedBytes
+{
+	/// <summary>
+	/// Room for a sign, 20 integer digits, the decimal point, the decimals, a space and a suffix.
+	/// </summary>
+	static constexpr std::size_t CAPACITY = 32;
+
+	/// <summary>
+	/// The characters, zero-terminated so text can be passed to printf-style functions.
+	/// </summary>
+	CharT		text[CAPACITY]{};
+
+	/// <summary>
+	/// The number of characters, excluding the terminator.
+	/// </summary>
+	std::size_t	length{ 0 };
+
+	[[nodiscard]] constexpr std::basic_string_view<CharT> view() const noexcept
+	{
+		return { text, length };
+	}
+};
+
+using FormattedBytes = BasicFormattedBytes<wchar_t>;
+
+/// <summary>
+/// Writes a formatted byte quantity to a stream; honors std::setw() and the adjustment flags like any string.
+/// </summary>
+template <typename CharT>
+std::basic_ostream<CharT>& operator<<(std::basic_ostream<CharT>& out, const BasicFormattedBytes<CharT>& bytes)
+{
+	return out << bytes.view();
+}
+
+/// <summary>
+/// Formats a byte quantity with integer arithmetic only: the value is split into its whole units and the remainder, and the
+/// remainder is scaled to the requested decimals with round-half-up. The output therefore does not depend on the platform,
+/// the floating point environment or the locale.
+/// </summary>
+/// <typeparam name="CharT">The character type.</typeparam>
+/// <param name="bytes">The quantity.</param>
+/// <param name="negative">Whether to prefix a minus sign.</param>
+/// <param name="unit">The unit to show the quantity in, or nullptr to pick the largest unit in which it is at least 1.</param>
+/// <param name="decimals">The number of decimals, at most MAX_BYTE_DECIMALS; quantities in bytes never have decimals.</param>
+/// <returns>The formatted quantity.</returns>
+template <typename CharT>
+[[nodiscard]] constexpr BasicFormattedBytes<CharT> formatByteQuantity(std::uint64_t bytes, bool negative, const ByteUnit* unit, unsigned decimals) noexcept
+{
+	constexpr unsigned LARGEST_UNIT = static_cast<unsigned>(ByteUnit::EiB);
+
+	unsigned index = unit != nullptr
+		? static_cast<unsigned>(*unit)
+		: std::min<unsigned>((static_cast<unsigned>(std::bit_width(bytes)) - (bytes != 0 ? 1 : 0)) / 10, LARGEST_UNIT);
+
+	decimals = index == 0 ? 0 : std::min(decimals, MAX_BYTE_DECIMALS);
+
+	const unsigned shift = 10 * index;
+	std::uint64_t whole = bytes >> shift;
+	std::uint64_t fraction = 0;
+
+	if (shift > 0)
+	{
+		// Keep at most 40 bits of remainder so scaling by up to 1000 cannot overflow; the dropped bits are far below the last decimal.
+		std::uint64_t remainder = bytes & ((std::uint64_t{ 1 } << shift) - 1);
+		unsigned bits = shift;
+
+		if (bits > 40)
+		{
+			remainder >>= bits - 40;
+			bits = 40;
+		}
+
+		const std::uint64_t scale = BYTE_DECIMAL_SCALES[decimals];
+		fraction = (remainder * scale + (std::uint64_t{ 1 } << (bits - 1))) >> bits;
+
+		if (fraction == scale)
+		{
+			fraction = 0;
+			whole++;
+		}
+	}
+
+	// Rounding up to 1024 of an automatically chosen unit is shown as 1 of the next unit instead.
+	if (unit == nullptr && whole == 1024 && fraction == 0 && index < LARGEST_UNIT)
+	{
+		index++;
+		whole = 1;
+	}
+
+	BasicFormattedBytes<CharT> result;
+	CharT* out = result.text;
+
+	if (negative)
+	{
+		*out++ = static_cast<CharT>('-');
+	}
+
+	CharT digits[20]{};
+	std::size_t count = 0;
+
+	do
+	{
+		digits[count++] = static_cast<CharT>('0' + whole % 10);
+		whole /= 10;
+	} while (whole != 0);
+
+	while (count > 0)
+	{
+		*out++ = digits[--count];
+	}
+
+	if (decimals > 0)
+	{
+		*out++ = static_cast<CharT>('.');
+
+		for (unsigned i = decimals; i > 0; i--)
+		{
+			out[i - 1] = static_cast<CharT>('0' + fraction % 10);
+			fraction /= 10;
+		}
+
+		out += decimals;
+	}
+
+	*out++ = static_cast<CharT>(' ');
+
+	for (const char c : BYTE_UNIT_SUFFIXES[index])
+	{
+		*out++ = static_cast<CharT>(c);
+	}
+
+	result.length = static_cast<std::size_t>(out - result.text);
+	return result;
+}
+
+/// <summary>
+/// Formats a byte quantity in the largest binary unit in which it is at least 1, e.g. "512 B", "1.50 KiB", "12.34 GiB".
+/// </summary>
+/// <param name="bytes">The quantity.</param>
+/// <param name="decimals">The number of decimals, at most MAX_BYTE_DECIMALS.</param>
+/// <returns>The formatted quantity.</returns>
+[[nodiscard]] constexpr FormattedBytes formatBytes(std::uint64_t bytes, unsigned decimals = 2) noexcept
+{
+	return formatByteQuantity<wchar_t>(bytes, false, nullptr, decimals);
+}
+
+/// <summary>
+/// Formats a byte quantity in a fixed unit, e.g. for a column that should stay comparable across rows.
+/// </summary>
+/// <param name="bytes">The quantity.</param>
+/// <param name="unit">The unit.</param>
+/// <param name="decimals">The number of decimals, at most MAX_BYTE_DECIMALS.</param>
+/// <returns>The formatted quantity.</returns>
+[[nodiscard]] constexpr FormattedBytes formatBytes(std::uint64_t bytes, ByteUnit unit, unsigned decimals = 2) noexcept
+{
+	return formatByteQuantity<wchar_t>(bytes, false, &unit, decimals);
+}
+
+/// <summary>
+/// Formats a signed byte difference in the largest binary unit in which its magnitude is at least 1, with an explicit sign ("+1.50 MiB", "-512 B", "0 B").
+/// </summary>
+/// <param name="bytes">The difference.</param>
+/// <param name="decimals">The number of decimals, at most MAX_BYTE_DECIMALS.</param>
+/// <returns>The formatted difference.</returns>
+[[nodiscard]] constexpr FormattedBytes formatByteDelta(std::int64_t bytes, unsigned decimals = 2) noexcept
+{
+	const std::uint64_t magnitude = bytes < 0 ? std::uint64_t{ 0 } - static_cast<std::uint64_t>(bytes) : static_cast<std::uint64_t>(bytes);
+	FormattedBytes result = formatByteQuantity<wchar_t>(magnitude, bytes < 0, nullptr, decimals);
+
+	if (bytes > 0)
+	{
+		for (std::size_t i = result.length; i > 0; i--)
+		{
+			result.text[i] = result.text[i - 1];
+		}
+
+		result.text[0] = L'+';
+		result.length++;
+	}
+
+	return result;
+}
+
+static_assert(formatBytes(1536).view() == L"1.50 KiB");
+static_assert(formatBytes(1023).view() == L"1023 B");
+static_assert(formatBytes(1024 * 1024 - 1).view() == L"1.00 MiB");
+static_assert(formatBytes(UINT64_MAX).view() == L"16.00 EiB");
+static_assert(formatBytes(5 * 1024 * 1024, ByteUnit::MiB, 0).view() == L"5 MiB");
+static_assert(formatByteDelta(-1024 * 1024).view() == L"-1.00 MiB");
\ No newline at end of file
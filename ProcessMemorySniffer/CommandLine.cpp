@@ -0,0 +1,314 @@
+#include <Windows.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cwchar>
+#include <cerrno>
+
+#include "CommandLine.hpp"
+
+/// <summary>
+/// Converts a wide string to a narrow string for use in exception messages. Non-ASCII characters are replaced with '?'.
+/// </summary>
+/// <param name="text">The wide string to convert.</param>
+/// <returns>The narrowed string.</returns>
+static std::string narrow(const std::wstring& text)
+{
+	std::string result;
+	result.reserve(text.size());
+
+	for (wchar_t c : text)
+	{
+		result.push_back(c < 0x80 ? static_cast<char>(c) : '?');
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Returns the value following an option, advancing the argument index. Throws std::invalid_argument if the option is the last argument.
+/// </summary>
+/// <param name="argc">The argument count.</param>
+/// <param name="argv">The argument vector.</param>
+/// <param name="i">Index of the option; advanced to the index of its value.</param>
+/// <returns>The value string.</returns>
+static std::wstring requireValue(int argc, wchar_t* argv[], int& i)
+{
+	if (i + 1 >= argc)
+	{
+		throw std::invalid_argument("Missing value for " + narrow(argv[i]) + ".");
+	}
+
+	return argv[++i];
+}
+
+/// <summary>
+/// Parses an unsigned decimal integer option value. Throws std::invalid_argument if the value is not a number or lies outside [minValue, maxValue].
+/// </summary>
+/// <param name="option">The option name, used in error messages.</param>
+/// <param name="value">The value string.</param>
+/// <param name="minValue">The smallest accepted value.</param>
+/// <param name="maxValue">The largest accepted value.</param>
+/// <returns>The parsed value.</returns>
+static unsigned long long parseNumber(const std::wstring& option, const std::wstring& value,
+	unsigned long long minValue, unsigned long long maxValue)
+{
+	wchar_t* end = nullptr;
+	errno = 0;
+	const unsigned long long parsed = std::wcstoull(value.c_str(), &end, 10);
+
+	if (value.empty() || value[0] == L'-' || *end != L'\0' || errno == ERANGE || parsed < minValue || parsed > maxValue)
+	{
+		throw std::invalid_argument("Invalid value '" + narrow(value) + "' for " + narrow(option) + ".");
+	}
+
+	return parsed;
+}
+
+/// <summary>
+/// Parses the program arguments into SnifferOptions. Throws std::invalid_argument on unknown options or malformed values.
+/// </summary>
+/// <param name="argc">The argument count, as passed to wmain.</param>
+/// <param name="argv">The argument vector, as passed to wmain. argv[0] is the program name and is skipped.</param>
+/// <returns>The parsed options; fields not mentioned on the command line keep their defaults.</returns>
+SnifferOptions parseCommandLine(int argc, wchar_t* argv[])
+{
+	SnifferOptions options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::wstring arg = argv[i];
+
+		if (arg == L"--help" || arg == L"-h" || arg == L"/?")
+		{
+			options.showHelp = true;
+		}
+		else if (arg == L"--top" || arg == L"-n")
+		{
+			options.topN = static_cast<std::size_t>(parseNumber(arg, requireValue(argc, argv, i), 1, 1'000'000));
+		}
+		else if (arg == L"--ticks")
+		{
+			options.ticks = static_cast<std::size_t>(parseNumber(arg, requireValue(argc, argv, i), 1, 1'000'000'000));
+		}
+		else if (arg == L"--interval")
+		{
+			options.intervalMs = static_cast<DWORD>(parseNumber(arg, requireValue(argc, argv, i), 0, 86'400'000));
+		}
+		else if (arg == L"--format")
+		{
+			const std::wstring value = requireValue(argc, argv, i);
+
+			if (value == L"table")
+			{
+				options.format = OutputFormat::Table;
+			}
+			else if (value == L"csv")
+			{
+				options.format = OutputFormat::Csv;
+			}
+			else if (value == L"ndjson")
+			{
+				options.format = OutputFormat::Ndjson;
+			}
+			else if (value == L"arrow")
+			{
+				options.format = OutputFormat::Arrow;
+			}
+			else
+			{
+				throw std::invalid_argument("Invalid value '" + narrow(value) + "' for --format.");
+			}
+		}
+		else if (arg == L"--columns")
+		{
+			const std::wstring value = requireValue(argc, argv, i);
+
+			if (value == L"default")
+			{
+				options.columns = ColumnPreset::Default;
+			}
+			else if (value == L"compact")
+			{
+				options.columns = ColumnPreset::Compact;
+			}
+			else if (value == L"memory")
+			{
+				options.columns = ColumnPreset::Memory;
+			}
+			else if (value == L"full")
+			{
+				options.columns = ColumnPreset::Full;
+			}
+			else if (value == L"cmdline")
+			{
+				options.columns = ColumnPreset::CommandLine;
+			}
+			else
+			{
+				throw std::invalid_argument("Invalid value '" + narrow(value) + "' for --columns.");
+			}
+		}
+		else if (arg == L"--cmdline-max")
+		{
+			options.commandLineMaxLength = static_cast<std::size_t>(parseNumber(arg, requireValue(argc, argv, i), 16, 32'767));
+		}
+		else if (arg == L"--regions")
+		{
+			options.showRegions = true;
+		}
+		else if (arg == L"--stats")
+		{
+			options.showStats = true;
+		}
+		else if (arg == L"--trace")
+		{
+			options.traceFile = requireValue(argc, argv, i);
+		}
+		else if (arg == L"--trace-slow")
+		{
+			options.traceSlowQueryUs = static_cast<std::uint32_t>(parseNumber(arg, requireValue(argc, argv, i), 0, 60'000'000));
+		}
+		else if (arg == L"--no-cache")
+		{
+			options.useMetadataCache = false;
+		}
+		else if (arg == L"--sample")
+		{
+			options.sampleSize = static_cast<std::size_t>(parseNumber(arg, requireValue(argc, argv, i), 1, 100'000'000));
+		}
+		else if (arg == L"--heavy-mb")
+		{
+			options.heavyThresholdMB = static_cast<std::size_t>(parseNumber(arg, requireValue(argc, argv, i), 1, 1'048'576));
+		}
+		else if (arg == L"--by-user")
+		{
+			options.byUser = true;
+		}
+		else if (arg == L"--system")
+		{
+			options.showSystem = true;
+		}
+		else if (arg == L"--summary")
+		{
+			options.summaryFile = requireValue(argc, argv, i);
+		}
+		else if (arg == L"--merge-sketch")
+		{
+			options.mergeFiles.push_back(requireValue(argc, argv, i));
+		}
+		else if (arg == L"--heavy-hitters")
+		{
+			options.heavyHitterCapacity = static_cast<std::size_t>(parseNumber(arg, requireValue(argc, argv, i), 1, 1'000'000));
+		}
+		else if (arg == L"--heavy-hitters-file")
+		{
+			options.heavyHitterFile = requireValue(argc, argv, i);
+		}
+		else if (arg == L"--merge-heavy-hitters")
+		{
+			options.heavyHitterMergeFiles.push_back(requireValue(argc, argv, i));
+		}
+		else if (arg == L"--tui")
+		{
+			options.liveView = true;
+		}
+		else if (arg == L"--modules")
+		{
+			options.showModules = true;
+		}
+		else if (arg == L"--loaded-by")
+		{
+			options.loadedBy = requireValue(argc, argv, i);
+		}
+		else if (arg == L"--threads")
+		{
+			options.threadsPid = static_cast<DWORD>(parseNumber(arg, requireValue(argc, argv, i), 1, 0xFFFFFFFF));
+		}
+		else
+		{
+			throw std::invalid_argument("Unknown option " + narrow(arg) + ".");
+		}
+	}
+
+	if (!options.mergeFiles.empty() && options.summaryFile.empty())
+	{
+		throw std::invalid_argument("--merge-sketch requires --summary.");
+	}
+
+	if (!options.heavyHitterFile.empty() && options.heavyHitterCapacity == 0)
+	{
+		throw std::invalid_argument("--heavy-hitters-file requires --heavy-hitters.");
+	}
+
+	if (!options.heavyHitterMergeFiles.empty() && options.heavyHitterFile.empty())
+	{
+		throw std::invalid_argument("--merge-heavy-hitters requires --heavy-hitters-file.");
+	}
+
+	if (options.threadsPid != 0 && (options.liveView || options.showModules || !options.loadedBy.empty()))
+	{
+		throw std::invalid_argument("--threads cannot be combined with --tui, --modules or --loaded-by.");
+	}
+
+	if (options.showStats && (options.liveView || options.showModules || !options.loadedBy.empty() || options.threadsPid != 0))
+	{
+		throw std::invalid_argument("--stats profiles the collection ticks and cannot be combined with --tui, --modules, --loaded-by or --threads.");
+	}
+
+	if (!options.traceFile.empty() && (options.liveView || options.showModules || !options.loadedBy.empty() || options.threadsPid != 0))
+	{
+		throw std::invalid_argument("--trace records the collection ticks and cannot be combined with --tui, --modules, --loaded-by or --threads.");
+	}
+
+	if (options.format != OutputFormat::Table
+		&& (options.showRegions || options.byUser || options.showSystem || options.heavyHitterCapacity > 0 || options.liveView
+			|| options.showModules || !options.loadedBy.empty() || options.threadsPid != 0 || options.columns != ColumnPreset::Default))
+	{
+		throw std::invalid_argument("--format csv/ndjson/arrow streams rows only and cannot be combined with report options.");
+	}
+
+	return options;
+}
+
+/// <summary>
+/// Prints the supported options to the wide output stream.
+/// </summary>
+void printUsage()
+{
+	std::wcout
+		<< L"Usage: ProcessMemorySniffer [options]\n\n"
+		<< L"  -n, --top <count>      Number of processes to print per tick (default 10).\n"
+		<< L"      --ticks <count>    Number of collection ticks to run (default 1).\n"
+		<< L"      --interval <ms>    Delay between ticks in milliseconds (default 1000).\n"
+		<< L"      --format <fmt>     table (default), or csv / ndjson / arrow (IPC stream) to stream every process to stdout each tick.\n"
+		<< L"      --columns <set>    Process table columns: default (pid, name, ws, private, user), compact (pid, name, ws),\n"
+		<< L"                         memory (adds ws delta, peak ws, kernel pool and true cost =\n"
+		<< L"                         private + kernel pool; no user), full, or cmdline (pid, name, ws, private,\n"
+		<< L"                         command line; read only for the printed processes).\n"
+		<< L"      --cmdline-max <chars> Longest command line shown; longer ones are cut and end with \"...\" (default 512).\n"
+		<< L"      --regions          Print region count, size/gap histograms and region churn for the printed processes.\n"
+		<< L"      --stats            Print CPU cycles, CPU time and page faults spent per collection phase to stderr at the end;\n"
+		<< L"                         Debug builds add allocation and system call counts per phase and per tick.\n"
+		<< L"      --trace <file>     Write the phases of each tick and slow per-process queries as Chrome trace-event JSON\n"
+		<< L"                         (open in ui.perfetto.dev or chrome://tracing).\n"
+		<< L"      --trace-slow <us>  With --trace, the duration from which a single query gets its own event (default 1000).\n"
+		<< L"      --no-cache         Resolve every process name and owner instead of reusing those of processes still running since\n"
+		<< L"                         the previous run (%LOCALAPPDATA%\\ProcessMemorySniffer\\metadata.cache), and do not update the cache.\n"
+		<< L"      --sample <count>   Approximate mode: query known heavy hitters plus <count> random PIDs per tick and estimate totals.\n"
+		<< L"      --heavy-mb <MiB>   Approximate mode: working set from which a process is queried every tick (default 256).\n"
+		<< L"      --by-user          Print memory totals per user after the process table.\n"
+		<< L"      --system           Print RAM in use, file cache and kernel pools after the process table, with the share of the\n"
+		<< L"                         top processes and the memory no process working set accounts for.\n"
+		<< L"      --summary <file>   Keep p50/p95/p99 working set sketches per process name in <file>, updated every tick.\n"
+		<< L"      --merge-sketch <file> Merge another run's or host's sketch file into the summary (repeatable).\n"
+		<< L"      --heavy-hitters <k> Track the executables with the most memory-seconds using <k> counters; print at the end.\n"
+		<< L"      --heavy-hitters-file <file> Accumulate the heavy hitters across runs in <file>, saved at the end.\n"
+		<< L"      --merge-heavy-hitters <file> Merge another run's or host's heavy hitter file into it (repeatable).\n"
+		<< L"      --tui              Interactive live view refreshed every --interval; sort and filter with keys.\n"
+		<< L"      --modules          Print the modules loaded by the most processes, with each path shared across processes.\n"
+		<< L"      --loaded-by <name> Print the processes that have a module loaded (file name such as ntdll.dll, or full path).\n"
+		<< L"      --threads <pid>    Print the stack of each thread of a process (top by committed size) and its heap-like allocations.\n"
+		<< L"  -h, --help             Print this help.\n";
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "ProcessMemorySniffer.hpp"
+
+[[nodiscard]] SnifferOptions parseCommandLine(int argc, wchar_t* argv[]);
+
+void printUsage();
\ No newline at end of file
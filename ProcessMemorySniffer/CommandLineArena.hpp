@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/// <summary>
+/// Stores each distinct command line once, packed into large shared blocks, and hands out views of the stored copies.
+/// Identical command lines are common (worker pools, services hosted by one executable), and a per-process std::wstring would
+/// cost an allocation and a full copy each; here a repeated command line costs nothing but the view of it.
+/// Stored text is never moved or freed, so views stay valid for the lifetime of the arena, including after a move of it.
+/// Not thread safe.
+/// </summary>
+class CommandLineArena
+{
+public:
+	/// <summary>
+	/// The size of a block in characters (64 KiB).
+	/// </summary>
+	static constexpr std::size_t BLOCK_UNITS = 32 * 1024;
+
+	/// <summary>
+	/// Returns the stored copy of a command line, storing it first if it has not been seen before.
+	/// </summary>
+	/// <param name="text">The command line.</param>
+	/// <returns>A view of the stored copy; an empty view for an empty command line.</returns>
+	std::wstring_view intern(std::wstring_view text)
+	{
+		if (text.empty())
+		{
+			return {};
+		}
+
+		if (const auto it = texts_.find(text); it != texts_.end())
+		{
+			return *it;
+		}
+
+		wchar_t* storage = allocate(text.size());
+		std::copy(text.begin(), text.end(), storage);
+
+		const std::wstring_view stored(storage, text.size());
+		texts_.insert(stored);
+		storedUnits_ += text.size();
+
+		return stored;
+	}
+
+	/// <summary>
+	/// Returns the number of distinct command lines stored.
+	/// </summary>
+	/// <returns>The number of command lines.</returns>
+	[[nodiscard]] std::size_t size() const noexcept
+	{
+		return texts_.size();
+	}
+
+	/// <summary>
+	/// Returns the number of characters stored, over all distinct command lines.
+	/// </summary>
+	/// <returns>The number of characters.</returns>
+	[[nodiscard]] std::size_t storedUnits() const noexcept
+	{
+		return storedUnits_;
+	}
+
+	/// <summary>
+	/// Estimates the memory held by the arena: the blocks, whether filled or not, plus the hash index over them.
+	/// </summary>
+	/// <returns>The estimate in bytes.</returns>
+	[[nodiscard]] std::size_t memoryBytes() const noexcept
+	{
+		// Each index node holds the view and a next pointer (and, with MSVC, a previous pointer); each bucket holds one pointer.
+		constexpr std::size_t NODE_BYTES = sizeof(std::wstring_view) + 2 * sizeof(void*);
+
+		return blockUnits_ * sizeof(wchar_t) + texts_.size() * NODE_BYTES + texts_.bucket_count() * sizeof(void*);
+	}
+
+private:
+	/// <summary>
+	/// Returns room for a command line: at the end of the current block, in a new block if it does not fit, or in a block
+	/// of its own if it is larger than a quarter block, so a few long command lines do not waste the rest of a block.
+	/// </summary>
+	/// <param name="units">The length in characters.</param>
+	/// <returns>The uninitialized room.</returns>
+	wchar_t* allocate(std::size_t units)
+	{
+		if (units > BLOCK_UNITS / 4)
+		{
+			return addBlock(units);
+		}
+
+		if (units > free_)
+		{
+			next_ = addBlock(BLOCK_UNITS);
+			free_ = BLOCK_UNITS;
+		}
+
+		wchar_t* storage = next_;
+		next_ += units;
+		free_ -= units;
+
+		return storage;
+	}
+
+	/// <summary>
+	/// Allocates a block.
+	/// </summary>
+	/// <param name="units">The size of the block in characters.</param>
+	/// <returns>The uninitialized block.</returns>
+	wchar_t* addBlock(std::size_t units)
+	{
+		blocks_.push_back(std::make_unique_for_overwrite<wchar_t[]>(units));
+		blockUnits_ += units;
+
+		return blocks_.back().get();
+	}
+
+	/// <summary>
+	/// The blocks, both shared and own ones.
+	/// </summary>
+	std::vector<std::unique_ptr<wchar_t[]>>	blocks_;
+
+	/// <summary>
+	/// The first unused character of the shared block being filled.
+	/// </summary>
+	wchar_t*								next_{ nullptr };
+
+	/// <summary>
+	/// The unused characters of the shared block being filled.
+	/// </summary>
+	std::size_t								free_{ 0 };
+
+	/// <summary>
+	/// The total size of the blocks in characters.
+	/// </summary>
+	std::size_t								blockUnits_{ 0 };
+
+	/// <summary>
+	/// The total length of the stored command lines in characters.
+	/// </summary>
+	std::size_t								storedUnits_{ 0 };
+
+	/// <summary>
+	/// Views of the stored command lines, hashed by content.
+	/// </summary>
+	std::unordered_set<std::wstring_view>	texts_;
+};
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <Windows.h>
+#include <winternl.h>
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include "CommandLineStore.hpp"
+#include "ProcessHandle.hpp"
+#include "ResourceCounters.hpp"
+
+#pragma comment(lib, "ntdll.lib")
+
+/// <summary>
+/// The information class returning a process' command line as a UNICODE_STRING (Windows 8.1 and later); not named in winternl.h.
+/// </summary>
+constexpr auto PROCESS_COMMAND_LINE_INFORMATION = static_cast<PROCESSINFOCLASS>(60);
+
+/// <summary>
+/// The status NtQueryInformationProcess returns when the buffer is too small.
+/// </summary>
+constexpr NTSTATUS STATUS_INFO_LENGTH_MISMATCH_VALUE = static_cast<NTSTATUS>(0xC0000004L);
+
+/// <summary>
+/// The buffer size tried first, enough for the command lines of most processes.
+/// </summary>
+constexpr std::size_t INITIAL_BUFFER_BYTES = 4096;
+
+/// <summary>
+/// The shortest truncation length accepted, which leaves room for the "..." marker.
+/// </summary>
+constexpr std::size_t MIN_MAX_LENGTH = 4;
+
+/// <summary>
+/// Constructs an empty store.
+/// </summary>
+/// <param name="maxLength">The longest command line kept, in characters; longer ones are cut and end with "...". At least 4.</param>
+CommandLineStore::CommandLineStore(std::size_t maxLength)
+	: maxLength_(maxLength < MIN_MAX_LENGTH ? MIN_MAX_LENGTH : maxLength), buffer_(INITIAL_BUFFER_BYTES)
+{ }
+
+/// <summary>
+/// Returns the command line of a process, reading it on the first request. A process whose command line cannot be read
+/// (access denied, exited, or a PID reused since the key was taken) is remembered as such and not tried again.
+/// </summary>
+/// <param name="key">The process.</param>
+/// <returns>The command line, possibly truncated; empty if it could not be read. Valid until the process is dropped by retain().</returns>
+std::wstring_view CommandLineStore::get(const ProcessKey& key)
+{
+	if (const auto it = byProcess_.find(key); it != byProcess_.end())
+	{
+		return it->second;
+	}
+
+	std::wstring_view commandLine;
+
+	if (auto handleOpt = ProcessHandle::open(key))
+	{
+		commandLine = read(handleOpt->get());
+	}
+
+	byProcess_.emplace(key, commandLine);
+	return commandLine;
+}
+
+/// <summary>
+/// Reads the command line of a process with NtQueryInformationProcess, which copies it from the process parameters in one
+/// call instead of walking the PEB with ReadProcessMemory, and stores it truncated.
+/// </summary>
+/// <param name="process">The process; needs PROCESS_QUERY_LIMITED_INFORMATION access.</param>
+/// <returns>The stored command line; empty if it could not be read.</returns>
+std::wstring_view CommandLineStore::read(HANDLE process)
+{
+	ULONG length = 0;
+
+	countSystemCall();
+	NTSTATUS status = ::NtQueryInformationProcess(process, PROCESS_COMMAND_LINE_INFORMATION, buffer_.data(), static_cast<ULONG>(buffer_.size()), &length);
+
+	if (status == STATUS_INFO_LENGTH_MISMATCH_VALUE && length > buffer_.size())
+	{
+		buffer_.resize(length);
+
+		countSystemCall();
+		status = ::NtQueryInformationProcess(process, PROCESS_COMMAND_LINE_INFORMATION, buffer_.data(), static_cast<ULONG>(buffer_.size()), &length);
+	}
+
+	if (status < 0)
+	{
+		return {};
+	}
+
+	const auto* text = reinterpret_cast<const UNICODE_STRING*>(buffer_.data());
+	const std::wstring_view commandLine(text->Buffer, text->Length / sizeof(wchar_t));
+
+	if (commandLine.size() <= maxLength_)
+	{
+		return arena_.intern(commandLine);
+	}
+
+	// Truncated before interning, so command lines differing only past the limit share one copy.
+	std::wstring truncated(commandLine.substr(0, maxLength_ - 3));
+	truncated += L"...";
+
+	return arena_.intern(truncated);
+}
+
+/// <summary>
+/// Drops the command lines of processes that are no longer running. The arena only grows, so once most of its text belongs to
+/// exited processes, the command lines still in use are copied to a fresh arena and the old one is released; memory therefore
+/// stays proportional to the running processes rather than to every process seen during a long run.
+/// </summary>
+/// <param name="processes">The processes collected on the current tick.</param>
+void CommandLineStore::retain(const std::vector<ProcessInfo>& processes)
+{
+	if (byProcess_.empty())
+	{
+		return;
+	}
+
+	std::unordered_set<ProcessKey, ProcessKeyHash> running;
+	running.reserve(processes.size());
+
+	for (const auto& p : processes)
+	{
+		running.insert(p.key());
+	}
+
+	std::erase_if(byProcess_, [&running](const auto& entry) { return !running.contains(entry.first); });
+
+	std::unordered_set<const wchar_t*> live;
+	std::size_t liveUnits = 0;
+
+	for (const auto& [key, commandLine] : byProcess_)
+	{
+		if (!commandLine.empty() && live.insert(commandLine.data()).second)
+		{
+			liveUnits += commandLine.size();
+		}
+	}
+
+	if (arena_.storedUnits() <= 2 * liveUnits + CommandLineArena::BLOCK_UNITS)
+	{
+		return;
+	}
+
+	CommandLineArena compacted;
+
+	for (auto& [key, commandLine] : byProcess_)
+	{
+		commandLine = compacted.intern(commandLine);
+	}
+
+	arena_ = std::move(compacted);
+}
+
+/// <summary>
+/// Estimates the memory held by the store: the arena plus the per-process index.
+/// </summary>
+/// <returns>The estimate in bytes.</returns>
+std::size_t CommandLineStore::memoryBytes() const noexcept
+{
+	constexpr std::size_t NODE_BYTES = sizeof(std::pair<const ProcessKey, std::wstring_view>) + 2 * sizeof(void*);
+
+	return arena_.memoryBytes() + byProcess_.size() * NODE_BYTES + byProcess_.bucket_count() * sizeof(void*) + buffer_.capacity();
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "CommandLineArena.hpp"
+#include "ProcessInfo.hpp"
+#include "ProcessKey.hpp"
+
+/// <summary>
+/// Reads process command lines on demand and keeps them for as long as the process runs. Reading a command line costs a
+/// handle and a system call per process, so nothing is read up front: only the processes a caller asks for (the printed rows)
+/// are read, each once, and the text lives in a CommandLineArena shared by all processes with the same command line.
+/// </summary>
+class CommandLineStore
+{
+public:
+	explicit CommandLineStore(std::size_t maxLength);
+
+	[[nodiscard]] std::wstring_view get(const ProcessKey& key);
+
+	void retain(const std::vector<ProcessInfo>& processes);
+
+	/// <summary>
+	/// Returns the number of processes whose command line has been read and is still kept.
+	/// </summary>
+	/// <returns>The number of processes.</returns>
+	[[nodiscard]] std::size_t size() const noexcept
+	{
+		return byProcess_.size();
+	}
+
+	[[nodiscard]] std::size_t memoryBytes() const noexcept;
+
+private:
+	[[nodiscard]] std::wstring_view read(HANDLE process);
+
+	/// <summary>
+	/// The longest command line kept, in characters, including the "..." marking a truncated one.
+	/// </summary>
+	std::size_t		maxLength_;
+
+	/// <summary>
+	/// The stored command lines.
+	/// </summary>
+	CommandLineArena	arena_;
+
+	/// <summary>
+	/// The command line of each process read so far; an empty view if it could not be read.
+	/// </summary>
+	std::unordered_map<ProcessKey, std::wstring_view, ProcessKeyHash>	byProcess_;
+
+	/// <summary>
+	/// Receives the command line from the system; reused across reads.
+	/// </summary>
+	std::vector<BYTE>	buffer_;
+};
\ No newline at end of file
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Minimal FlatBuffers builder, sufficient to encode Arrow IPC metadata (Message, Schema, RecordBatch, DictionaryBatch).
+/// Like the reference implementation it builds back to front, so children are always written before the tables that refer to them
+/// and every unsigned offset points forward. Offsets returned by the builder are distances from the end of the buffer.
+/// Metadata messages are a few hundred bytes, so bytes are simply prepended to a vector.
+/// </summary>
+class FlatBufferBuilder
+{
+public:
+	/// <summary>
+	/// Reference to a finished object: its distance from the end of the buffer.
+	/// </summary>
+	using Offset = std::uint32_t;
+
+	/// <summary>
+	/// Writes a string (length-prefixed and zero-terminated).
+	/// </summary>
+	/// <param name="text">The UTF-8 text.</param>
+	/// <returns>The offset of the string.</returns>
+	Offset createString(std::string_view text)
+	{
+		preAlign(text.size() + 1, 4);
+		prependBytes("\0", 1);
+		prependBytes(text.data(), text.size());
+		prependScalar(static_cast<std::uint32_t>(text.size()));
+		return size();
+	}
+
+	/// <summary>
+	/// Writes a vector of structs or scalars stored contiguously in memory.
+	/// </summary>
+	/// <param name="data">The elements.</param>
+	/// <param name="elementSize">The size of one element in bytes.</param>
+	/// <param name="count">The number of elements.</param>
+	/// <param name="alignment">The alignment the elements require.</param>
+	/// <returns>The offset of the vector.</returns>
+	Offset createVector(const void* data, std::size_t elementSize, std::size_t count, std::size_t alignment)
+	{
+		const std::size_t bytes = elementSize * count;
+		preAlign(bytes, 4);
+		preAlign(bytes, alignment);
+		prependBytes(data, bytes);
+		prependScalar(static_cast<std::uint32_t>(count));
+		return size();
+	}
+
+	/// <summary>
+	/// Writes a vector of offsets to tables.
+	/// </summary>
+	/// <param name="offsets">The table offsets, in element order.</param>
+	/// <returns>The offset of the vector.</returns>
+	Offset createOffsetVector(const std::vector<Offset>& offsets)
+	{
+		preAlign(offsets.size() * 4, 4);
+
+		for (auto it = offsets.rbegin(); it != offsets.rend(); ++it)
+		{
+			prependOffset(*it);
+		}
+
+		prependScalar(static_cast<std::uint32_t>(offsets.size()));
+		return size();
+	}
+
+	/// <summary>
+	/// Starts a table. Fields are added with addScalar() / addOffset() and the table is finished with endTable().
+	/// </summary>
+	void startTable()
+	{
+		fields_.clear();
+		tableStart_ = size();
+	}
+
+	/// <summary>
+	/// Adds a scalar field to the current table.
+	/// </summary>
+	/// <param name="id">The field id (its position in the schema definition).</param>
+	/// <param name="value">The value.</param>
+	template <typename T>
+	void addScalar(std::uint16_t id, T value)
+	{
+		prependScalar(value);
+		fields_.emplace_back(id, size());
+	}
+
+	/// <summary>
+	/// Adds a field referring to a string, vector or table to the current table.
+	/// </summary>
+	/// <param name="id">The field id.</param>
+	/// <param name="target">The offset of the referenced object.</param>
+	void addOffset(std::uint16_t id, Offset target)
+	{
+		prependOffset(target);
+		fields_.emplace_back(id, size());
+	}
+
+	/// <summary>
+	/// Finishes the current table by writing its vtable.
+	/// </summary>
+	/// <returns>The offset of the table.</returns>
+	Offset endTable()
+	{
+		prependScalar(std::int32_t{ 0 });
+		const Offset table = size();
+
+		std::uint16_t fieldCount = 0;
+
+		for (const auto& field : fields_)
+		{
+			fieldCount = std::max<std::uint16_t>(fieldCount, static_cast<std::uint16_t>(field.first + 1));
+		}
+
+		std::vector<std::uint16_t> slots(fieldCount, 0);
+
+		for (const auto& [id, offset] : fields_)
+		{
+			slots[id] = static_cast<std::uint16_t>(table - offset);
+		}
+
+		for (auto it = slots.rbegin(); it != slots.rend(); ++it)
+		{
+			prependScalar(*it);
+		}
+
+		prependScalar(static_cast<std::uint16_t>(table - tableStart_));
+		prependScalar(static_cast<std::uint16_t>((2 + fieldCount) * 2));
+
+		const Offset vtable = size();
+
+		// The table's first word is the signed distance from the table back to its vtable.
+		const auto soffset = static_cast<std::int32_t>(vtable - table);
+		std::memcpy(bytes_.data() + (size() - table), &soffset, sizeof(soffset));
+
+		return table;
+	}
+
+	/// <summary>
+	/// Writes the root offset and returns the finished buffer.
+	/// </summary>
+	/// <param name="root">The offset of the root table.</param>
+	/// <returns>The encoded FlatBuffer.</returns>
+	std::vector<std::uint8_t> finish(Offset root)
+	{
+		preAlign(4, minAlign_);
+		prependOffset(root);
+		return std::move(bytes_);
+	}
+
+private:
+	/// <summary>
+	/// Returns the current size of the buffer.
+	/// </summary>
+	[[nodiscard]] Offset size() const noexcept
+	{
+		return static_cast<Offset>(bytes_.size());
+	}
+
+	/// <summary>
+	/// Pads so that after prepending length more bytes the buffer size is a multiple of alignment.
+	/// </summary>
+	void preAlign(std::size_t length, std::size_t alignment)
+	{
+		minAlign_ = std::max(minAlign_, alignment);
+		const std::size_t padding = (alignment - ((bytes_.size() + length) % alignment)) % alignment;
+		bytes_.insert(bytes_.begin(), padding, 0);
+	}
+
+	/// <summary>
+	/// Prepends raw bytes.
+	/// </summary>
+	void prependBytes(const void* data, std::size_t length)
+	{
+		const auto* p = static_cast<const std::uint8_t*>(data);
+		bytes_.insert(bytes_.begin(), p, p + length);
+	}
+
+	/// <summary>
+	/// Prepends an aligned little-endian scalar.
+	/// </summary>
+	template <typename T>
+	void prependScalar(T value)
+	{
+		preAlign(sizeof(T), sizeof(T));
+		prependBytes(&value, sizeof(T));
+	}
+
+	/// <summary>
+	/// Prepends an unsigned offset to target, relative to the offset's own position.
+	/// </summary>
+	void prependOffset(Offset target)
+	{
+		preAlign(4, 4);
+		prependScalar(static_cast<std::uint32_t>(size() + 4 - target));
+	}
+
+	/// <summary>
+	/// The buffer, front is the start.
+	/// </summary>
+	std::vector<std::uint8_t>							bytes_;
+
+	/// <summary>
+	/// Fields of the table being built: (field id, offset of the field).
+	/// </summary>
+	std::vector<std::pair<std::uint16_t, Offset>>	fields_;
+
+	/// <summary>
+	/// Buffer size when the current table was started.
+	/// </summary>
+	Offset												tableStart_{ 0 };
+
+	/// <summary>
+	/// The largest alignment requested so far; the finished buffer size is a multiple of it.
+	/// </summary>
+	std::size_t											minAlign_{ 1 };
+};
\ No newline at end of file
@@ -0,0 +1,303 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+#include "HeavyHitters.hpp"
+#include "TextEncoding.hpp"
+
+/// <summary>
+/// First line of a heavy hitter file.
+/// </summary>
+constexpr const char* HEAVY_HITTER_FILE_HEADER = "# ProcessMemorySniffer heavy hitters v1";
+
+/// <summary>
+/// Appends a weight in the shortest form that parses back to the same value.
+/// </summary>
+/// <param name="out">The string to append to.</param>
+/// <param name="value">The weight.</param>
+static void appendWeight(std::string& out, double value)
+{
+	char digits[32];
+	const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, result.ptr);
+}
+
+/// <summary>
+/// Parses a non-negative weight that makes up the whole text.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <param name="value">Receives the weight.</param>
+/// <returns>true if text is a finite, non-negative number.</returns>
+static bool parseWeight(std::string_view text, double& value)
+{
+	const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return ec == std::errc{} && end == text.data() + text.size() && value >= 0.0 && value <= std::numeric_limits<double>::max();
+}
+
+/// <summary>
+/// Constructs an empty summary.
+/// </summary>
+/// <param name="capacity">The number of counters; memory use is fixed by it. Must be at least 1.</param>
+HeavyHitters::HeavyHitters(std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1))
+{
+	counters_.reserve(capacity_);
+	index_.reserve(capacity_);
+}
+
+/// <summary>
+/// Adds weight to a key. A monitored key's counter grows; an unmonitored key takes a free counter, or replaces the minimum one when all are taken.
+/// The minimum is found by a linear scan, which for the few hundred counters this is used with is cheaper than maintaining a heap.
+/// </summary>
+/// <param name="key">The key, e.g. an executable name.</param>
+/// <param name="weight">The non-negative weight to add, e.g. working set bytes times seconds.</param>
+void HeavyHitters::add(const std::wstring& key, double weight)
+{
+	totalWeight_ += weight;
+
+	if (const auto it = index_.find(key); it != index_.end())
+	{
+		counters_[it->second].weight += weight;
+		return;
+	}
+
+	if (counters_.size() < capacity_)
+	{
+		index_.emplace(key, counters_.size());
+		counters_.push_back({ key, weight, 0.0 });
+		return;
+	}
+
+	const auto minIt = std::min_element(counters_.begin(), counters_.end(),
+		[](const HeavyHitter& a, const HeavyHitter& b)
+		{
+			return a.weight < b.weight;
+		});
+
+	const auto slot = static_cast<std::size_t>(minIt - counters_.begin());
+
+	index_.erase(minIt->key);
+	index_.emplace(key, slot);
+
+	minIt->key = key;
+	minIt->error = minIt->weight;
+	minIt->weight += weight;
+}
+
+/// <summary>
+/// Merges another summary into this one. A key monitored by both adds up both counters. A key missing from one summary may still
+/// have weight there, up to that summary's smallest counter if it is full (floorWeight()); that bound is added to the estimate and
+/// its error, so every estimate stays at or above the true weight. If more keys than counters remain, the lightest are dropped.
+/// </summary>
+/// <param name="other">The summary to merge, e.g. one loaded from an earlier run or another host. Its capacity may differ.</param>
+void HeavyHitters::merge(const HeavyHitters& other)
+{
+	const double ownFloor = floorWeight();
+	const double otherFloor = other.floorWeight();
+
+	std::vector<HeavyHitter> merged;
+	merged.reserve(counters_.size() + other.counters_.size());
+
+	for (const auto& counter : counters_)
+	{
+		if (const auto it = other.index_.find(counter.key); it != other.index_.end())
+		{
+			const HeavyHitter& match = other.counters_[it->second];
+			merged.push_back({ counter.key, counter.weight + match.weight, counter.error + match.error });
+		}
+		else
+		{
+			merged.push_back({ counter.key, counter.weight + otherFloor, counter.error + otherFloor });
+		}
+	}
+
+	for (const auto& counter : other.counters_)
+	{
+		if (!index_.contains(counter.key))
+		{
+			merged.push_back({ counter.key, counter.weight + ownFloor, counter.error + ownFloor });
+		}
+	}
+
+	if (merged.size() > capacity_)
+	{
+		std::nth_element(merged.begin(), merged.begin() + static_cast<std::ptrdiff_t>(capacity_), merged.end(),
+			[](const HeavyHitter& a, const HeavyHitter& b)
+			{
+				return a.weight > b.weight;
+			});
+
+		merged.resize(capacity_);
+	}
+
+	counters_ = std::move(merged);
+	index_.clear();
+
+	for (std::size_t i = 0; i < counters_.size(); i++)
+	{
+		index_.emplace(counters_[i].key, i);
+	}
+
+	totalWeight_ += other.totalWeight_;
+}
+
+/// <summary>
+/// Returns the most weight a key the summary does not monitor can have accumulated: the smallest counter once every counter is
+/// taken, since only then can keys have been evicted, and zero before.
+/// </summary>
+/// <returns>The bound.</returns>
+double HeavyHitters::floorWeight() const noexcept
+{
+	if (counters_.size() < capacity_)
+	{
+		return 0.0;
+	}
+
+	return std::min_element(counters_.begin(), counters_.end(),
+		[](const HeavyHitter& a, const HeavyHitter& b)
+		{
+			return a.weight < b.weight;
+		})->weight;
+}
+
+/// <summary>
+/// Returns the monitored keys with the largest estimated weight.
+/// </summary>
+/// <param name="count">Maximum number of keys to return.</param>
+/// <returns>Up to count counters, sorted by descending weight.</returns>
+std::vector<HeavyHitter> HeavyHitters::top(std::size_t count) const
+{
+	std::vector<HeavyHitter> result(std::min(count, counters_.size()));
+
+	std::partial_sort_copy(counters_.begin(), counters_.end(), result.begin(), result.end(),
+		[](const HeavyHitter& a, const HeavyHitter& b)
+		{
+			return a.weight > b.weight;
+		});
+
+	return result;
+}
+
+/// <summary>
+/// Loads a summary from a heavy hitter file. A missing file yields an empty summary so that the first run starts from scratch.
+/// The line after the header is "capacity<TAB>total weight"; each further line is "key<TAB>weight<TAB>error" with the key UTF-8
+/// encoded. Throws std::runtime_error if the file exists but is malformed.
+/// </summary>
+/// <param name="path">The file to load.</param>
+/// <returns>The loaded summary, with the capacity it was saved with.</returns>
+HeavyHitters HeavyHitters::load(const std::wstring& path)
+{
+	std::ifstream in(std::filesystem::path(path), std::ios::binary);
+
+	if (!in)
+	{
+		return HeavyHitters(1);
+	}
+
+	std::string line;
+
+	if (!std::getline(in, line) || line != HEAVY_HITTER_FILE_HEADER)
+	{
+		throw std::runtime_error("Not a heavy hitter file or unsupported format: " + toUtf8(path));
+	}
+
+	const auto malformed = [&path](std::size_t lineNumber)
+		{
+			return std::runtime_error("Malformed heavy hitter on line " + std::to_string(lineNumber) + " of " + toUtf8(path));
+		};
+
+	std::size_t capacity = 0;
+	double total = 0.0;
+
+	if (!std::getline(in, line))
+	{
+		throw malformed(2);
+	}
+
+	const std::string_view totals(line);
+	const auto totalsTab = totals.find('\t');
+	const auto [capacityEnd, capacityError] = std::from_chars(totals.data(), totals.data() + totals.size(), capacity);
+
+	if (totalsTab == std::string_view::npos || capacityError != std::errc{} || capacityEnd != totals.data() + totalsTab
+		|| capacity == 0 || !parseWeight(totals.substr(totalsTab + 1), total))
+	{
+		throw malformed(2);
+	}
+
+	HeavyHitters hitters(capacity);
+	hitters.totalWeight_ = total;
+	std::size_t lineNumber = 2;
+
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+
+		if (line.empty())
+		{
+			continue;
+		}
+
+		const std::string_view record(line);
+		const auto first = record.find('\t');
+		const auto second = first == std::string_view::npos ? first : record.find('\t', first + 1);
+		HeavyHitter hitter;
+
+		if (second == std::string_view::npos
+			|| !parseWeight(record.substr(first + 1, second - first - 1), hitter.weight)
+			|| !parseWeight(record.substr(second + 1), hitter.error)
+			|| hitter.error > hitter.weight
+			|| hitters.counters_.size() == hitters.capacity_)
+		{
+			throw malformed(lineNumber);
+		}
+
+		hitter.key = fromUtf8(record.substr(0, first));
+
+		if (!hitters.index_.emplace(hitter.key, hitters.counters_.size()).second)
+		{
+			throw malformed(lineNumber);
+		}
+
+		hitters.counters_.push_back(std::move(hitter));
+	}
+
+	return hitters;
+}
+
+/// <summary>
+/// Writes the summary to a heavy hitter file, replacing it. Throws std::runtime_error if the file cannot be written.
+/// </summary>
+/// <param name="path">The file to write.</param>
+void HeavyHitters::save(const std::wstring& path) const
+{
+	std::string text = HEAVY_HITTER_FILE_HEADER;
+	text += '\n';
+	text += std::to_string(capacity_);
+	text += '\t';
+	appendWeight(text, totalWeight_);
+	text += '\n';
+
+	for (const auto& counter : counters_)
+	{
+		text += toUtf8(counter.key);
+		text += '\t';
+		appendWeight(text, counter.weight);
+		text += '\t';
+		appendWeight(text, counter.error);
+		text += '\n';
+	}
+
+	std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+	out.write(text.data(), static_cast<std::streamsize>(text.size()));
+
+	if (!out)
+	{
+		throw std::runtime_error("Failed to write heavy hitter file: " + toUtf8(path));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// One monitored key of a HeavyHitters summary.
+/// </summary>
+struct HeavyHitter
+{
+	/// <summary>
+	/// The key, e.g. an executable name.
+	/// </summary>
+	std::wstring	key;
+
+	/// <summary>
+	/// The estimated accumulated weight. Never below the true weight.
+	/// </summary>
+	double			weight{ 0.0 };
+
+	/// <summary>
+	/// Upper bound of the overestimation: the true weight lies in [weight - error, weight].
+	/// </summary>
+	double			error{ 0.0 };
+};
+
+/// <summary>
+/// Weighted Space-Saving summary tracking which keys accumulate the most weight over an unbounded stream using a fixed number of counters.
+/// When a new key arrives and every counter is taken, the counter with the smallest weight is reassigned to it and keeps that weight
+/// as its error bound. Any key whose true weight exceeds total / capacity is guaranteed to be monitored, no matter how many distinct
+/// keys (churned PIDs, ephemeral jobs) pass through. Summaries can be saved, loaded and merged, so the accumulation carries over
+/// runs and hosts like the quantile sketches of SketchStore.
+/// </summary>
+class HeavyHitters
+{
+public:
+	explicit HeavyHitters(std::size_t capacity);
+
+	void add(const std::wstring& key, double weight);
+
+	void merge(const HeavyHitters& other);
+
+	[[nodiscard]] std::vector<HeavyHitter> top(std::size_t count) const;
+
+	[[nodiscard]] static HeavyHitters load(const std::wstring& path);
+
+	void save(const std::wstring& path) const;
+
+	/// <summary>
+	/// Returns the total weight added.
+	/// </summary>
+	/// <returns>The sum of every weight passed to add().</returns>
+	[[nodiscard]] double totalWeight() const noexcept
+	{
+		return totalWeight_;
+	}
+
+private:
+	[[nodiscard]] double floorWeight() const noexcept;
+
+	/// <summary>
+	/// The maximum number of counters.
+	/// </summary>
+	std::size_t										capacity_;
+
+	/// <summary>
+	/// The counters.
+	/// </summary>
+	std::vector<HeavyHitter>						counters_;
+
+	/// <summary>
+	/// Maps each monitored key to its index in counters_.
+	/// </summary>
+	std::unordered_map<std::wstring, std::size_t>	index_;
+
+	/// <summary>
+	/// The sum of every weight added.
+	/// </summary>
+	double											totalWeight_{ 0.0 };
+};
\ No newline at end of file
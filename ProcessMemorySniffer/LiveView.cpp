@@ -0,0 +1,414 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cwctype>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "LiveView.hpp"
+#include "ByteFormat.hpp"
+#include "TableColumns.hpp"
+#include "TerminalScreen.hpp"
+#include "StringInterner.hpp"
+#include "NameSearchIndex.hpp"
+
+/// <summary>
+/// Number of screen rows above the process rows: the status line and the column header.
+/// </summary>
+constexpr int HEADER_ROWS = 2;
+
+/// <summary>
+/// The column the live view sorts by.
+/// </summary>
+enum class SortKey
+{
+	WorkingSet,
+	Private,
+	Name,
+	Pid
+};
+
+/// <summary>
+/// Returns a short label for a sort key, shown in the status line.
+/// </summary>
+/// <param name="key">The sort key.</param>
+/// <returns>The label.</returns>
+static const wchar_t* sortLabel(SortKey key) noexcept
+{
+	switch (key)
+	{
+	case SortKey::Private:
+		return L"private";
+	case SortKey::Name:
+		return L"name";
+	case SortKey::Pid:
+		return L"pid";
+	default:
+		return L"working set";
+	}
+}
+
+/// <summary>
+/// State of the interactive live view: the latest snapshot, the user's sort, filter and scroll position, and the display order.
+/// The display order is rebuilt only when the snapshot, sort or filter changes; drawing formats just the rows inside the window,
+/// so browsing a snapshot of 100k processes never materializes the full table. Process names are interned and indexed by
+/// NameSearchIndex, so each filter keystroke is answered per distinct name instead of by rescanning every process name.
+/// </summary>
+class LiveView
+{
+public:
+	LiveView(const ProcessQueryService& service, AccountNameCache& accounts)
+		: service_(service), accounts_(accounts)
+	{ }
+
+	/// <summary>
+	/// Replaces the snapshot with a fresh collection and indexes any names not seen before.
+	/// </summary>
+	void refresh()
+	{
+		processes_ = service_.collectProcesses();
+
+		nameIds_.resize(processes_.size());
+
+		for (std::size_t i = 0; i < processes_.size(); i++)
+		{
+			nameIds_[i] = names_.intern(processes_[i].name);
+		}
+
+		index_.update(names_);
+		applyFilter();
+	}
+
+	/// <summary>
+	/// Handles a key press.
+	/// </summary>
+	/// <param name="key">The key event.</param>
+	/// <param name="pageRows">The number of process rows visible, used for page-wise scrolling.</param>
+	/// <returns>false if the user asked to quit; true otherwise.</returns>
+	bool handleKey(const KEY_EVENT_RECORD& key, std::size_t pageRows)
+	{
+		const wchar_t ch = key.uChar.UnicodeChar;
+
+		switch (key.wVirtualKeyCode)
+		{
+		case VK_UP:
+			moveSelection(-1);
+			return true;
+		case VK_DOWN:
+			moveSelection(1);
+			return true;
+		case VK_PRIOR:
+			moveSelection(-static_cast<std::ptrdiff_t>(pageRows));
+			return true;
+		case VK_NEXT:
+			moveSelection(static_cast<std::ptrdiff_t>(pageRows));
+			return true;
+		case VK_HOME:
+			selected_ = 0;
+			return true;
+		case VK_END:
+			selected_ = rows_.empty() ? 0 : rows_.size() - 1;
+			return true;
+		default:
+			break;
+		}
+
+		if (editingFilter_)
+		{
+			if (key.wVirtualKeyCode == VK_RETURN)
+			{
+				editingFilter_ = false;
+			}
+			else if (key.wVirtualKeyCode == VK_ESCAPE)
+			{
+				editingFilter_ = false;
+				setFilter({});
+			}
+			else if (key.wVirtualKeyCode == VK_BACK)
+			{
+				if (!filter_.empty())
+				{
+					setFilter(filter_.substr(0, filter_.size() - 1));
+				}
+			}
+			else if (ch >= L' ')
+			{
+				setFilter(filter_ + NameSearchIndex::toLower(std::wstring_view(&ch, 1)));
+			}
+
+			return true;
+		}
+
+		switch (ch)
+		{
+		case L'q':
+		case L'Q':
+			return false;
+		case L'w':
+			setSort(SortKey::WorkingSet);
+			break;
+		case L'p':
+			setSort(SortKey::Private);
+			break;
+		case L'n':
+			setSort(SortKey::Name);
+			break;
+		case L'i':
+			setSort(SortKey::Pid);
+			break;
+		case L'r':
+			descending_ = !descending_;
+			sortRows();
+			break;
+		case L'/':
+			editingFilter_ = true;
+			break;
+		default:
+			if (key.wVirtualKeyCode == VK_ESCAPE)
+			{
+				setFilter({});
+			}
+			break;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Draws the status line, the column header and the rows inside the scroll window. Only those rows are formatted.
+	/// </summary>
+	/// <param name="screen">The screen to draw into; beginFrame() must have been called.</param>
+	void render(TerminalScreen& screen)
+	{
+		const std::size_t capacity = static_cast<std::size_t>(std::max(0, screen.height() - HEADER_ROWS));
+
+		// Keep the selection inside the window.
+		if (selected_ < scroll_)
+		{
+			scroll_ = selected_;
+		}
+		else if (capacity > 0 && selected_ >= scroll_ + capacity)
+		{
+			scroll_ = selected_ - capacity + 1;
+		}
+
+		// Built with std::format rather than into a fixed buffer: the filter and the account names have no length limit, and the
+		// screen clips whatever does not fit.
+		screen.put(0, 0, std::format(L" {}/{} processes | row {} | sort: {} {} | filter: {}{} | arrows/PgUp/PgDn scroll, w p n i sort, r reverse, / filter, q quit",
+			rows_.size(), processes_.size(), rows_.empty() ? 0 : selected_ + 1, sortLabel(sortKey_), descending_ ? L"desc" : L"asc",
+			filter_, editingFilter_ ? L"_" : L""), CellStyle::Highlight);
+
+		std::wstring header = std::format(L"{:<8}{:<30}{:>16}{:>16}  {:<40}", L"PID", L"Process", L"Working Set", L"Private", L"User");
+		header.resize(std::max<std::size_t>(header.size(), static_cast<std::size_t>(screen.width())), L' ');
+		screen.put(0, 1, header, CellStyle::Header);
+
+		for (std::size_t i = 0; i < capacity && scroll_ + i < rows_.size(); i++)
+		{
+			const std::size_t row = scroll_ + i;
+			const ProcessInfo& p = processes_[rows_[row]];
+
+			const std::wstring line = std::format(L"{:<8}{:<30}{:>16}{:>16}  {}",
+				p.pid, displayNameOf(p.name),
+				formatBytes(p.workingSetBytes).view(),
+				formatBytes(p.privateBytes).view(),
+				accounts_.resolve(p.userSid));
+
+			screen.put(0, HEADER_ROWS + static_cast<int>(i), line, row == selected_ ? CellStyle::Header : CellStyle::Normal);
+		}
+	}
+
+private:
+	/// <summary>
+	/// Selects a sort key; names and PIDs default to ascending order, memory columns to descending.
+	/// </summary>
+	/// <param name="key">The new sort key.</param>
+	void setSort(SortKey key)
+	{
+		sortKey_ = key;
+		descending_ = key == SortKey::WorkingSet || key == SortKey::Private;
+		sortRows();
+	}
+
+	/// <summary>
+	/// Replaces the name filter and rebuilds the display order.
+	/// </summary>
+	/// <param name="filter">The new lowercase filter.</param>
+	void setFilter(std::wstring filter)
+	{
+		filter_ = std::move(filter);
+		applyFilter();
+	}
+
+	/// <summary>
+	/// Moves the selected row, clamped to the display order.
+	/// </summary>
+	/// <param name="delta">The number of rows to move; negative moves up.</param>
+	void moveSelection(std::ptrdiff_t delta) noexcept
+	{
+		if (rows_.empty())
+		{
+			selected_ = 0;
+			return;
+		}
+
+		const auto last = static_cast<std::ptrdiff_t>(rows_.size()) - 1;
+		selected_ = static_cast<std::size_t>(std::clamp(static_cast<std::ptrdiff_t>(selected_) + delta, std::ptrdiff_t{ 0 }, last));
+	}
+
+	/// <summary>
+	/// Rebuilds the display order from the snapshot and the filter: the filter is resolved once per distinct name through the index, then each process is kept or dropped by its name id.
+	/// </summary>
+	void applyFilter()
+	{
+		index_.match(filter_, nameMatches_);
+
+		rows_.clear();
+
+		for (std::size_t i = 0; i < processes_.size(); i++)
+		{
+			if (nameMatches_[nameIds_[i]])
+			{
+				rows_.push_back(i);
+			}
+		}
+
+		sortRows();
+	}
+
+	/// <summary>
+	/// Sorts the display order by the current sort key and clamps the selection.
+	/// </summary>
+	void sortRows()
+	{
+		std::sort(rows_.begin(), rows_.end(),
+			[this](std::size_t a, std::size_t b)
+			{
+				const ProcessInfo& x = processes_[descending_ ? b : a];
+				const ProcessInfo& y = processes_[descending_ ? a : b];
+
+				switch (sortKey_)
+				{
+				case SortKey::Private:
+					return x.privateBytes < y.privateBytes;
+				case SortKey::Name:
+					return x.name < y.name;
+				case SortKey::Pid:
+					return x.pid < y.pid;
+				default:
+					return x.workingSetBytes < y.workingSetBytes;
+				}
+			});
+
+		moveSelection(0);
+	}
+
+	/// <summary>
+	/// The service used to collect snapshots.
+	/// </summary>
+	const ProcessQueryService&	service_;
+
+	/// <summary>
+	/// Resolves owner SIDs to account names.
+	/// </summary>
+	AccountNameCache&			accounts_;
+
+	/// <summary>
+	/// The latest snapshot.
+	/// </summary>
+	std::vector<ProcessInfo>	processes_;
+
+	/// <summary>
+	/// Every process name seen during the session.
+	/// </summary>
+	StringInterner				names_;
+
+	/// <summary>
+	/// Trigram index over names_.
+	/// </summary>
+	NameSearchIndex				index_;
+
+	/// <summary>
+	/// The interned name of each process in processes_.
+	/// </summary>
+	std::vector<StringId>		nameIds_;
+
+	/// <summary>
+	/// For each name id, whether it passes the current filter.
+	/// </summary>
+	std::vector<bool>			nameMatches_;
+
+	/// <summary>
+	/// Indices into processes_ of the rows passing the filter, in display order.
+	/// </summary>
+	std::vector<std::size_t>	rows_;
+
+	/// <summary>
+	/// Position in rows_ of the first row in the window.
+	/// </summary>
+	std::size_t					scroll_{ 0 };
+
+	/// <summary>
+	/// Position in rows_ of the selected row.
+	/// </summary>
+	std::size_t					selected_{ 0 };
+
+	/// <summary>
+	/// The column rows are sorted by.
+	/// </summary>
+	SortKey						sortKey_{ SortKey::WorkingSet };
+
+	/// <summary>
+	/// Whether rows are sorted in descending order.
+	/// </summary>
+	bool						descending_{ true };
+
+	/// <summary>
+	/// Lowercase substring a process name must contain to be shown.
+	/// </summary>
+	std::wstring				filter_;
+
+	/// <summary>
+	/// Whether keys currently edit the filter.
+	/// </summary>
+	bool						editingFilter_{ false };
+};
+
+/// <summary>
+/// Runs the interactive live view until the user quits. The snapshot is refreshed every options.intervalMs; key presses redraw immediately. Each redraw only sends the cells that changed since the previous frame.
+/// </summary>
+/// <param name="options">The run options; intervalMs sets the refresh period.</param>
+/// <param name="service">The service used to collect snapshots.</param>
+/// <param name="accounts">Resolves owner SIDs to account names.</param>
+void runLiveView(const SnifferOptions& options, const ProcessQueryService& service, AccountNameCache& accounts)
+{
+	TerminalScreen screen;
+	LiveView view(service, accounts);
+
+	view.refresh();
+	ULONGLONG nextRefresh = ::GetTickCount64() + options.intervalMs;
+
+	while (true)
+	{
+		screen.beginFrame();
+		view.render(screen);
+		screen.present();
+
+		const ULONGLONG now = ::GetTickCount64();
+		KEY_EVENT_RECORD key{};
+
+		if (now < nextRefresh && screen.readKey(static_cast<DWORD>(nextRefresh - now), key))
+		{
+			if (!view.handleKey(key, static_cast<std::size_t>(std::max(1, screen.height() - HEADER_ROWS))))
+			{
+				return;
+			}
+
+			continue;
+		}
+
+		view.refresh();
+		nextRefresh = ::GetTickCount64() + options.intervalMs;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "ProcessMemorySniffer.hpp"
+#include "ProcessQueryService.hpp"
+#include "AccountNameCache.hpp"
+
+void runLiveView(const SnifferOptions& options, const ProcessQueryService& service, AccountNameCache& accounts);
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#include "ProcessInfo.hpp"
+
+/// <summary>
+/// Compact allocation state of a region, mirroring MEM_RESERVE / MEM_COMMIT without the full DWORD.
+/// </summary>
+enum class RegionState : std::uint8_t
+{
+	Reserved,
+	Committed
+};
+
+/// <summary>
+/// Compact backing type of a region, mirroring MEM_PRIVATE / MEM_MAPPED / MEM_IMAGE without the full DWORD.
+/// </summary>
+enum class RegionType : std::uint8_t
+{
+	Private,
+	Mapped,
+	Image
+};
+
+/// <summary>
+/// Compact description of a single non-free virtual memory region of a process, as reported by VirtualQueryEx.
+/// Kept small and trivially copyable so that region lists of processes with tens of thousands of regions stay cache friendly.
+/// </summary>
+struct MemoryRegion
+{
+	/// <summary>
+	/// The base address of the region.
+	/// </summary>
+	std::uintptr_t	base{ 0 };
+
+	/// <summary>
+	/// The base address of the allocation (VirtualAlloc call, mapped view or image) the region belongs to.
+	/// </summary>
+	std::uintptr_t	allocationBase{ 0 };
+
+	/// <summary>
+	/// The size of the region.
+	/// </summary>
+	Bytes			size{ 0 };
+
+	/// <summary>
+	/// The page protection of the region (PAGE_* flags). Zero for reserved regions.
+	/// </summary>
+	DWORD			protect{ 0 };
+
+	/// <summary>
+	/// Whether the region is reserved or committed.
+	/// </summary>
+	RegionState		state{ RegionState::Reserved };
+
+	/// <summary>
+	/// Whether the region is private, a mapped view or an image.
+	/// </summary>
+	RegionType		type{ RegionType::Private };
+
+	/// <summary>
+	/// Returns the first address past the end of the region.
+	/// </summary>
+	/// <returns>base + size.</returns>
+	[[nodiscard]] std::uintptr_t end() const noexcept
+	{
+		return base + size;
+	}
+};
\ No newline at end of file
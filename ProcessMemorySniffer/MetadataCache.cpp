@@ -0,0 +1,427 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "MetadataCache.hpp"
+
+/// <summary>
+/// "PMSM" in little-endian byte order.
+/// </summary>
+constexpr std::uint32_t CACHE_MAGIC = 0x4D534D50;
+
+/// <summary>
+/// Bumped whenever the layout below changes; files of another version are ignored.
+/// </summary>
+constexpr std::uint32_t CACHE_VERSION = 1;
+
+/// <summary>
+/// A string in the pool: offset and length in UTF-16 code units.
+/// </summary>
+struct CacheString
+{
+	std::uint32_t	offset;
+	std::uint32_t	length;
+};
+
+/// <summary>
+/// The file header, followed by entryCount CacheEntry records sorted by (pid, startTime), accountCount CacheAccount records
+/// and stringUnits UTF-16 code units of string pool.
+/// </summary>
+struct CacheHeader
+{
+	std::uint32_t	magic;
+	std::uint32_t	version;
+	std::uint32_t	entryCount;
+	std::uint32_t	accountCount;
+	std::uint64_t	stringUnits;
+};
+
+/// <summary>
+/// One process.
+/// </summary>
+struct CacheEntry
+{
+	std::uint32_t	pid;
+	std::uint32_t	reserved;
+	std::uint64_t	startTime;
+	CacheString		name;
+	CacheString		userSid;
+};
+
+/// <summary>
+/// One resolved account.
+/// </summary>
+struct CacheAccount
+{
+	CacheString		sid;
+	CacheString		name;
+};
+
+static_assert(sizeof(CacheHeader) == 24 && sizeof(CacheEntry) == 32 && sizeof(CacheAccount) == 16, "The cache layout must not depend on padding.");
+
+/// <summary>
+/// Orders entries by key, the order they are stored and searched in.
+/// </summary>
+/// <param name="pid">The PID of the entry.</param>
+/// <param name="startTime">The start time of the entry.</param>
+/// <param name="key">The key to compare with.</param>
+/// <returns>true if the entry sorts before key.</returns>
+[[nodiscard]] static bool keyLess(std::uint32_t pid, std::uint64_t startTime, const ProcessKey& key) noexcept
+{
+	return pid != key.pid ? pid < key.pid : startTime < key.startTime;
+}
+
+/// <summary>
+/// Constructs a cache backed by a file, mapping the file of the previous run if there is a valid one.
+/// </summary>
+/// <param name="path">The cache file, usually defaultPath(); empty for a cache that lives in memory only.</param>
+MetadataCache::MetadataCache(std::wstring path) : path_(std::move(path))
+{
+	if (!path_.empty())
+	{
+		map();
+	}
+}
+
+/// <summary>
+/// Unmaps the file.
+/// </summary>
+MetadataCache::~MetadataCache() noexcept
+{
+	unmap();
+}
+
+/// <summary>
+/// Returns the default cache file, %LOCALAPPDATA%\ProcessMemorySniffer\metadata.cache.
+/// </summary>
+/// <returns>The path; empty if LOCALAPPDATA is not set (e.g. some service accounts), which disables the file.</returns>
+std::wstring MetadataCache::defaultPath()
+{
+	wchar_t buffer[MAX_PATH];
+	const DWORD length = ::GetEnvironmentVariableW(L"LOCALAPPDATA", buffer, static_cast<DWORD>(std::size(buffer)));
+
+	if (length == 0 || length >= std::size(buffer))
+	{
+		return {};
+	}
+
+	return std::wstring(buffer, length) + L"\\ProcessMemorySniffer\\metadata.cache";
+}
+
+/// <summary>
+/// Maps the cache file read-only if it exists and has a valid header and section sizes. String offsets are checked on use.
+/// </summary>
+void MetadataCache::map()
+{
+	const HANDLE file = ::CreateFileW(path_.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	// The mapping keeps the file open; the file handle itself is not needed afterwards.
+	const ProcessHandle fileHandle(file);
+	LARGE_INTEGER size{};
+
+	if (!::GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(CacheHeader)) || size.QuadPart > (LONGLONG{ 1 } << 30))
+	{
+		return;
+	}
+
+	ProcessHandle mapping(::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr));
+
+	if (!mapping)
+	{
+		return;
+	}
+
+	const auto* view = static_cast<const BYTE*>(::MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0));
+
+	if (view == nullptr)
+	{
+		return;
+	}
+
+	const std::size_t viewSize = static_cast<std::size_t>(size.QuadPart);
+	CacheHeader header;
+	std::memcpy(&header, view, sizeof(header));
+
+	const std::uint64_t expected = sizeof(CacheHeader)
+		+ std::uint64_t{ header.entryCount } * sizeof(CacheEntry)
+		+ std::uint64_t{ header.accountCount } * sizeof(CacheAccount)
+		+ header.stringUnits * sizeof(wchar_t);
+
+	if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.stringUnits > viewSize || expected != viewSize)
+	{
+		::UnmapViewOfFile(view);
+		return;
+	}
+
+	mapping_ = std::move(mapping);
+	view_ = view;
+	viewSize_ = viewSize;
+}
+
+/// <summary>
+/// Unmaps the file of the previous run, e.g. before it is replaced.
+/// </summary>
+void MetadataCache::unmap() noexcept
+{
+	if (view_ != nullptr)
+	{
+		::UnmapViewOfFile(view_);
+		view_ = nullptr;
+		viewSize_ = 0;
+	}
+
+	mapping_ = ProcessHandle();
+}
+
+/// <summary>
+/// Searches the mapped file for a process.
+/// </summary>
+/// <param name="key">The process.</param>
+/// <param name="metadata">Receives the metadata if found.</param>
+/// <returns>true if the file has a valid entry for the process.</returns>
+bool MetadataCache::findMapped(const ProcessKey& key, ProcessMetadata& metadata) const
+{
+	if (view_ == nullptr)
+	{
+		return false;
+	}
+
+	CacheHeader header;
+	std::memcpy(&header, view_, sizeof(header));
+
+	const BYTE* entries = view_ + sizeof(CacheHeader);
+	const auto* strings = reinterpret_cast<const wchar_t*>(entries + std::size_t{ header.entryCount } * sizeof(CacheEntry)
+		+ std::size_t{ header.accountCount } * sizeof(CacheAccount));
+
+	// Binary search over the records in place; memcpy keeps the reads free of alignment and aliasing assumptions.
+	std::size_t low = 0;
+	std::size_t high = header.entryCount;
+
+	while (low < high)
+	{
+		const std::size_t middle = low + (high - low) / 2;
+		CacheEntry entry;
+		std::memcpy(&entry, entries + middle * sizeof(CacheEntry), sizeof(entry));
+
+		if (keyLess(entry.pid, entry.startTime, key))
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if (low == header.entryCount)
+	{
+		return false;
+	}
+
+	CacheEntry entry;
+	std::memcpy(&entry, entries + low * sizeof(CacheEntry), sizeof(entry));
+
+	if (entry.pid != key.pid || entry.startTime != key.startTime)
+	{
+		return false;
+	}
+
+	const auto valid = [&](const CacheString& s)
+		{
+			return std::uint64_t{ s.offset } + s.length <= header.stringUnits;
+		};
+
+	if (!valid(entry.name) || !valid(entry.userSid))
+	{
+		return false;
+	}
+
+	metadata.name.assign(strings + entry.name.offset, entry.name.length);
+	metadata.userSid.assign(strings + entry.userSid.offset, entry.userSid.length);
+	return true;
+}
+
+/// <summary>
+/// Looks up the metadata of a process, first among the processes seen during this run, then in the previous run's file.
+/// A hit in the file is carried over into this run's entries.
+/// </summary>
+/// <param name="key">The process.</param>
+/// <returns>The metadata, or nullptr if the process has to be resolved (and then passed to store()). The pointer stays valid until forget() drops the process.</returns>
+const ProcessMetadata* MetadataCache::find(const ProcessKey& key)
+{
+	if (const auto it = entries_.find(key); it != entries_.end())
+	{
+		hits_++;
+		return &it->second;
+	}
+
+	ProcessMetadata metadata;
+
+	if (findMapped(key, metadata))
+	{
+		hits_++;
+		return &entries_.emplace(key, std::move(metadata)).first->second;
+	}
+
+	misses_++;
+	return nullptr;
+}
+
+/// <summary>
+/// Stores the resolved metadata of a process. Incomplete results (unknown name or owner, e.g. because access was denied) are
+/// not stored, so they are retried rather than remembered.
+/// </summary>
+/// <param name="key">The process.</param>
+/// <param name="name">The process name.</param>
+/// <param name="userSid">The owner's string SID.</param>
+void MetadataCache::store(const ProcessKey& key, const std::wstring& name, const std::wstring& userSid)
+{
+	if (key.startTime == 0 || name.empty() || name == L"<unknown>" || userSid.empty())
+	{
+		return;
+	}
+
+	entries_.insert_or_assign(key, ProcessMetadata{ name, userSid });
+}
+
+/// <summary>
+/// Seeds an account name cache with the accounts resolved by the previous run.
+/// </summary>
+/// <param name="accounts">The cache to seed.</param>
+void MetadataCache::primeAccounts(AccountNameCache& accounts) const
+{
+	if (view_ == nullptr)
+	{
+		return;
+	}
+
+	CacheHeader header;
+	std::memcpy(&header, view_, sizeof(header));
+
+	const BYTE* records = view_ + sizeof(CacheHeader) + std::size_t{ header.entryCount } * sizeof(CacheEntry);
+	const auto* strings = reinterpret_cast<const wchar_t*>(records + std::size_t{ header.accountCount } * sizeof(CacheAccount));
+
+	for (std::uint32_t i = 0; i < header.accountCount; i++)
+	{
+		CacheAccount account;
+		std::memcpy(&account, records + i * sizeof(CacheAccount), sizeof(account));
+
+		if (std::uint64_t{ account.sid.offset } + account.sid.length <= header.stringUnits
+			&& std::uint64_t{ account.name.offset } + account.name.length <= header.stringUnits)
+		{
+			accounts.prime(std::wstring(strings + account.sid.offset, account.sid.length),
+				std::wstring(strings + account.name.offset, account.name.length));
+		}
+	}
+}
+
+/// <summary>
+/// Writes the processes seen during this run and still running when forget() was last called, and the resolved accounts, to
+/// the cache file, replacing the previous run's file atomically (write to a temporary file, then rename). Processes that
+/// exited before or during this run are thereby dropped.
+/// </summary>
+/// <param name="accounts">The account names resolved during this run.</param>
+/// <returns>true if the file was written; false if the cache has no file or it could not be written (the next run then starts cold).</returns>
+bool MetadataCache::save(const AccountNameCache& accounts)
+{
+	if (path_.empty())
+	{
+		return false;
+	}
+
+	std::vector<const std::pair<const ProcessKey, ProcessMetadata>*> sorted;
+	sorted.reserve(entries_.size());
+
+	for (const auto& entry : entries_)
+	{
+		sorted.push_back(&entry);
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b)
+		{
+			return keyLess(a->first.pid, a->first.startTime, b->first);
+		});
+
+	// Names and owners repeat across processes (svchost.exe, the same few SIDs), so the pool stores each distinct string once.
+	std::wstring pool;
+	std::unordered_map<std::wstring_view, CacheString> pooled;
+
+	const auto addString = [&](const std::wstring& text)
+		{
+			if (const auto it = pooled.find(text); it != pooled.end())
+			{
+				return it->second;
+			}
+
+			const CacheString s{ static_cast<std::uint32_t>(pool.size()), static_cast<std::uint32_t>(text.size()) };
+			pool += text;
+			pooled.emplace(std::wstring_view(text), s);
+			return s;
+		};
+
+	std::vector<CacheEntry> records;
+	records.reserve(sorted.size());
+
+	for (const auto* entry : sorted)
+	{
+		records.push_back({ static_cast<std::uint32_t>(entry->first.pid), 0, entry->first.startTime, addString(entry->second.name), addString(entry->second.userSid) });
+	}
+
+	std::vector<CacheAccount> accountRecords;
+
+	for (const auto& [sid, name] : accounts.names())
+	{
+		// Unresolved SIDs are cached in memory as themselves; leave them out so the next run tries again.
+		if (!sid.empty() && name != sid)
+		{
+			accountRecords.push_back({ addString(sid), addString(name) });
+		}
+	}
+
+	const CacheHeader header{ CACHE_MAGIC, CACHE_VERSION, static_cast<std::uint32_t>(records.size()),
+		static_cast<std::uint32_t>(accountRecords.size()), pool.size() };
+
+	std::error_code error;
+	const std::filesystem::path target(path_);
+	std::filesystem::create_directories(target.parent_path(), error);
+
+	std::filesystem::path temporary = target;
+	temporary += L".tmp";
+
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(CacheEntry)));
+		out.write(reinterpret_cast<const char*>(accountRecords.data()), static_cast<std::streamsize>(accountRecords.size() * sizeof(CacheAccount)));
+		out.write(reinterpret_cast<const char*>(pool.data()), static_cast<std::streamsize>(pool.size() * sizeof(wchar_t)));
+
+		if (!out)
+		{
+			return false;
+		}
+	}
+
+	// The view must go before the file it maps can be replaced.
+	unmap();
+	std::filesystem::rename(temporary, target, error);
+
+	if (error)
+	{
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
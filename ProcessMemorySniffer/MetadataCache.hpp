@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "AccountNameCache.hpp"
+#include "ProcessHandle.hpp"
+#include "ProcessKey.hpp"
+
+/// <summary>
+/// The metadata of a process that is expensive to resolve and never changes while the process lives.
+/// </summary>
+struct ProcessMetadata
+{
+	/// <summary>
+	/// The process name.
+	/// </summary>
+	std::wstring	name;
+
+	/// <summary>
+	/// The string SID of the owner.
+	/// </summary>
+	std::wstring	userSid;
+};
+
+/// <summary>
+/// Keeps process metadata (names and owners) and resolved account names between runs, so that a cold start only resolves
+/// processes that started since the previous run. Entries are keyed by ProcessKey, so a reused PID never picks up another
+/// process' metadata.
+/// The file of the previous run is memory-mapped read-only and searched in place: entries are fixed-size records sorted by key,
+/// followed by a deduplicated UTF-16 string pool, so opening the cache costs no parsing. A missing, foreign or damaged file
+/// is treated as empty; the cache is an optimization and never fails a run.
+/// Not thread safe.
+/// </summary>
+class MetadataCache
+{
+public:
+	explicit MetadataCache(std::wstring path);
+
+	MetadataCache(const MetadataCache&) = delete;
+	MetadataCache& operator=(const MetadataCache&) = delete;
+
+	~MetadataCache() noexcept;
+
+	[[nodiscard]] static std::wstring defaultPath();
+
+	[[nodiscard]] const ProcessMetadata* find(const ProcessKey& key);
+
+	void store(const ProcessKey& key, const std::wstring& name, const std::wstring& userSid);
+
+	void primeAccounts(AccountNameCache& accounts) const;
+
+	bool save(const AccountNameCache& accounts);
+
+	/// <summary>
+	/// Drops the processes that have exited, so the entries (and the file save() writes) stay proportional to the running
+	/// processes rather than growing with every process seen during a long run.
+	/// </summary>
+	/// <param name="exited">Returns true for the ProcessKey of a process that is no longer running.</param>
+	template <typename Predicate>
+	void forget(Predicate exited)
+	{
+		std::erase_if(entries_, [&exited](const auto& entry) { return exited(entry.first); });
+	}
+
+	/// <summary>
+	/// Returns the number of lookups answered from the cache.
+	/// </summary>
+	[[nodiscard]] std::size_t hits() const noexcept
+	{
+		return hits_;
+	}
+
+	/// <summary>
+	/// Returns the number of lookups that had to be resolved.
+	/// </summary>
+	[[nodiscard]] std::size_t misses() const noexcept
+	{
+		return misses_;
+	}
+
+private:
+	void map();
+
+	void unmap() noexcept;
+
+	[[nodiscard]] bool findMapped(const ProcessKey& key, ProcessMetadata& metadata) const;
+
+	/// <summary>
+	/// The cache file; empty for a cache that lives in memory only.
+	/// </summary>
+	std::wstring	path_;
+
+	/// <summary>
+	/// The mapping of the previous run's file and its read-only view, or null if there is none.
+	/// </summary>
+	ProcessHandle	mapping_;
+	const BYTE*		view_{ nullptr };
+
+	/// <summary>
+	/// The size of the view in bytes.
+	/// </summary>
+	std::size_t		viewSize_{ 0 };
+
+	/// <summary>
+	/// The processes seen during this run, resolved or taken from the file, less those dropped by forget() after they exited;
+	/// these are the entries the next run gets.
+	/// </summary>
+	std::unordered_map<ProcessKey, ProcessMetadata, ProcessKeyHash>	entries_;
+
+	/// <summary>
+	/// Lookup statistics.
+	/// </summary>
+	std::size_t		hits_{ 0 };
+	std::size_t		misses_{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include <Windows.h>
+
+#include "MetadataResolver.hpp"
+#include "ProcessHandle.hpp"
+#include "ProcessQueryService.hpp"
+#include "ResourceCounters.hpp"
+
+/// <summary>
+/// Starts the worker.
+/// </summary>
+/// <param name="cache">The cache resolved metadata is stored in and looked up from.</param>
+/// <param name="trace">Records resolutions that exceed its slow-query threshold; may be nullptr.</param>
+MetadataResolver::MetadataResolver(MetadataCache& cache, TraceRecorder* trace)
+	: cache_(cache), state_(std::make_shared<SharedState>())
+{
+	state_->trace = trace;
+	worker_ = std::thread(&MetadataResolver::run, state_);
+}
+
+/// <summary>
+/// Stops the worker without waiting for a query in progress.
+/// </summary>
+MetadataResolver::~MetadataResolver() noexcept
+{
+	stop();
+}
+
+/// <summary>
+/// Stops the worker, dropping the rest of the queue; idempotent. Must be called before the trace recorder writes its file,
+/// since the worker records to it. A worker that is still inside a query after the grace period is detached rather than
+/// joined, so a hung process cannot hold up the end of the run; it keeps only the shared state alive and no longer records.
+/// </summary>
+/// <param name="grace">How long to wait for a query in progress to finish.</param>
+void MetadataResolver::stop(std::chrono::milliseconds grace) noexcept
+{
+	if (!worker_.joinable())
+	{
+		return;
+	}
+
+	bool finished = false;
+
+	{
+		std::unique_lock lock(state_->mutex);
+		state_->stopping = true;
+		state_->trace = nullptr;
+		state_->workAvailable.notify_all();
+		finished = state_->idle.wait_for(lock, grace, [this] { return !state_->busy; });
+	}
+
+	if (finished)
+	{
+		worker_.join();
+	}
+	else
+	{
+		worker_.detach();
+	}
+}
+
+/// <summary>
+/// The worker loop: takes processes off the queue, resolves their name and owner through a handle validated against the key
+/// (so a reused PID is never resolved as the queued process) and hands the results back.
+/// </summary>
+/// <param name="state">The state shared with the resolver.</param>
+void MetadataResolver::run(std::shared_ptr<SharedState> state)
+{
+	// Counted apart from the collecting thread, so --stats does not charge resolutions to whatever phase is being measured.
+	markBackgroundThread();
+
+	std::unique_lock lock(state->mutex);
+
+	while (true)
+	{
+		state->workAvailable.wait(lock, [&state] { return state->stopping || !state->queue.empty(); });
+
+		if (state->stopping)
+		{
+			return;
+		}
+
+		const ProcessKey key = state->queue.front();
+		state->queue.pop_front();
+		state->busy = true;
+
+		TraceRecorder* const trace = state->trace;
+		const std::uint64_t start = trace != nullptr ? trace->now() : 0;
+		lock.unlock();
+
+		ProcessMetadata metadata{ L"<unknown>", {} };
+
+		if (auto handleOpt = ProcessHandle::open(key))
+		{
+			metadata.name = ProcessQueryService::tryGetProcessName(handleOpt->get());
+			metadata.userSid = ProcessQueryService::tryGetProcessUser(handleOpt->get());
+		}
+
+		lock.lock();
+
+		// Recorded under the lock, re-reading the recorder, so nothing is recorded once stop() has cleared it.
+		if (state->trace != nullptr)
+		{
+			state->trace->recordQuery("metadata", key.pid, metadata.name, start, state->trace->now());
+		}
+
+		state->resolved.emplace_back(key, std::move(metadata));
+		state->busy = false;
+
+		if (state->queue.empty() || state->stopping)
+		{
+			state->idle.notify_all();
+		}
+	}
+}
+
+/// <summary>
+/// Moves the worker's results into the cache (complete ones) or incomplete_.
+/// </summary>
+void MetadataResolver::applyResolved()
+{
+	std::vector<std::pair<ProcessKey, ProcessMetadata>> resolved;
+
+	{
+		std::lock_guard lock(state_->mutex);
+		resolved.swap(state_->resolved);
+	}
+
+	for (auto& [key, metadata] : resolved)
+	{
+		pending_.erase(key);
+
+		if (metadata.name == L"<unknown>" || metadata.userSid.empty())
+		{
+			incomplete_.insert_or_assign(key, std::move(metadata));
+		}
+		else
+		{
+			cache_.store(key, metadata.name, metadata.userSid);
+		}
+	}
+}
+
+/// <summary>
+/// Fills in the name and owner of a process if they are known, and queues the process for resolution otherwise. Never blocks
+/// on a resolution. A process is looked up in the cache only until it is queued, so the cache counts one miss per process
+/// however many lookups it stays pending for. Throws std::system_error if the shared state cannot be locked, or std::bad_alloc.
+/// </summary>
+/// <param name="key">The process.</param>
+/// <param name="info">Receives the name and owner, or PENDING_METADATA for both with metadataPending set.</param>
+/// <returns>true if the metadata was known; false if the process is pending.</returns>
+bool MetadataResolver::lookup(const ProcessKey& key, ProcessInfo& info)
+{
+	applyResolved();
+
+	if (!pending_.contains(key))
+	{
+		// Incomplete results are never stored in the cache, so they are checked first and cost no miss on every tick.
+		if (const auto it = incomplete_.find(key); it != incomplete_.end())
+		{
+			info.name = it->second.name;
+			info.userSid = it->second.userSid;
+			info.metadataPending = false;
+			return true;
+		}
+
+		if (const ProcessMetadata* cached = cache_.find(key))
+		{
+			info.name = cached->name;
+			info.userSid = cached->userSid;
+			info.metadataPending = false;
+			return true;
+		}
+
+		pending_.insert(key);
+
+		{
+			std::lock_guard lock(state_->mutex);
+			state_->queue.push_back(key);
+		}
+
+		state_->workAvailable.notify_one();
+	}
+
+	info.name = PENDING_METADATA;
+	info.userSid = PENDING_METADATA;
+	info.metadataPending = true;
+
+	return false;
+}
+
+/// <summary>
+/// Fills in the metadata of pending processes that has been resolved since they were collected, e.g. right before printing.
+/// </summary>
+/// <param name="processes">The processes; those still pending stay pending.</param>
+void MetadataResolver::fill(std::vector<ProcessInfo>& processes)
+{
+	for (auto& p : processes)
+	{
+		if (p.metadataPending)
+		{
+			(void)lookup(p.key(), p);
+		}
+	}
+}
+
+/// <summary>
+/// Forgets the processes that have exited: drops them from pending_, incomplete_ and the cache and takes them off the worker's
+/// queue, so that none of them grows with every process seen during a long run. A process has exited once its PID is no longer enumerated,
+/// or once a process with another start time was collected under its PID. Processes that a sampled tick enumerated but did not
+/// collect are kept, so their resolution is not thrown away before they are sampled again.
+/// </summary>
+/// <param name="pids">Every PID enumerated on the tick, before sampling.</param>
+/// <param name="processes">The processes collected on the tick.</param>
+void MetadataResolver::retain(const std::vector<DWORD>& pids, const std::vector<ProcessInfo>& processes)
+{
+	const std::unordered_set<DWORD> enumerated(pids.begin(), pids.end());
+	std::unordered_map<DWORD, std::uint64_t> collected;
+	collected.reserve(processes.size());
+
+	for (const auto& p : processes)
+	{
+		collected.emplace(p.pid, p.startTime);
+	}
+
+	const auto exited = [&](const ProcessKey& key)
+		{
+			if (!enumerated.contains(key.pid))
+			{
+				return true;
+			}
+
+			const auto it = collected.find(key.pid);
+			return it != collected.end() && it->second != key.startTime;
+		};
+
+	std::erase_if(pending_, exited);
+	std::erase_if(incomplete_, [&exited](const auto& entry) { return exited(entry.first); });
+	cache_.forget(exited);
+
+	std::lock_guard lock(state_->mutex);
+	std::erase_if(state_->queue, exited);
+}
+
+/// <summary>
+/// Blocks until the worker has resolved every queued process or the timeout expires, e.g. before the first tick is printed,
+/// when nearly everything is pending. Processes still unresolved afterwards stay pending.
+/// </summary>
+/// <param name="timeout">The longest time to wait.</param>
+/// <returns>true if the queue was drained; false if the timeout expired first.</returns>
+bool MetadataResolver::waitUntilIdle(std::chrono::milliseconds timeout)
+{
+	std::unique_lock lock(state_->mutex);
+	return state_->idle.wait_for(lock, timeout, [this] { return state_->stopping || (state_->queue.empty() && !state_->busy); });
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "MetadataCache.hpp"
+#include "ProcessInfo.hpp"
+#include "ProcessKey.hpp"
+#include "TraceRecorder.hpp"
+
+/// <summary>
+/// Resolves process names and owners on a background thread, so the counter loop never waits for them: a process whose metadata
+/// is not known yet is published with PENDING_METADATA and queued, and its metadata fills in on a later lookup once resolved.
+/// Name and owner queries can stall for a long time (a hung process, a slow token query), which used to delay the whole tick.
+/// All members except the worker are used from the collecting thread only; the cache is never touched by the worker, which
+/// hands its results back through the mutex-protected shared state.
+/// </summary>
+class MetadataResolver
+{
+public:
+	MetadataResolver(MetadataCache& cache, TraceRecorder* trace);
+
+	MetadataResolver(const MetadataResolver&) = delete;
+	MetadataResolver& operator=(const MetadataResolver&) = delete;
+
+	~MetadataResolver() noexcept;
+
+	[[nodiscard]] bool lookup(const ProcessKey& key, ProcessInfo& info);
+
+	void fill(std::vector<ProcessInfo>& processes);
+
+	void retain(const std::vector<DWORD>& pids, const std::vector<ProcessInfo>& processes);
+
+	bool waitUntilIdle(std::chrono::milliseconds timeout);
+
+	void stop(std::chrono::milliseconds grace = std::chrono::milliseconds(0)) noexcept;
+
+private:
+	/// <summary>
+	/// The state shared with the worker. It is owned jointly, so a worker stuck in a hung query can be detached by stop() and
+	/// finish (or be ended with the process) without referring to a destroyed resolver.
+	/// </summary>
+	struct SharedState
+	{
+		/// <summary>
+		/// Guards every other member.
+		/// </summary>
+		std::mutex				mutex;
+
+		/// <summary>
+		/// Signals the worker that work arrived or that it should stop.
+		/// </summary>
+		std::condition_variable	workAvailable;
+
+		/// <summary>
+		/// Signals waiters that the worker finished its queue, or the process it was resolving when stopping.
+		/// </summary>
+		std::condition_variable	idle;
+
+		/// <summary>
+		/// Processes waiting to be resolved.
+		/// </summary>
+		std::deque<ProcessKey>	queue;
+
+		/// <summary>
+		/// Results the worker produced since the collecting thread last picked them up.
+		/// </summary>
+		std::vector<std::pair<ProcessKey, ProcessMetadata>>	resolved;
+
+		/// <summary>
+		/// Records slow resolutions on the worker's own trace buffer, or nullptr; cleared by stop() so a detached worker never
+		/// records to a recorder that is about to be written or destroyed.
+		/// </summary>
+		TraceRecorder*			trace{ nullptr };
+
+		/// <summary>
+		/// Whether the worker is resolving a process it already took off the queue.
+		/// </summary>
+		bool					busy{ false };
+
+		/// <summary>
+		/// Set to end the worker.
+		/// </summary>
+		bool					stopping{ false };
+	};
+
+	static void run(std::shared_ptr<SharedState> state);
+
+	void applyResolved();
+
+	/// <summary>
+	/// Metadata that outlives this run; resolved entries are stored in it.
+	/// </summary>
+	MetadataCache&			cache_;
+
+	/// <summary>
+	/// The state shared with the worker.
+	/// </summary>
+	std::shared_ptr<SharedState>	state_;
+
+	/// <summary>
+	/// Processes queued and not yet picked up, so a process is queued once however many ticks it stays pending. Processes that
+	/// exit while queued are dropped by retain().
+	/// </summary>
+	std::unordered_set<ProcessKey, ProcessKeyHash>	pending_;
+
+	/// <summary>
+	/// Processes whose metadata could not be resolved completely. The cache does not store incomplete results, so they are
+	/// kept here to be shown as resolved ("<unknown>") instead of being queued again on every tick, until retain() drops them.
+	/// </summary>
+	std::unordered_map<ProcessKey, ProcessMetadata, ProcessKeyHash>	incomplete_;
+
+	/// <summary>
+	/// The worker; started last, after the shared state.
+	/// </summary>
+	std::thread				worker_;
+};
\ No newline at end of file
@@ -0,0 +1,303 @@
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+
+#include <algorithm>
+#include <cwctype>
+#include <exception>
+#include <execution>
+#include <mutex>
+#include <numeric>
+#include <string>
+
+#include "ModuleView.hpp"
+#include "ProcessHandle.hpp"
+#include "ResourceCounters.hpp"
+
+#pragma comment(lib, "Psapi.lib")
+
+/// <summary>
+/// Initial capacity of the module handle buffer passed to EnumProcessModulesEx.
+/// </summary>
+constexpr std::size_t MODULE_VECT_SIZE = 256;
+
+/// <summary>
+/// Lists the modules of an already opened process, resizing the buffer until EnumProcessModulesEx fits every handle.
+/// </summary>
+/// <param name="process">Handle to the process. Must have PROCESS_QUERY_INFORMATION and PROCESS_VM_READ access.</param>
+/// <param name="modules">Receives the module handles (base addresses). Cleared on failure.</param>
+/// <returns>true on success; false if the module list could not be read (e.g. the process is exiting or is a protected process).</returns>
+static bool enumerateModules(HANDLE process, std::vector<HMODULE>& modules)
+{
+	modules.resize(MODULE_VECT_SIZE);
+
+	while (true)
+	{
+		DWORD bytesNeeded = 0;
+
+		countSystemCall();
+		if (!::EnumProcessModulesEx(process, modules.data(),
+			static_cast<DWORD>(modules.size() * sizeof(HMODULE)), &bytesNeeded, LIST_MODULES_ALL))
+		{
+			modules.clear();
+			return false;
+		}
+
+		const std::size_t count = bytesNeeded / sizeof(HMODULE);
+
+		if (count <= modules.size())
+		{
+			modules.resize(count);
+			return true;
+		}
+
+		// The buffer was too small. Grow to the reported size and try again; modules may have been loaded in between.
+		modules.resize(count + count / 4);
+	}
+}
+
+/// <summary>
+/// The longest module path in characters, including the terminator: the limit of a UNICODE_STRING.
+/// </summary>
+constexpr std::size_t MAX_MODULE_PATH = 32'768;
+
+/// <summary>
+/// Reads the full path of a module. GetModuleFileNameExW truncates silently when the buffer is too small, so a result that
+/// fills the buffer is read again with a larger one.
+/// </summary>
+/// <param name="process">Handle to the process. Must have PROCESS_QUERY_INFORMATION and PROCESS_VM_READ access.</param>
+/// <param name="module">The module handle (base address).</param>
+/// <param name="buffer">Scratch buffer, reused across calls; grown as needed.</param>
+/// <returns>A view of the path in buffer; empty if it could not be read.</returns>
+static std::wstring_view moduleFileName(HANDLE process, HMODULE module, std::wstring& buffer)
+{
+	if (buffer.size() < MAX_PATH)
+	{
+		buffer.resize(MAX_PATH);
+	}
+
+	while (true)
+	{
+		countSystemCall();
+		const DWORD length = ::GetModuleFileNameExW(process, module, buffer.data(), static_cast<DWORD>(buffer.size()));
+
+		if (length == 0)
+		{
+			return {};
+		}
+
+		// Shorter than the buffer less the terminator: the path is complete.
+		if (length < buffer.size() - 1)
+		{
+			return std::wstring_view(buffer.data(), length);
+		}
+
+		if (buffer.size() >= MAX_MODULE_PATH)
+		{
+			return {};
+		}
+
+		buffer.resize(std::min(buffer.size() * 2, MAX_MODULE_PATH));
+	}
+}
+
+/// <summary>
+/// Returns the file name part of a path, e.g. "ntdll.dll" for "C:\Windows\System32\ntdll.dll".
+/// </summary>
+/// <param name="path">A full path.</param>
+/// <returns>A view of the characters after the last backslash or slash.</returns>
+static std::wstring_view fileNameOf(std::wstring_view path) noexcept
+{
+	const auto slash = path.find_last_of(L"\\/");
+	return slash == std::wstring_view::npos ? path : path.substr(slash + 1);
+}
+
+/// <summary>
+/// Compares two strings ignoring case, as file names on Windows are case-insensitive.
+/// </summary>
+/// <param name="a">The first string.</param>
+/// <param name="b">The second string.</param>
+/// <returns>true if the strings are equal ignoring case.</returns>
+static bool equalsIgnoreCase(std::wstring_view a, std::wstring_view b) noexcept
+{
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+		[](wchar_t x, wchar_t y)
+		{
+			return std::towlower(x) == std::towlower(y);
+		});
+}
+
+/// <summary>
+/// Collects the modules of every process in pids in a single parallel pass. Each worker opens a process, lists its modules and
+/// interns their paths (under a lock; the path queries themselves run unlocked), producing a compact (path id, base, size) vector
+/// per process. The inverted index from module to processes is derived from those vectors afterwards.
+/// An exception escaping a parallel worker would call std::terminate, so workers catch everything, leave their process out and
+/// keep the first exception, which is rethrown (std::bad_alloc, std::system_error) once the pass is over.
+/// </summary>
+/// <param name="pids">The PIDs to inspect, typically from ProcessQueryService::enumerateProcessIds(). Inaccessible processes are skipped.</param>
+/// <returns>The populated ModuleView.</returns>
+ModuleView ModuleView::collect(const std::vector<DWORD>& pids)
+{
+	ModuleView view;
+	std::vector<ProcessModules> slots(pids.size());
+	std::mutex internLock;
+
+	std::vector<std::size_t> indices(pids.size());
+	std::iota(indices.begin(), indices.end(), std::size_t{ 0 });
+
+	std::mutex failureLock;
+	std::exception_ptr failure;
+
+	std::for_each(std::execution::par, indices.begin(), indices.end(),
+		[&](std::size_t i) noexcept
+		{
+			const DWORD pid = pids[i];
+
+			if (pid == 0)
+			{
+				return;
+			}
+
+			auto handleOpt = ProcessHandle::open(pid);
+
+			if (!handleOpt)
+			{
+				return;
+			}
+
+			ProcessModules& slot = slots[i];
+
+			try
+			{
+				std::vector<HMODULE> handles;
+
+				if (!enumerateModules(handleOpt->get(), handles))
+				{
+					return;
+				}
+
+				slot.pid = pid;
+				slot.modules.reserve(handles.size());
+
+				std::wstring buffer;
+
+				for (HMODULE module : handles)
+				{
+					const std::wstring_view path = moduleFileName(handleOpt->get(), module, buffer);
+
+					if (path.empty())
+					{
+						continue;
+					}
+
+					MODULEINFO info{};
+
+					countSystemCall();
+					if (!::GetModuleInformation(handleOpt->get(), module, &info, sizeof(info)))
+					{
+						continue;
+					}
+
+					ModuleEntry entry;
+					entry.base = reinterpret_cast<std::uintptr_t>(info.lpBaseOfDll);
+					entry.size = info.SizeOfImage;
+
+					{
+						std::lock_guard lock(internLock);
+						entry.path = view.paths_.intern(path);
+					}
+
+					slot.modules.push_back(entry);
+				}
+			}
+			catch (...)
+			{
+				// A failed slot is skipped like an inaccessible process.
+				slot.pid = 0;
+				slot.modules.clear();
+
+				std::lock_guard lock(failureLock);
+
+				if (!failure)
+				{
+					failure = std::current_exception();
+				}
+			}
+		});
+
+	if (failure)
+	{
+		std::rethrow_exception(failure);
+	}
+
+	// pids come from EnumProcesses in no particular order; keep the accessible processes sorted by PID so the inverted index lists are sorted too.
+	std::sort(slots.begin(), slots.end(),
+		[](const ProcessModules& a, const ProcessModules& b)
+		{
+			return a.pid < b.pid;
+		});
+
+	view.loadedBy_.resize(view.paths_.size());
+
+	for (auto& slot : slots)
+	{
+		if (slot.pid == 0)
+		{
+			continue;
+		}
+
+		for (const auto& entry : slot.modules)
+		{
+			auto& loadedBy = view.loadedBy_[entry.path];
+
+			// A module can appear twice in a WOW64 process (native and 32-bit views); record each process once.
+			if (loadedBy.empty() || loadedBy.back() != slot.pid)
+			{
+				loadedBy.push_back(slot.pid);
+			}
+		}
+
+		view.processes_.push_back(std::move(slot));
+	}
+
+	return view;
+}
+
+/// <summary>
+/// Finds the interned module paths matching a module name or path, ignoring case. A bare file name such as "ntdll.dll" matches every path ending in that name; anything containing a path separator must match the whole path.
+/// </summary>
+/// <param name="nameOrPath">The module file name or full path to search for.</param>
+/// <returns>The ids of all matching module paths; empty if no loaded module matches.</returns>
+std::vector<StringId> ModuleView::findModules(std::wstring_view nameOrPath) const
+{
+	const bool matchFullPath = nameOrPath.find_first_of(L"\\/") != std::wstring_view::npos;
+	std::vector<StringId> matches;
+
+	for (StringId id = 0; id < paths_.size(); id++)
+	{
+		const std::wstring_view path = paths_.lookup(id);
+
+		if (equalsIgnoreCase(matchFullPath ? path : fileNameOf(path), nameOrPath))
+		{
+			matches.push_back(id);
+		}
+	}
+
+	return matches;
+}
+
+/// <summary>
+/// Finds the module list of a process.
+/// </summary>
+/// <param name="pid">The PID to look up.</param>
+/// <returns>A pointer to the module list, or nullptr if the process was not accessible when the view was collected.</returns>
+const ProcessModules* ModuleView::findProcess(DWORD pid) const noexcept
+{
+	const auto it = std::lower_bound(processes_.begin(), processes_.end(), pid,
+		[](const ProcessModules& p, DWORD value)
+		{
+			return p.pid < value;
+		});
+
+	return it != processes_.end() && it->pid == pid ? &*it : nullptr;
+}
\ No newline at end of file
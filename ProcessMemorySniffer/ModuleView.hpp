@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "StringInterner.hpp"
+
+/// <summary>
+/// A module loaded into a process: the interned module path plus where it is mapped.
+/// </summary>
+struct ModuleEntry
+{
+	/// <summary>
+	/// The interned full path of the module file.
+	/// </summary>
+	StringId		path{ 0 };
+
+	/// <summary>
+	/// The size of the mapped image (SizeOfImage).
+	/// </summary>
+	std::uint32_t	size{ 0 };
+
+	/// <summary>
+	/// The base address the module is mapped at.
+	/// </summary>
+	std::uintptr_t	base{ 0 };
+};
+
+/// <summary>
+/// The modules of a single process. The first entry, if any, is the process executable.
+/// </summary>
+struct ProcessModules
+{
+	/// <summary>
+	/// The PID of the process.
+	/// </summary>
+	DWORD						pid{ 0 };
+
+	/// <summary>
+	/// The modules loaded in the process.
+	/// </summary>
+	std::vector<ModuleEntry>	modules;
+};
+
+/// <summary>
+/// Snapshot of the modules loaded in every accessible process, with each module path stored once across all processes and an
+/// inverted index from module to the processes that have it loaded.
+/// </summary>
+class ModuleView
+{
+public:
+	[[nodiscard]] static ModuleView collect(const std::vector<DWORD>& pids);
+
+	[[nodiscard]] std::vector<StringId> findModules(std::wstring_view nameOrPath) const;
+
+	/// <summary>
+	/// Returns the PIDs of the processes that have a module loaded, in ascending order.
+	/// </summary>
+	/// <param name="module">The interned module path.</param>
+	/// <returns>A view of the PIDs; valid for the lifetime of the ModuleView.</returns>
+	[[nodiscard]] std::span<const DWORD> processesWith(StringId module) const noexcept
+	{
+		return loadedBy_[module];
+	}
+
+	/// <summary>
+	/// Returns the interned module paths.
+	/// </summary>
+	/// <returns>A const reference to the interner holding every module path.</returns>
+	[[nodiscard]] const StringInterner& paths() const noexcept
+	{
+		return paths_;
+	}
+
+	/// <summary>
+	/// Returns the per-process module lists, sorted by PID. Processes that could not be opened are absent.
+	/// </summary>
+	/// <returns>A const reference to the per-process module lists.</returns>
+	[[nodiscard]] const std::vector<ProcessModules>& processes() const noexcept
+	{
+		return processes_;
+	}
+
+	[[nodiscard]] const ProcessModules* findProcess(DWORD pid) const noexcept;
+
+private:
+	/// <summary>
+	/// Every distinct module path seen in any process.
+	/// </summary>
+	StringInterner					paths_;
+
+	/// <summary>
+	/// The module lists of the accessible processes, sorted by PID.
+	/// </summary>
+	std::vector<ProcessModules>		processes_;
+
+	/// <summary>
+	/// Inverted index: for each module path id, the sorted PIDs of the processes that have it loaded.
+	/// </summary>
+	std::vector<std::vector<DWORD>>	loadedBy_;
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cwctype>
+#include <iterator>
+
+#include "NameSearchIndex.hpp"
+
+/// <summary>
+/// Packs three characters into a trigram key.
+/// </summary>
+/// <param name="text">Text with at least three characters from position i.</param>
+/// <param name="i">Position of the first character.</param>
+/// <returns>The trigram key.</returns>
+static std::uint64_t trigramAt(std::wstring_view text, std::size_t i) noexcept
+{
+	return (static_cast<std::uint64_t>(static_cast<std::uint16_t>(text[i])) << 32)
+		| (static_cast<std::uint64_t>(static_cast<std::uint16_t>(text[i + 1])) << 16)
+		| static_cast<std::uint64_t>(static_cast<std::uint16_t>(text[i + 2]));
+}
+
+/// <summary>
+/// Lowercases text character by character, as the index and its queries must agree on case folding.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <returns>The lowercase text.</returns>
+std::wstring NameSearchIndex::toLower(std::wstring_view text)
+{
+	std::wstring result(text);
+
+	for (auto& c : result)
+	{
+		c = static_cast<wchar_t>(std::towlower(c));
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Indexes the names interned since the previous update.
+/// </summary>
+/// <param name="names">The interner; must be the same interner on every call.</param>
+void NameSearchIndex::update(const StringInterner& names)
+{
+	for (auto id = static_cast<StringId>(lowered_.size()); id < names.size(); id++)
+	{
+		const std::wstring& lowered = lowered_.emplace_back(toLower(names.lookup(id)));
+
+		for (std::size_t i = 0; i + 3 <= lowered.size(); i++)
+		{
+			auto& posting = postings_[trigramAt(lowered, i)];
+
+			// Ids are indexed in ascending order, so a repeated gram within one name is always the last entry.
+			if (posting.empty() || posting.back() != id)
+			{
+				posting.push_back(id);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Finds the names containing a pattern, ignoring case.
+/// </summary>
+/// <param name="pattern">The lowercase pattern (see toLower()). An empty pattern matches every name.</param>
+/// <param name="matches">Receives one flag per indexed name id, true if the name contains the pattern.</param>
+void NameSearchIndex::match(std::wstring_view pattern, std::vector<bool>& matches) const
+{
+	matches.assign(lowered_.size(), pattern.empty());
+
+	if (pattern.empty())
+	{
+		return;
+	}
+
+	if (pattern.size() < 3)
+	{
+		for (StringId id = 0; id < lowered_.size(); id++)
+		{
+			matches[id] = lowered_[id].find(pattern) != std::wstring::npos;
+		}
+
+		return;
+	}
+
+	std::vector<const std::vector<StringId>*> lists;
+
+	for (std::size_t i = 0; i + 3 <= pattern.size(); i++)
+	{
+		const auto it = postings_.find(trigramAt(pattern, i));
+
+		if (it == postings_.end())
+		{
+			// Some gram occurs in no name, so nothing matches.
+			return;
+		}
+
+		lists.push_back(&it->second);
+	}
+
+	std::sort(lists.begin(), lists.end(),
+		[](const auto* a, const auto* b)
+		{
+			return a->size() < b->size();
+		});
+
+	std::vector<StringId> candidates = *lists.front();
+	std::vector<StringId> next;
+
+	for (std::size_t l = 1; l < lists.size() && !candidates.empty(); l++)
+	{
+		next.clear();
+		std::set_intersection(candidates.begin(), candidates.end(), lists[l]->begin(), lists[l]->end(), std::back_inserter(next));
+		candidates.swap(next);
+	}
+
+	// Containing every gram of the pattern does not imply containing the pattern itself; verify the survivors.
+	for (StringId id : candidates)
+	{
+		matches[id] = lowered_[id].find(pattern) != std::wstring::npos;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "StringInterner.hpp"
+
+/// <summary>
+/// Trigram index over the strings of a StringInterner for case-insensitive substring search.
+/// Each lowercase name is split into overlapping three-character grams, and every gram maps to the sorted ids of the names containing it.
+/// A query intersects the posting lists of its own grams, starting from the shortest, and only verifies the few surviving candidates,
+/// so filtering costs microseconds however many processes share those names. Patterns shorter than a gram fall back to scanning the
+/// distinct names, which is still independent of the process count.
+/// The index grows with the interner through update() and never needs a rebuild.
+/// </summary>
+class NameSearchIndex
+{
+public:
+	void update(const StringInterner& names);
+
+	void match(std::wstring_view pattern, std::vector<bool>& matches) const;
+
+	[[nodiscard]] static std::wstring toLower(std::wstring_view text);
+
+private:
+	/// <summary>
+	/// Lowercase copy of every indexed name, indexed by StringId.
+	/// </summary>
+	std::vector<std::wstring>								lowered_;
+
+	/// <summary>
+	/// Maps each trigram (three UTF-16 code units packed into 48 bits) to the ascending ids of the names containing it.
+	/// </summary>
+	std::unordered_map<std::uint64_t, std::vector<StringId>>	postings_;
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "OutputBuffer.hpp"
+#include "ResourceCounters.hpp"
+#include "Win32Error.hpp"
+
+/// <summary>
+/// The decimal digit pairs "00" through "99", so integers are formatted two digits per division.
+/// </summary>
+static constexpr char DIGIT_PAIRS[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+/// <summary>
+/// Constructs a buffer writing to a handle.
+/// </summary>
+/// <param name="output">The file or pipe handle to write to, e.g. GetStdHandle(STD_OUTPUT_HANDLE). Not owned.</param>
+OutputBuffer::OutputBuffer(HANDLE output) : output_(output), data_(std::make_unique<char[]>(CAPACITY))
+{ }
+
+/// <summary>
+/// Flushes any remaining output. Errors are ignored, as a destructor cannot report them; call flush() explicitly to observe them.
+/// </summary>
+OutputBuffer::~OutputBuffer() noexcept
+{
+	try
+	{
+		flush();
+	}
+	catch (...)
+	{
+	}
+}
+
+/// <summary>
+/// Appends bytes, splitting them across flushes if they do not fit.
+/// </summary>
+/// <param name="text">The bytes to append.</param>
+void OutputBuffer::append(std::string_view text)
+{
+	while (!text.empty())
+	{
+		const std::size_t chunk = std::min(text.size(), CAPACITY);
+		std::memcpy(claim(chunk), text.data(), chunk);
+		commit(chunk);
+		text.remove_prefix(chunk);
+	}
+}
+
+/// <summary>
+/// Appends the decimal representation of an unsigned integer without going through the C library or a locale.
+/// </summary>
+/// <param name="value">The value.</param>
+void OutputBuffer::appendUnsigned(std::uint64_t value)
+{
+	char digits[20];
+	char* end = digits + sizeof(digits);
+	char* p = end;
+
+	while (value >= 100)
+	{
+		const auto pair = static_cast<std::size_t>(value % 100) * 2;
+		value /= 100;
+		p -= 2;
+		p[0] = DIGIT_PAIRS[pair];
+		p[1] = DIGIT_PAIRS[pair + 1];
+	}
+
+	if (value >= 10)
+	{
+		const auto pair = static_cast<std::size_t>(value) * 2;
+		p -= 2;
+		p[0] = DIGIT_PAIRS[pair];
+		p[1] = DIGIT_PAIRS[pair + 1];
+	}
+	else
+	{
+		*--p = static_cast<char>('0' + value);
+	}
+
+	const auto length = static_cast<std::size_t>(end - p);
+	std::memcpy(claim(length), p, length);
+	commit(length);
+}
+
+/// <summary>
+/// Writes the buffered bytes to the handle and empties the buffer. Throws a Win32Error if the write fails (e.g. the reading end of a pipe was closed).
+/// </summary>
+void OutputBuffer::flush()
+{
+	std::size_t offset = 0;
+
+	while (offset < size_)
+	{
+		DWORD written = 0;
+
+		countSystemCall();
+		if (!::WriteFile(output_, data_.get() + offset, static_cast<DWORD>(size_ - offset), &written, nullptr))
+		{
+			size_ = 0;
+			throw Win32Error("WriteFile failed.");
+		}
+
+		offset += written;
+	}
+
+	size_ = 0;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/// <summary>
+/// Reusable byte buffer in front of a file or pipe handle. Output is accumulated in a fixed block and handed to WriteFile in large writes,
+/// so formatting rows never allocates and the number of write calls is independent of the number of rows.
+/// </summary>
+class OutputBuffer
+{
+public:
+	/// <summary>
+	/// Size of the buffer. Writes happen in chunks of this size.
+	/// </summary>
+	static constexpr std::size_t CAPACITY = 256 * 1024;
+
+	explicit OutputBuffer(HANDLE output);
+
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	~OutputBuffer() noexcept;
+
+	/// <summary>
+	/// Returns space for at least count bytes, flushing first if the buffer does not have that much left. Call commit() with the number of bytes actually written.
+	/// </summary>
+	/// <param name="count">The number of bytes needed; at most CAPACITY.</param>
+	/// <returns>A pointer to the free space.</returns>
+	[[nodiscard]] char* claim(std::size_t count)
+	{
+		if (CAPACITY - size_ < count)
+		{
+			flush();
+		}
+
+		return data_.get() + size_;
+	}
+
+	/// <summary>
+	/// Marks bytes written into the space returned by claim() as part of the output.
+	/// </summary>
+	/// <param name="count">The number of bytes written.</param>
+	void commit(std::size_t count) noexcept
+	{
+		size_ += count;
+	}
+
+	/// <summary>
+	/// Appends a single byte.
+	/// </summary>
+	/// <param name="c">The byte.</param>
+	void append(char c)
+	{
+		*claim(1) = c;
+		size_++;
+	}
+
+	void append(std::string_view text);
+
+	void appendUnsigned(std::uint64_t value);
+
+	void flush();
+
+private:
+	/// <summary>
+	/// The handle output is written to.
+	/// </summary>
+	HANDLE					output_;
+
+	/// <summary>
+	/// The buffer.
+	/// </summary>
+	std::unique_ptr<char[]>	data_;
+
+	/// <summary>
+	/// The number of buffered bytes.
+	/// </summary>
+	std::size_t				size_{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,293 @@
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iterator>
+#include <string>
+
+#include "PhaseProfiler.hpp"
+#include "ByteFormat.hpp"
+
+#pragma comment(lib, "Psapi.lib")
+
+/// <summary>
+/// Display names of the phases, indexed by Phase.
+/// </summary>
+constexpr const char* PHASE_NAMES[] = { "enumerate", "query", "regions", "render", "export" };
+
+static_assert(std::size(PHASE_NAMES) == static_cast<std::size_t>(Phase::Count));
+
+/// <summary>
+/// Returns the display name of a phase, as used in the statistics table and trace events.
+/// </summary>
+/// <param name="phase">The phase.</param>
+/// <returns>The name, a string literal.</returns>
+const char* phaseName(Phase phase) noexcept
+{
+	return phase < Phase::Count ? PHASE_NAMES[static_cast<std::size_t>(phase)] : "unknown";
+}
+
+/// <summary>
+/// Converts a FILETIME duration (100 ns units) to nanoseconds.
+/// </summary>
+/// <param name="time">The duration.</param>
+/// <returns>The duration in nanoseconds.</returns>
+static std::uint64_t fileTimeToNs(const FILETIME& time) noexcept
+{
+	return ((static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 100;
+}
+
+/// <summary>
+/// Reads the process-wide counters of the calling process. Counters that cannot be read are left at 0.
+/// </summary>
+/// <param name="sample">Receives the reading.</param>
+/// <returns>Which counters were read.</returns>
+CounterAvailability readProcessCounters(CounterSample& sample) noexcept
+{
+	CounterAvailability available;
+	const HANDLE self = ::GetCurrentProcess();
+
+	sample = {};
+	sample.wallNs = static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+
+	ULONG64 cycles = 0;
+
+	if (::QueryProcessCycleTime(self, &cycles))
+	{
+		sample.cycles = cycles;
+		available.cycles = true;
+	}
+
+	FILETIME creation{};
+	FILETIME exit{};
+	FILETIME kernel{};
+	FILETIME user{};
+
+	if (::GetProcessTimes(self, &creation, &exit, &kernel, &user))
+	{
+		sample.userNs = fileTimeToNs(user);
+		sample.kernelNs = fileTimeToNs(kernel);
+		available.times = true;
+	}
+
+	PROCESS_MEMORY_COUNTERS pmc{};
+
+	if (::GetProcessMemoryInfo(self, &pmc, sizeof(pmc)))
+	{
+		sample.pageFaults = pmc.PageFaultCount;
+		available.pageFaults = true;
+	}
+
+	return available;
+}
+
+/// <summary>
+/// Constructs a profiler and probes which counters are readable.
+/// </summary>
+PhaseProfiler::PhaseProfiler() noexcept
+	: backgroundStart_(readBackgroundResourceCounts())
+{
+	available_ = readProcessCounters(start_);
+}
+
+/// <summary>
+/// Starts measuring a phase. A phase that is still open is ended first.
+/// </summary>
+/// <param name="phase">The phase.</param>
+void PhaseProfiler::begin(Phase phase) noexcept
+{
+	if (current_ != Phase::Count)
+	{
+		end();
+	}
+
+	current_ = phase;
+	resourcesStart_ = readResourceCounts();
+	(void)readProcessCounters(start_);
+}
+
+/// <summary>
+/// Ends the current phase and adds its counter differences to the phase's totals.
+/// </summary>
+void PhaseProfiler::end() noexcept
+{
+	if (current_ == Phase::Count)
+	{
+		return;
+	}
+
+	CounterSample now;
+	(void)readProcessCounters(now);
+	const ResourceCounts resources = readResourceCounts();
+
+	PhaseTotals& phase = phases_[static_cast<std::size_t>(current_)];
+	phase.calls++;
+	phase.totals.wallNs += now.wallNs - start_.wallNs;
+	phase.totals.cycles += now.cycles - start_.cycles;
+	phase.totals.userNs += now.userNs - start_.userNs;
+	phase.totals.kernelNs += now.kernelNs - start_.kernelNs;
+
+	// PageFaultCount is a DWORD and may wrap; the difference is taken modulo 2^32.
+	phase.totals.pageFaults += static_cast<DWORD>(now.pageFaults - start_.pageFaults);
+	phase.resources += resources - resourcesStart_;
+
+	current_ = Phase::Count;
+}
+
+/// <summary>
+/// Writes the header of an allocation and system call table.
+/// </summary>
+/// <param name="out">The stream to write to.</param>
+/// <param name="label">The header of the first column.</param>
+static void writeResourceHeader(std::wostream& out, const wchar_t* label)
+{
+	out << std::left
+		<< std::setw(12) << label
+		<< std::setw(14) << L"Allocations"
+		<< std::setw(16) << L"Allocated"
+		<< std::setw(14) << L"Frees"
+		<< L"System calls"
+		<< L"\n";
+}
+
+/// <summary>
+/// Writes one row of an allocation and system call table.
+/// </summary>
+/// <param name="out">The stream to write to.</param>
+/// <param name="label">The phase or tick.</param>
+/// <param name="counts">The counts.</param>
+template <typename Label>
+static void writeResourceRow(std::wostream& out, const Label& label, const ResourceCounts& counts)
+{
+	out << std::left
+		<< std::setw(12) << label
+		<< std::setw(14) << counts.allocations
+		<< std::setw(16) << formatBytes(counts.allocatedBytes)
+		<< std::setw(14) << counts.frees
+		<< counts.systemCalls
+		<< L"\n";
+}
+
+/// <summary>
+/// Starts a tick.
+/// </summary>
+void PhaseProfiler::beginTick() noexcept
+{
+	tickStart_ = readResourceCounts();
+}
+
+/// <summary>
+/// Ends a tick and keeps its allocation and system call counts for the per-tick report.
+/// </summary>
+void PhaseProfiler::endTick()
+{
+	if constexpr (RESOURCE_COUNTERS_ENABLED)
+	{
+		const ResourceCounts tick = readResourceCounts() - tickStart_;
+		ticks_.push_back(tick);
+	}
+}
+
+/// <summary>
+/// Prints the per-phase counters as a table: calls, wall time, cycles, user and kernel CPU time, kernel share of CPU time and page faults.
+/// GetProcessTimes advances in scheduler ticks (about 15.6 ms), so CPU times of short phases are coarse; cycles are exact.
+/// </summary>
+/// <param name="out">The stream to write to.</param>
+void PhaseProfiler::print(std::wostream& out) const
+{
+	out << L"\nCollection phases (process-wide counters):\n\n";
+	out << std::left
+		<< std::setw(12) << L"Phase"
+		<< std::setw(8) << L"Calls"
+		<< std::setw(14) << L"Wall (ms)"
+		<< std::setw(16) << L"Mcycles"
+		<< std::setw(12) << L"User (ms)"
+		<< std::setw(12) << L"Kernel (ms)"
+		<< std::setw(10) << L"Kernel %"
+		<< L"Page faults"
+		<< L"\n";
+
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+	out << std::fixed << std::setprecision(2);
+
+	for (std::size_t i = 0; i < phases_.size(); i++)
+	{
+		const PhaseTotals& phase = phases_[i];
+
+		if (phase.calls == 0)
+		{
+			continue;
+		}
+
+		const CounterSample& t = phase.totals;
+
+		out << std::setw(12) << PHASE_NAMES[i]
+			<< std::setw(8) << phase.calls
+			<< std::setw(14) << static_cast<double>(t.wallNs) / 1e6;
+
+		if (available_.cycles)
+		{
+			out << std::setw(16) << static_cast<double>(t.cycles) / 1e6;
+		}
+		else
+		{
+			out << std::setw(16) << L"n/a";
+		}
+
+		if (available_.times)
+		{
+			const std::uint64_t cpuNs = t.userNs + t.kernelNs;
+
+			out << std::setw(12) << static_cast<double>(t.userNs) / 1e6
+				<< std::setw(12) << static_cast<double>(t.kernelNs) / 1e6
+				<< std::setw(10) << (cpuNs > 0 ? 100.0 * static_cast<double>(t.kernelNs) / static_cast<double>(cpuNs) : 0.0);
+		}
+		else
+		{
+			out << std::setw(12) << L"n/a" << std::setw(12) << L"n/a" << std::setw(10) << L"n/a";
+		}
+
+		if (available_.pageFaults)
+		{
+			out << t.pageFaults;
+		}
+		else
+		{
+			out << L"n/a";
+		}
+
+		out << L"\n";
+	}
+
+	out.flags(flags);
+	out.precision(precision);
+
+	if constexpr (RESOURCE_COUNTERS_ENABLED)
+	{
+		out << L"\nAllocations and system calls per phase:\n\n";
+		writeResourceHeader(out, L"Phase");
+
+		for (std::size_t i = 0; i < phases_.size(); i++)
+		{
+			if (phases_[i].calls > 0)
+			{
+				writeResourceRow(out, PHASE_NAMES[i], phases_[i].resources);
+			}
+		}
+
+		writeResourceRow(out, L"background", readBackgroundResourceCounts() - backgroundStart_);
+		out << L"\n\"background\" is the metadata resolver thread over the whole run; its work is not included in the phases or ticks.\n";
+
+		out << L"\nAllocations and system calls per tick:\n\n";
+		writeResourceHeader(out, L"Tick");
+
+		for (std::size_t tick = 0; tick < ticks_.size(); tick++)
+		{
+			writeResourceRow(out, std::to_wstring(tick), ticks_[tick]);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "ResourceCounters.hpp"
+#include "TraceRecorder.hpp"
+
+/// <summary>
+/// The phases of a tick that are profiled.
+/// </summary>
+enum class Phase : std::uint8_t
+{
+	Enumerate,
+	Query,
+	Regions,
+	Render,
+	Export,
+	Count
+};
+
+[[nodiscard]] const char* phaseName(Phase phase) noexcept;
+
+/// <summary>
+/// A reading of the process-wide CPU counters. Each counter is cumulative since process start, so the cost of an interval is
+/// the difference of two readings.
+/// </summary>
+struct CounterSample
+{
+	/// <summary>
+	/// Wall clock time, in nanoseconds of an arbitrary epoch.
+	/// </summary>
+	std::uint64_t	wallNs{ 0 };
+
+	/// <summary>
+	/// CPU cycles charged to all threads of the process (QueryProcessCycleTime), including cycles spent in the kernel.
+	/// </summary>
+	std::uint64_t	cycles{ 0 };
+
+	/// <summary>
+	/// User and kernel mode CPU time of all threads of the process, in nanoseconds.
+	/// </summary>
+	std::uint64_t	userNs{ 0 };
+	std::uint64_t	kernelNs{ 0 };
+
+	/// <summary>
+	/// Page faults (soft and hard) of the process.
+	/// </summary>
+	std::uint64_t	pageFaults{ 0 };
+};
+
+/// <summary>
+/// Which counters could be read. Some can be unavailable, e.g. in sandboxes that deny querying the process itself;
+/// unavailable counters read as 0 and are reported as "n/a".
+/// </summary>
+struct CounterAvailability
+{
+	bool	cycles{ false };
+	bool	times{ false };
+	bool	pageFaults{ false };
+};
+
+[[nodiscard]] CounterAvailability readProcessCounters(CounterSample& sample) noexcept;
+
+/// <summary>
+/// Accumulated counters of one phase.
+/// </summary>
+struct PhaseTotals
+{
+	/// <summary>
+	/// The number of measured intervals.
+	/// </summary>
+	std::uint64_t	calls{ 0 };
+
+	/// <summary>
+	/// The summed counter differences.
+	/// </summary>
+	CounterSample	totals;
+
+	/// <summary>
+	/// The summed allocation and system call counts; zero unless SNIFFER_RESOURCE_COUNTERS is defined.
+	/// </summary>
+	ResourceCounts	resources;
+};
+
+/// <summary>
+/// Attributes the tool's own CPU cost to the phases of a tick. Windows has no user-mode equivalent of perf_event_open for
+/// instructions or cache misses without a kernel trace session, so the profiler uses the counters the kernel keeps per
+/// process: cycles, user/kernel time (a high kernel share means the query loop is bound by system calls) and page faults.
+/// Phases must not nest; the CPU counters are process-wide, so work on other threads during a phase is charged to it. The
+/// allocation and system call counts of background threads are the exception: they are kept apart and reported on their own.
+/// </summary>
+class PhaseProfiler
+{
+public:
+	PhaseProfiler() noexcept;
+
+	void begin(Phase phase) noexcept;
+
+	void end() noexcept;
+
+	void beginTick() noexcept;
+
+	void endTick();
+
+	void print(std::wostream& out) const;
+
+	/// <summary>
+	/// Returns the totals of a phase.
+	/// </summary>
+	/// <param name="phase">The phase.</param>
+	/// <returns>The accumulated counters.</returns>
+	[[nodiscard]] const PhaseTotals& totals(Phase phase) const noexcept
+	{
+		return phases_[static_cast<std::size_t>(phase)];
+	}
+
+private:
+	/// <summary>
+	/// Counters per phase.
+	/// </summary>
+	std::array<PhaseTotals, static_cast<std::size_t>(Phase::Count)>	phases_{};
+
+	/// <summary>
+	/// Which counters are readable; probed on construction.
+	/// </summary>
+	CounterAvailability													available_;
+
+	/// <summary>
+	/// The phase being measured, or Phase::Count if none.
+	/// </summary>
+	Phase																current_{ Phase::Count };
+
+	/// <summary>
+	/// The reading taken when the current phase began.
+	/// </summary>
+	CounterSample														start_;
+
+	/// <summary>
+	/// The allocation and system call counts when the current phase and the current tick began.
+	/// </summary>
+	ResourceCounts														resourcesStart_;
+	ResourceCounts														tickStart_;
+
+	/// <summary>
+	/// The allocation and system call counts of background threads when the profiler was constructed; what they did since is
+	/// reported on its own rather than in the phases.
+	/// </summary>
+	ResourceCounts														backgroundStart_;
+
+	/// <summary>
+	/// The allocation and system call counts of each finished tick; only kept when SNIFFER_RESOURCE_COUNTERS is defined.
+	/// </summary>
+	std::vector<ResourceCounts>											ticks_;
+};
+
+/// <summary>
+/// Measures a phase for the lifetime of the scope and records it as a trace event. Does nothing for a null profiler or
+/// recorder, so call sites need no branches when profiling or tracing is off.
+/// </summary>
+class PhaseScope
+{
+public:
+	PhaseScope(PhaseProfiler* profiler, TraceRecorder* trace, Phase phase) noexcept
+		: profiler_(profiler), trace_(trace, phaseName(phase), "phase")
+	{
+		if (profiler_ != nullptr)
+		{
+			profiler_->begin(phase);
+		}
+	}
+
+	PhaseScope(const PhaseScope&) = delete;
+	PhaseScope& operator=(const PhaseScope&) = delete;
+
+	~PhaseScope() noexcept
+	{
+		if (profiler_ != nullptr)
+		{
+			profiler_->end();
+		}
+	}
+
+private:
+	/// <summary>
+	/// The profiler, or nullptr.
+	/// </summary>
+	PhaseProfiler*	profiler_;
+
+	/// <summary>
+	/// Records the trace event when destroyed, after the profiler has ended the phase.
+	/// </summary>
+	TraceScope		trace_;
+};
+
+/// <summary>
+/// Delimits one tick for the lifetime of the scope: records the tick's allocation and system call counts and a "tick" trace event.
+/// Does nothing for a null profiler or recorder.
+/// </summary>
+class TickScope
+{
+public:
+	TickScope(PhaseProfiler* profiler, TraceRecorder* trace) noexcept
+		: profiler_(profiler), trace_(trace, "tick", "tick")
+	{
+		if (profiler_ != nullptr)
+		{
+			profiler_->beginTick();
+		}
+	}
+
+	TickScope(const TickScope&) = delete;
+	TickScope& operator=(const TickScope&) = delete;
+
+	~TickScope()
+	{
+		if (profiler_ != nullptr)
+		{
+			profiler_->endTick();
+		}
+	}
+
+private:
+	/// <summary>
+	/// The profiler, or nullptr.
+	/// </summary>
+	PhaseProfiler*	profiler_;
+
+	/// <summary>
+	/// Records the tick's trace event when destroyed.
+	/// </summary>
+	TraceScope		trace_;
+};
\ No newline at end of file
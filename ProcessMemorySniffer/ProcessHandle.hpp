@@ -5,6 +5,9 @@
 #include <optional>
 #include <utility>
 
+#include "ProcessKey.hpp"
+#include "ResourceCounters.hpp"
+
 /// <summary>
 /// RAII wrapper for a Windows process HANDLE that manages it's lifetime and provides safe move semantics.
 /// </summary>
@@ -65,6 +68,7 @@ public:
 	/// <returns>A std::optional containing a ProcessHandle that wraps the native HANDLE on success; std::nullopt if the process handle could not be opened. The function is marked [[nodiscard]] so the result should not be ignored.</returns>
 	[[nodiscard]] static std::optional<ProcessHandle> open(DWORD pid) noexcept
 	{
+		countSystemCall();
 		HANDLE handle = ::OpenProcess(
 			PROCESS_QUERY_INFORMATION | PROCESS_VM_READ,
 			FALSE,
@@ -79,6 +83,24 @@ public:
 		return ProcessHandle(handle);
 	}
 
+	/// <summary>
+	/// Opens the process identified by a key, validating that the PID still belongs to the same process: a PID that was reused by a
+	/// newer process since the key was taken yields std::nullopt, as does an exited process.
+	/// </summary>
+	/// <param name="key">The process key.</param>
+	/// <returns>A ProcessHandle for the process; std::nullopt if it could not be opened or is no longer the keyed process.</returns>
+	[[nodiscard]] static std::optional<ProcessHandle> open(const ProcessKey& key) noexcept
+	{
+		auto handleOpt = open(key.pid);
+
+		if (handleOpt && queryProcessStartTime(handleOpt->get()) != key.startTime)
+		{
+			return std::nullopt;
+		}
+
+		return handleOpt;
+	}
+
 	/// <summary>
 	/// Returns the stored native HANDLE.
 	/// </summary>
@@ -104,6 +126,7 @@ private:
 	{
 		if (handle_)
 		{
+			countSystemCall();
 			::CloseHandle(handle_);
 			handle_ = nullptr;
 		}
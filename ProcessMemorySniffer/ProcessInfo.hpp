@@ -4,9 +4,17 @@
 
 #include <string>
 #include <cstddef>
+#include <cstdint>
+
+#include "ProcessKey.hpp"
 
 #define WIN32_LEAN_AND_MEAN
 
+/// <summary>
+/// The name and owner SID of a process whose metadata a MetadataResolver has not resolved yet.
+/// </summary>
+inline constexpr const wchar_t* PENDING_METADATA = L"<pending>";
+
 /// <summary>
 /// Defines Bytes as an alias for std::size_t.
 /// </summary>
@@ -22,11 +30,21 @@ struct ProcessInfo
 	/// </summary>
 	DWORD			pid{ 0 };
 
+	/// <summary>
+	/// The creation time of the process in 100 ns units since 1601-01-01 UTC, which tells a process apart from a later one reusing its PID; 0 if unknown.
+	/// </summary>
+	std::uint64_t	startTime{ 0 };
+
 	/// <summary>
 	/// The name of the process.
 	/// </summary>
 	std::wstring	name;
 
+	/// <summary>
+	/// The string SID of the user owning the process (the Windows analogue of a uid). Empty if the token could not be queried.
+	/// </summary>
+	std::wstring	userSid;
+
 	/// <summary>
 	/// The working set size of the process.
 	/// </summary>
@@ -36,4 +54,51 @@ struct ProcessInfo
 	/// The private bytes size of the process.
 	/// </summary>
 	Bytes			privateBytes{ 0 };
+
+	/// <summary>
+	/// The peak working set size of the process since it started.
+	/// </summary>
+	Bytes			peakWorkingSetBytes{ 0 };
+
+	/// <summary>
+	/// The paged pool the kernel has charged to the process (QuotaPagedPoolUsage): kernel objects, handle tables, registry data.
+	/// </summary>
+	Bytes			pagedPoolBytes{ 0 };
+
+	/// <summary>
+	/// The non-paged pool the kernel has charged to the process (QuotaNonPagedPoolUsage): socket buffers, I/O requests, events.
+	/// </summary>
+	Bytes			nonPagedPoolBytes{ 0 };
+
+	/// <summary>
+	/// Whether name and userSid are PENDING_METADATA placeholders because the process is still queued for resolution.
+	/// </summary>
+	bool			metadataPending{ false };
+
+	/// <summary>
+	/// Returns the kernel memory charged to the process. Page tables are not included: Windows does not report them per process.
+	/// </summary>
+	/// <returns>The paged plus non-paged pool usage.</returns>
+	[[nodiscard]] Bytes kernelBytes() const noexcept
+	{
+		return pagedPoolBytes + nonPagedPoolBytes;
+	}
+
+	/// <summary>
+	/// Returns what the process costs the system in memory: its private commit plus the kernel memory charged to it.
+	/// </summary>
+	/// <returns>The private bytes plus kernelBytes().</returns>
+	[[nodiscard]] Bytes trueCostBytes() const noexcept
+	{
+		return privateBytes + kernelBytes();
+	}
+
+	/// <summary>
+	/// Returns the key identifying the process across ticks.
+	/// </summary>
+	/// <returns>The PID and start time.</returns>
+	[[nodiscard]] ProcessKey key() const noexcept
+	{
+		return { pid, startTime };
+	}
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "ResourceCounters.hpp"
+
+/// <summary>
+/// Identifies a process across ticks. PIDs are reused as soon as a process exits, so on a busy host the same PID can name
+/// several processes over a run; together with the creation time the key is unique for the lifetime of the system.
+/// </summary>
+struct ProcessKey
+{
+	/// <summary>
+	/// The process identifier.
+	/// </summary>
+	DWORD			pid{ 0 };
+
+	/// <summary>
+	/// The creation time of the process (GetProcessTimes), in 100 ns units since 1601-01-01 UTC; 0 if unknown.
+	/// </summary>
+	std::uint64_t	startTime{ 0 };
+
+	[[nodiscard]] friend constexpr bool operator==(const ProcessKey&, const ProcessKey&) noexcept = default;
+};
+
+/// <summary>
+/// Hash of a ProcessKey for unordered containers. Start times of processes with the same PID differ in their low bits, so the
+/// two fields are mixed before the multiplication rather than combined with a plain XOR.
+/// </summary>
+struct ProcessKeyHash
+{
+	[[nodiscard]] std::size_t operator()(const ProcessKey& key) const noexcept
+	{
+		std::uint64_t h = (key.startTime ^ (static_cast<std::uint64_t>(key.pid) << 32 | key.pid)) * 0x9E3779B97F4A7C15ull;
+		h ^= h >> 29;
+		return static_cast<std::size_t>(h);
+	}
+};
+
+/// <summary>
+/// Reads the creation time of a process.
+/// </summary>
+/// <param name="process">Handle to the process. Must have PROCESS_QUERY_INFORMATION or PROCESS_QUERY_LIMITED_INFORMATION access.</param>
+/// <returns>The creation time in 100 ns units since 1601-01-01 UTC; std::nullopt if it could not be read.</returns>
+[[nodiscard]] inline std::optional<std::uint64_t> queryProcessStartTime(HANDLE process) noexcept
+{
+	FILETIME creation{};
+	FILETIME exit{};
+	FILETIME kernel{};
+	FILETIME user{};
+
+	countSystemCall();
+
+	if (!::GetProcessTimes(process, &creation, &exit, &kernel, &user))
+	{
+		return std::nullopt;
+	}
+
+	return (static_cast<std::uint64_t>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+}
\ No newline at end of file
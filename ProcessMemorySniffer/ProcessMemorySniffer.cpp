@@ -5,9 +5,35 @@
 #include <iomanip>
 #include <algorithm>
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <optional>
+#include <cstdint>
+#include <chrono>
 
 #include "ProcessMemorySniffer.hpp"
 #include "ProcessQueryService.hpp"
+#include "RegionQueryService.hpp"
+#include "RegionStats.hpp"
+#include "ModuleView.hpp"
+#include "AccountNameCache.hpp"
+#include "SamplingPlanner.hpp"
+#include "SketchStore.hpp"
+#include "SystemMemory.hpp"
+#include "HeavyHitters.hpp"
+#include "LiveView.hpp"
+#include "MetadataCache.hpp"
+#include "MetadataResolver.hpp"
+#include "ArrowStreamWriter.hpp"
+#include "ByteFormat.hpp"
+#include "CommandLineStore.hpp"
+#include "OutputBuffer.hpp"
+#include "PhaseProfiler.hpp"
+#include "ProcessHandle.hpp"
+#include "RowExporter.hpp"
+#include "TableColumns.hpp"
+#include "ThreadView.hpp"
+#include "TraceRecorder.hpp"
 #include "ProcessInfo.hpp"
 #include "Win32Error.hpp"
 
@@ -15,79 +41,1040 @@
 #define _UNICODE
 #define WIN32_LEAN_AND_MEAN
 
+
+/// <summary>
+/// The shortest time the first tick waits for process names and owners, used when --interval is shorter.
+/// </summary>
+constexpr std::chrono::milliseconds MIN_METADATA_WAIT{ 100 };
+
 /// <summary>
-/// Constant representing the maximum allowed length for a name, in characters.
+/// Selects the top processes by working set (physical RAM). Only the selected prefix is sorted.
 /// </summary>
-constexpr int MAX_NAME_LEN = 28;
+/// <param name="processes">A vector of ProcessInfo structures describing processes.</param>
+/// <param name="topN">Maximum number of entries to select. If greater than the number of processes, it is clamped to the available size.</param>
+/// <returns>The selected processes, sorted by descending working set.</returns>
+std::vector<ProcessInfo> selectTopByWorkingSet(const std::vector<ProcessInfo>& processes, std::size_t topN)
+{
+	topN = std::min(topN, processes.size());
+
+	std::vector<ProcessInfo> top(topN);
+	std::partial_sort_copy(processes.begin(), processes.end(), top.begin(), top.end(),
+		[](const ProcessInfo& a, const ProcessInfo& b)
+		{
+			return a.workingSetBytes > b.workingSetBytes;
+		});
+
+	return top;
+}
+
+/// <summary>
+/// Prints a table of the top processes sorted by working set (physical RAM) to the wide output stream, with the columns of one preset.
+/// </summary>
+/// <typeparam name="Columns">The ColumnList to print.</typeparam>
+/// <param name="top">The processes to print, already selected and sorted by selectTopByWorkingSet().</param>
+/// <param name="previous">Working sets by process key from the previous tick, for WorkingSetDeltaColumn.</param>
+/// <param name="accounts">Resolves the owner SID of each process to an account name.</param>
+/// <param name="commandLines">Reads the command line of each printed process for CommandLineColumn; nullptr for other presets.</param>
+template <typename Columns>
+static void printTopTable(const std::vector<ProcessInfo>& top, const std::unordered_map<ProcessKey, Bytes, ProcessKeyHash>& previous,
+	AccountNameCache& accounts, CommandLineStore* commandLines)
+{
+	Columns::writeHeader(std::wcout);
+
+	for (const auto& p : top)
+	{
+		const Bytes* previousWorkingSet = nullptr;
+
+		if constexpr (Columns::template CONTAINS<WorkingSetDeltaColumn>)
+		{
+			const auto it = previous.find(p.key());
+			previousWorkingSet = it != previous.end() ? &it->second : nullptr;
+		}
+
+		std::wstring_view commandLine;
+
+		if constexpr (Columns::template CONTAINS<CommandLineColumn>)
+		{
+			commandLine = commandLines->get(p.key());
+		}
+
+		Columns::writeRow(std::wcout, TableRow{ p, previousWorkingSet, accounts, commandLine });
+	}
+}
 
 /// <summary>
 /// Prints a table of the top processes sorted by working set (physical RAM) to the wide output stream.
 /// </summary>
-/// <param name="processes">A vector of ProcessInfo structures describing processes. If empty, a message is printed and the function returns.</param>
-/// <param name="topN">Maximum number of top entries to print. If greater than the number of processes, it is clamped to the available size.</param>
-static void printTopByWorkingSet(const std::vector<ProcessInfo>& processes, std::size_t topN)
+/// <param name="top">The processes to print, already selected and sorted by selectTopByWorkingSet(). If empty, a message is printed and the function returns.</param>
+/// <param name="columns">The column preset; selects the printTopTable() instantiation once per table.</param>
+/// <param name="previous">Working sets by process key from the previous tick.</param>
+/// <param name="accounts">Resolves the owner SID of each process to an account name.</param>
+/// <param name="commandLines">Reads command lines for the cmdline preset; nullptr for other presets.</param>
+static void printTopByWorkingSet(const std::vector<ProcessInfo>& top, ColumnPreset columns,
+	const std::unordered_map<ProcessKey, Bytes, ProcessKeyHash>& previous, AccountNameCache& accounts, CommandLineStore* commandLines)
 {
-	if (processes.empty())
+	if (top.empty())
 	{
 		std::wcout << L"No processes available.\n";
 		return;
 	}
 
-	auto sorted = processes;
-	std::sort(sorted.begin(), sorted.end(),
-		[](const ProcessInfo& a, const ProcessInfo& b)
+	std::wcout << L"Top " << top.size() << L" processes by working set (physical ram):\n\n";
+
+	switch (columns)
+	{
+	case ColumnPreset::Compact:
+		printTopTable<CompactColumns>(top, previous, accounts, commandLines);
+		break;
+	case ColumnPreset::Memory:
+		printTopTable<MemoryColumns>(top, previous, accounts, commandLines);
+		break;
+	case ColumnPreset::Full:
+		printTopTable<FullColumns>(top, previous, accounts, commandLines);
+		break;
+	case ColumnPreset::CommandLine:
+		printTopTable<CommandLineColumns>(top, previous, accounts, commandLines);
+		break;
+	default:
+		printTopTable<DefaultColumns>(top, previous, accounts, commandLines);
+		break;
+	}
+}
+
+/// <summary>
+/// Rounds a non-negative byte quantity computed in floating point (an estimate or a memory-seconds weight) to whole bytes for formatBytes().
+/// </summary>
+/// <param name="bytes">The quantity; negative values are clamped to 0.</param>
+/// <returns>The rounded quantity.</returns>
+static std::uint64_t roundBytes(double bytes)
+{
+	return bytes > 0.0 ? static_cast<std::uint64_t>(bytes + 0.5) : 0;
+}
+
+/// <summary>
+/// Prints the estimated totals of an approximate tick with their 95% confidence intervals, and what the top-N guarantee covers.
+/// </summary>
+/// <param name="estimate">The estimate returned by SamplingPlanner::record().</param>
+/// <param name="heavyThresholdMB">The heavy hitter threshold in MiB.</param>
+static void printEstimate(const SampleEstimate& estimate, std::size_t heavyThresholdMB)
+{
+	std::wcout << L"\nApproximate: queried " << estimate.heavyCount << L" heavy hitters and "
+		<< estimate.sampledCount << L" sampled of " << estimate.population << L" processes.\n"
+		<< L"Estimated total working set: " << formatBytes(roundBytes(estimate.workingSetBytes.value))
+		<< L" +/- " << formatBytes(roundBytes(estimate.workingSetBytes.margin)) << L" (95% CI)\n"
+		<< L"Estimated total private:     " << formatBytes(roundBytes(estimate.privateBytes.value))
+		<< L" +/- " << formatBytes(roundBytes(estimate.privateBytes.margin)) << L" (95% CI)\n"
+		<< L"Top list is exact for processes with working set >= " << heavyThresholdMB
+		<< L" MiB once they have been sampled.\n";
+}
+
+/// <summary>
+/// Returns a part of the physical memory in whole percent.
+/// </summary>
+/// <param name="bytes">The part.</param>
+/// <param name="memory">The system memory figures.</param>
+/// <returns>bytes * 100 / physical total, 0 if the total is unknown.</returns>
+static std::uint64_t percentOfRam(std::uint64_t bytes, const SystemMemory& memory)
+{
+	return memory.physicalTotalBytes == 0 ? 0 : bytes * 100 / memory.physicalTotalBytes;
+}
+
+/// <summary>
+/// Prints the system-wide memory figures and reconciles them with the processes of the same tick: the share of RAM the printed
+/// and all processes hold, and what remains in use that neither the process working sets, the system working set nor the
+/// non-paged pool account for. Working sets count shared pages (DLLs, mapped files) once per process, so the remainder may be
+/// negative. The system cache of GetPerformanceInfo includes the standby list, which is available rather than in use, so it is
+/// shown on its own and kept out of the reconciliation.
+/// </summary>
+/// <param name="memory">The figures, sampled right after the processes.</param>
+/// <param name="processes">The processes collected on the tick.</param>
+/// <param name="top">The printed processes.</param>
+/// <param name="estimate">In the approximate mode, the estimated totals, used instead of the sampled sums; otherwise nullptr.</param>
+static void printSystemSummary(const SystemMemory& memory, const std::vector<ProcessInfo>& processes,
+	const std::vector<ProcessInfo>& top, const SampleEstimate* estimate)
+{
+	std::uint64_t topWorkingSet = 0;
+	std::uint64_t allWorkingSet = 0;
+
+	for (const auto& p : top)
+	{
+		topWorkingSet += p.workingSetBytes;
+	}
+
+	for (const auto& p : processes)
+	{
+		allWorkingSet += p.workingSetBytes;
+	}
+
+	if (estimate != nullptr)
+	{
+		allWorkingSet = roundBytes(estimate->workingSetBytes.value);
+	}
+
+	const std::uint64_t inUse = memory.physicalInUseBytes();
+	const std::uint64_t accounted = allWorkingSet + memory.systemWorkingSetBytes.value_or(0) + memory.kernelNonPagedBytes;
+
+	std::wcout << L"\nSystem: " << formatBytes(inUse) << L" of " << formatBytes(memory.physicalTotalBytes)
+		<< L" RAM in use (" << percentOfRam(inUse, memory) << L"%), commit " << formatBytes(memory.commitTotalBytes)
+		<< L" of " << formatBytes(memory.commitLimitBytes) << L"\n\n";
+
+	std::wcout << std::left
+		<< std::setw(32) << (L"Top " + std::to_wstring(top.size()) + L" processes (working set)")
+		<< std::setw(16) << formatBytes(topWorkingSet)
+		<< percentOfRam(topWorkingSet, memory) << L"% of RAM\n"
+		<< std::setw(32) << (estimate != nullptr
+			? std::to_wstring(estimate->population) + L" processes (estimated)"
+			: std::to_wstring(processes.size()) + L" of " + std::to_wstring(memory.processCount) + L" processes")
+		<< std::setw(16) << formatBytes(allWorkingSet)
+		<< percentOfRam(allWorkingSet, memory) << L"% of RAM\n"
+		<< std::setw(32) << L"System working set (file cache)";
+
+	if (memory.systemWorkingSetBytes)
+	{
+		std::wcout << std::setw(16) << formatBytes(*memory.systemWorkingSetBytes)
+			<< percentOfRam(*memory.systemWorkingSetBytes, memory) << L"% of RAM\n";
+	}
+	else
+	{
+		std::wcout << L"n/a\n";
+	}
+
+	std::wcout << std::left
+		<< std::setw(32) << L"Kernel non-paged pool"
+		<< std::setw(16) << formatBytes(memory.kernelNonPagedBytes)
+		<< percentOfRam(memory.kernelNonPagedBytes, memory) << L"% of RAM\n"
+		<< std::setw(32) << L"Kernel paged pool (not all resident)"
+		<< formatBytes(memory.kernelPagedBytes) << L"\n"
+		<< std::setw(32) << L"Unattributed"
+		<< formatByteDelta(static_cast<std::int64_t>(inUse) - static_cast<std::int64_t>(accounted))
+		<< L"\n"
+		<< std::setw(32) << L"System cache (incl. standby)"
+		<< formatBytes(memory.systemCacheBytes) << L", partly available\n";
+
+	std::wcout << L"\nUnattributed = in use - process working sets - system working set - non-paged pool: page tables, drivers\n"
+		<< L"and processes that could not be opened; negative when shared pages are counted in several working sets.\n"
+		<< L"The system cache also counts standby pages, which are available memory, so it is not part of the sum.\n";
+
+	if (!memory.systemWorkingSetBytes)
+	{
+		std::wcout << L"The system working set could not be queried and is included in Unattributed.\n";
+	}
+}
+
+/// <summary>
+/// Prints working set quantiles per process name from a sketch store, for the names with the highest p99.
+/// </summary>
+/// <param name="store">The sketch store.</param>
+/// <param name="topN">Maximum number of names to print.</param>
+static void printSummary(const SketchStore& store, std::size_t topN)
+{
+	struct Row
+	{
+		const std::wstring* name;
+		const QuantileSketch* sketch;
+		std::uint64_t p99;
+	};
+
+	std::vector<Row> rows;
+	rows.reserve(store.sketches().size());
+
+	for (const auto& [name, sketch] : store.sketches())
+	{
+		rows.push_back({ &name, &sketch, sketch.quantile(0.99) });
+	}
+
+	topN = std::min(topN, rows.size());
+	std::partial_sort(rows.begin(), rows.begin() + topN, rows.end(),
+		[](const Row& a, const Row& b)
+		{
+			return a.p99 > b.p99;
+		});
+
+	std::wcout << L"\nWorking set quantiles by process name (top " << topN << L" by p99):\n\n";
+	std::wcout << std::left
+		<< std::setw(30) << L"Process"
+		<< std::setw(12) << L"Samples"
+		<< std::setw(14) << L"p50"
+		<< std::setw(14) << L"p95"
+		<< std::setw(14) << L"p99"
+		<< L"\n";
+
+	for (std::size_t i = 0; i < topN; i++)
+	{
+		const auto& row = rows[i];
+
+		std::wcout << std::left
+			<< std::setw(30) << displayNameOf(*row.name)
+			<< std::setw(12) << row.sketch->count()
+			<< std::setw(14) << formatBytes(row.sketch->quantile(0.50))
+			<< std::setw(14) << formatBytes(row.sketch->quantile(0.95))
+			<< std::setw(14) << formatBytes(row.p99)
+			<< L"\n";
+	}
+}
+
+/// <summary>
+/// Prints the executables that accumulated the most working set memory-seconds, with the guaranteed lower bound of each estimate.
+/// </summary>
+/// <param name="hitters">The heavy hitter summary.</param>
+/// <param name="topN">Maximum number of executables to print.</param>
+static void printHeavyHitters(const HeavyHitters& hitters, std::size_t topN)
+{
+	const auto top = hitters.top(topN);
+
+	std::wcout << L"\nTop " << top.size() << L" executables by accumulated working set (memory-seconds):\n\n";
+	std::wcout << std::left
+		<< std::setw(30) << L"Process"
+		<< std::setw(18) << L"Bytes*s"
+		<< std::setw(18) << L"At least (Bytes*s)"
+		<< L"Share (%)"
+		<< L"\n";
+
+	for (const auto& hitter : top)
+	{
+		// Shares are printed in hundredths of a percent, rounded, so the output does not depend on the stream's float settings.
+		const std::uint64_t share = hitters.totalWeight() > 0.0 ? roundBytes(10000.0 * hitter.weight / hitters.totalWeight()) : 0;
+
+		std::wcout << std::left
+			<< std::setw(30) << displayNameOf(hitter.key)
+			<< std::setw(18) << formatBytes(roundBytes(hitter.weight))
+			<< std::setw(18) << formatBytes(roundBytes(hitter.weight - hitter.error))
+			<< share / 100 << L'.' << std::setw(2) << std::setfill(L'0') << std::right << share % 100 << std::setfill(L' ')
+			<< L"\n";
+	}
+}
+
+/// <summary>
+/// Memory totals of all processes owned by one user.
+/// </summary>
+struct UserUsage
+{
+	/// <summary>
+	/// The string SID of the user.
+	/// </summary>
+	std::wstring	userSid;
+
+	/// <summary>
+	/// The number of processes owned by the user.
+	/// </summary>
+	std::size_t		processCount{ 0 };
+
+	/// <summary>
+	/// The summed working set of the user's processes.
+	/// </summary>
+	Bytes			workingSetBytes{ 0 };
+
+	/// <summary>
+	/// The summed private bytes of the user's processes.
+	/// </summary>
+	Bytes			privateBytes{ 0 };
+};
+
+/// <summary>
+/// Prints memory totals per user over all collected processes, sorted by descending working set. Shared pages are counted once per process, so working set totals overstate physical usage when users share images.
+/// Processes whose owner is still pending are left out of the totals and only counted in a note below the table.
+/// </summary>
+/// <param name="processes">All collected processes.</param>
+/// <param name="accounts">Resolves owner SIDs to account names.</param>
+static void printByUser(const std::vector<ProcessInfo>& processes, AccountNameCache& accounts)
+{
+	std::unordered_map<std::wstring, UserUsage> bySid;
+	std::size_t pending = 0;
+
+	for (const auto& p : processes)
+	{
+		if (p.metadataPending)
+		{
+			pending++;
+			continue;
+		}
+
+		auto& usage = bySid[p.userSid];
+		usage.processCount++;
+		usage.workingSetBytes += p.workingSetBytes;
+		usage.privateBytes += p.privateBytes;
+	}
+
+	std::vector<UserUsage> users;
+	users.reserve(bySid.size());
+
+	for (auto& [sid, usage] : bySid)
+	{
+		usage.userSid = sid;
+		users.push_back(std::move(usage));
+	}
+
+	std::sort(users.begin(), users.end(),
+		[](const UserUsage& a, const UserUsage& b)
 		{
 			return a.workingSetBytes > b.workingSetBytes;
 		});
 
-	topN = std::min(topN, sorted.size());
+	std::wcout << L"\nMemory by user:\n\n";
+	std::wcout << std::left
+		<< std::setw(12) << L"Processes"
+		<< std::setw(16) << L"Working Set"
+		<< std::setw(16) << L"Private"
+		<< L"User"
+		<< L"\n";
+
+	for (const auto& user : users)
+	{
+		std::wcout << std::left
+			<< std::setw(12) << user.processCount
+			<< std::setw(16) << formatBytes(user.workingSetBytes)
+			<< std::setw(16) << formatBytes(user.privateBytes)
+			<< accounts.resolve(user.userSid)
+			<< L"\n";
+	}
+
+	if (pending > 0)
+	{
+		std::wcout << L"\n" << pending << L" processes whose owner is not resolved yet are not included.\n";
+	}
+}
 
-	std::wcout << L"Top " << topN << L" processes by working set (physical ram):\n\n";
+/// <summary>
+/// Formats a histogram bucket boundary as a short label such as "64K", "2M" or "1G".
+/// </summary>
+/// <param name="bytes">The boundary in bytes; a power of two of at least 1 KiB.</param>
+/// <returns>The label.</returns>
+static std::wstring formatBucketLabel(std::uint64_t bytes)
+{
+	constexpr const wchar_t* suffixes[] = { L"K", L"M", L"G", L"T" };
+
+	std::size_t unit = 0;
+	bytes /= 1024;
+
+	while (bytes >= 1024 && unit + 1 < std::size(suffixes))
+	{
+		bytes /= 1024;
+		unit++;
+	}
+
+	return std::to_wstring(bytes) + suffixes[unit];
+}
+
+/// <summary>
+/// Prints the non-empty buckets of a region histogram on a single line, e.g. "<=4K:120 <=64K:8 >32G:1".
+/// </summary>
+/// <param name="label">The line label.</param>
+/// <param name="histogram">The histogram to print.</param>
+static void printHistogram(const wchar_t* label, const RegionHistogram& histogram)
+{
+	std::wcout << L"    " << label;
+
+	for (std::size_t bucket = 0; bucket < histogram.size(); bucket++)
+	{
+		if (histogram[bucket] == 0)
+		{
+			continue;
+		}
+
+		const bool last = bucket + 1 == histogram.size();
+		std::wcout << L' ' << (last ? L">" : L"<=") << formatBucketLabel(regionHistogramBucketCeiling(bucket))
+			<< L':' << histogram[bucket];
+	}
+
+	std::wcout << L"\n";
+}
+
+/// <summary>
+/// Walks the address space of each printed process and prints its region statistics: region and allocation counts, committed and reserved sizes, regions added and removed since the previous tick, and the size and gap histograms.
+/// </summary>
+/// <param name="top">The printed processes.</param>
+/// <param name="regionService">The service used to walk the address spaces.</param>
+/// <param name="tracker">Keeps each process' region list between ticks for churn reporting.</param>
+/// <param name="trace">Records address space walks that exceed its slow-query threshold; may be nullptr.</param>
+static void printRegionStats(const std::vector<ProcessInfo>& top, const RegionQueryService& regionService, RegionTracker& tracker,
+	TraceRecorder* trace)
+{
+	std::wcout << L"\nVirtual memory regions:\n\n";
 	std::wcout << std::left
 		<< std::setw(8) << L"PID"
 		<< std::setw(30) << L"Process"
-		<< std::setw(16) << L"WorkingSet (MB)"
-		<< std::setw(16) << L"Private (MB)"
+		<< std::setw(10) << L"Regions"
+		<< std::setw(10) << L"Allocs"
+		<< std::setw(16) << L"Committed"
+		<< std::setw(16) << L"Reserved"
+		<< std::setw(10) << L"Added"
+		<< std::setw(10) << L"Removed"
 		<< L"\n";
 
-	std::wcout.setf(std::ios::fixed);
-	std::wcout << std::setprecision(2);
+	std::vector<MemoryRegion> regions;
+
+	for (const auto& p : top)
+	{
+		const std::uint64_t start = trace != nullptr ? trace->now() : 0;
+		const bool collected = regionService.collectRegions(p.key(), regions);
+
+		if (trace != nullptr)
+		{
+			trace->recordQuery("regions", p.pid, p.name, start, trace->now());
+		}
+
+		if (!collected)
+		{
+			continue;
+		}
+
+		const auto stats = tracker.update(p.key(), std::move(regions));
+		regions = {};
+
+		std::wcout << std::left
+			<< std::setw(8) << p.pid
+			<< std::setw(30) << displayNameOf(p.name)
+			<< std::setw(10) << stats.regionCount
+			<< std::setw(10) << stats.allocationCount
+			<< std::setw(16) << formatBytes(stats.committedBytes)
+			<< std::setw(16) << formatBytes(stats.reservedBytes);
+
+		if (stats.hasBaseline)
+		{
+			std::wcout << std::setw(10) << stats.added << std::setw(10) << stats.removed;
+		}
+		else
+		{
+			std::wcout << std::setw(10) << L"-" << std::setw(10) << L"-";
+		}
+
+		std::wcout << L"\n";
+
+		printHistogram(L"sizes:", stats.sizeHistogram);
+		printHistogram(L"gaps: ", stats.gapHistogram);
+	}
+
+	tracker.endTick();
+}
+
+/// <summary>
+/// Returns the executable file name of a process from its module list (the first module is the executable).
+/// </summary>
+/// <param name="view">The module view.</param>
+/// <param name="modules">The module list of the process.</param>
+/// <returns>The executable file name, or "<unknown>" if the module list is empty.</returns>
+static std::wstring executableNameOf(const ModuleView& view, const ProcessModules& modules)
+{
+	if (modules.modules.empty())
+	{
+		return L"<unknown>";
+	}
+
+	const std::wstring& path = view.paths().lookup(modules.modules.front().path);
+	const auto slash = path.find_last_of(L'\\');
+
+	return slash == std::wstring::npos ? path : path.substr(slash + 1);
+}
+
+/// <summary>
+/// Prints the modules loaded by the most processes, followed by totals showing how much sharing the module view found.
+/// </summary>
+/// <param name="view">The collected module view.</param>
+/// <param name="topN">Maximum number of modules to print.</param>
+static void printModuleSummary(const ModuleView& view, std::size_t topN)
+{
+	std::vector<StringId> modules(view.paths().size());
+	std::size_t references = 0;
+
+	for (StringId id = 0; id < modules.size(); id++)
+	{
+		modules[id] = id;
+		references += view.processesWith(id).size();
+	}
+
+	topN = std::min(topN, modules.size());
+	std::partial_sort(modules.begin(), modules.begin() + topN, modules.end(),
+		[&view](StringId a, StringId b)
+		{
+			return view.processesWith(a).size() > view.processesWith(b).size();
+		});
+
+	std::wcout << L"Top " << topN << L" modules by number of processes:\n\n";
+	std::wcout << std::left
+		<< std::setw(12) << L"Processes"
+		<< L"Module"
+		<< L"\n";
 
 	for (std::size_t i = 0; i < topN; i++)
 	{
-		const auto& p = sorted[i];
+		std::wcout << std::left
+			<< std::setw(12) << view.processesWith(modules[i]).size()
+			<< view.paths().lookup(modules[i])
+			<< L"\n";
+	}
 
-		const double wsMB = static_cast<double>(p.workingSetBytes) / (1024.0 * 1024.0);
-		const double privMB = static_cast<double>(p.privateBytes) / (1024.0 * 1024.0);
+	std::wcout << L"\n" << view.processes().size() << L" processes, "
+		<< view.paths().size() << L" distinct modules, "
+		<< references << L" module references.\n";
+}
 
-		std::wstring displayName = p.name;
+/// <summary>
+/// Prints, for every loaded module matching a name or path, the processes that have it loaded and where it is mapped.
+/// </summary>
+/// <param name="view">The collected module view.</param>
+/// <param name="nameOrPath">The module file name or full path to search for.</param>
+static void printLoadedBy(const ModuleView& view, const std::wstring& nameOrPath)
+{
+	const auto matches = view.findModules(nameOrPath);
 
-		if (displayName.size() > MAX_NAME_LEN)
+	if (matches.empty())
+	{
+		std::wcout << L"No process has " << nameOrPath << L" loaded.\n";
+		return;
+	}
+
+	for (StringId module : matches)
+	{
+		const auto pids = view.processesWith(module);
+
+		std::wcout << view.paths().lookup(module) << L" (" << pids.size() << L" processes):\n\n";
+		std::wcout << std::left
+			<< std::setw(8) << L"PID"
+			<< std::setw(30) << L"Process"
+			<< std::setw(20) << L"Base"
+			<< L"Size"
+			<< L"\n";
+
+		for (DWORD pid : pids)
 		{
-			displayName = displayName.substr(0, MAX_NAME_LEN - 1) + L"...";
+			const ProcessModules* modules = view.findProcess(pid);
+
+			const auto entry = std::find_if(modules->modules.begin(), modules->modules.end(),
+				[module](const ModuleEntry& e)
+				{
+					return e.path == module;
+				});
+
+			std::wcout << std::left
+				<< std::setw(8) << pid
+				<< std::setw(30) << displayNameOf(executableNameOf(view, *modules))
+				<< L"0x" << std::setw(18) << std::hex << entry->base << std::dec
+				<< formatBytes(entry->size)
+				<< L"\n";
 		}
 
+		std::wcout << L"\n";
+	}
+}
+
+/// <summary>
+/// Prints a line with the totals of a group of allocations.
+/// </summary>
+/// <param name="label">The group.</param>
+/// <param name="totals">The totals.</param>
+static void printAllocationTotals(const wchar_t* label, const AllocationTotals& totals)
+{
+	std::wcout << std::left
+		<< std::setw(24) << label
+		<< std::setw(8) << totals.count
+		<< std::setw(16) << formatBytes(totals.reservedBytes)
+		<< formatBytes(totals.committedBytes)
+		<< L"\n";
+}
+
+/// <summary>
+/// Prints the thread stacks of a process, largest committed first, followed by the totals of its stacks and of its heap-like
+/// and other private allocations.
+/// </summary>
+/// <param name="view">The collected thread view.</param>
+/// <param name="pid">The PID of the process.</param>
+/// <param name="name">The name of the process.</param>
+/// <param name="topN">Maximum number of threads to print.</param>
+static void printThreadView(const ThreadView& view, DWORD pid, const std::wstring& name, std::size_t topN)
+{
+	std::vector<const ThreadStack*> stacks;
+	stacks.reserve(view.stacks().size());
+
+	for (const auto& stack : view.stacks())
+	{
+		stacks.push_back(&stack);
+	}
+
+	topN = std::min(topN, stacks.size());
+	std::partial_sort(stacks.begin(), stacks.begin() + topN, stacks.end(),
+		[](const ThreadStack* a, const ThreadStack* b)
+		{
+			return a->committedBytes > b->committedBytes;
+		});
+
+	std::wcout << name << L" (PID " << pid << L"): " << view.stacks().size() << L" thread stacks"
+		<< (view.wow64() ? L" (32-bit, WOW64)" : L"") << L"\n\n";
+	std::wcout << std::left
+		<< std::setw(10) << L"TID"
+		<< std::setw(16) << L"Reserved"
+		<< std::setw(16) << L"Committed"
+		<< std::setw(8) << L"Guard"
+		<< L"Range"
+		<< L"\n";
+
+	for (std::size_t i = 0; i < topN; i++)
+	{
+		const ThreadStack& stack = *stacks[i];
+
 		std::wcout << std::left
-			<< std::setw(8) << p.pid
-			<< std::setw(30) << displayName
-			<< std::setw(16) << wsMB
-			<< std::setw(16) << privMB
+			<< std::setw(10) << stack.tid
+			<< std::setw(16) << formatBytes(stack.reservedBytes)
+			<< std::setw(16) << formatBytes(stack.committedBytes)
+			<< std::setw(8) << (stack.hasGuard ? L"yes" : L"no")
+			<< L"0x" << std::hex << stack.limit << L"-0x" << stack.top << std::dec
 			<< L"\n";
 	}
+
+	if (view.unreadableThreads() > 0)
+	{
+		std::wcout << view.unreadableThreads() << L" threads could not be read (exited or access denied).\n";
+	}
+
+	std::wcout << L"\n" << std::left
+		<< std::setw(24) << L"Allocations"
+		<< std::setw(8) << L"Count"
+		<< std::setw(16) << L"Reserved"
+		<< L"Committed"
+		<< L"\n";
+
+	printAllocationTotals(L"Thread stacks", view.stackTotals());
+	printAllocationTotals(L"Heaps / arenas", view.arenaTotals());
+	printAllocationTotals(L"Other private", view.otherPrivateTotals());
+
+	std::wcout << L"\nHeaps / arenas: private read/write allocations of at least " << formatBytes(ThreadView::MIN_ARENA_BYTES, 0)
+		<< L" reserved, not stacks. Windows heaps are shared by all threads, so they are not attributed per thread.\n";
 }
 
 /// <summary>
-/// Collects processes and prints the top processes by working set. Returns EXIT_SUCCESS on success or EXIT_FAILURE if an exception occurs.
+/// Collects processes and prints the top processes by working set once per tick, optionally followed by region statistics. In module mode the module view is collected and printed once instead. Returns EXIT_SUCCESS on success or EXIT_FAILURE if an exception occurs.
 /// </summary>
-/// <param name="topN">The requested number of top processes to print. Note: this parameter is currently ignored because a local constexpr topN = 15 shadows it, so the function always prints the top 15 processes.</param>
+/// <param name="options">The run options: number of processes to print, number of ticks, tick interval and which reports to print.</param>
 /// <returns>EXIT_SUCCESS if processing and printing complete without exceptions; EXIT_FAILURE if a Win32 error or other std::exception is thrown.</returns>
-int runSniffer(std::size_t topN)
+int runSniffer(const SnifferOptions& options)
 {
 	try
 	{
 		ProcessQueryService service;
-		const auto processes = service.collectProcesses();
-		printTopByWorkingSet(processes, topN);
+		RegionQueryService regionService;
+		RegionTracker regionTracker;
+		AccountNameCache accounts;
+		std::optional<SamplingPlanner> sampler;
+		std::optional<SketchStore> summary;
+		std::optional<HeavyHitters> heavyHitters;
+		std::optional<PhaseProfiler> profiler;
+		std::optional<TraceRecorder> tracer;
+		std::optional<MetadataCache> metadataCache;
+		std::optional<MetadataResolver> resolver;
+		std::optional<CommandLineStore> commandLines;
+
+		if (options.heavyHitterCapacity > 0)
+		{
+			heavyHitters.emplace(options.heavyHitterCapacity);
+
+			if (!options.heavyHitterFile.empty())
+			{
+				heavyHitters->merge(HeavyHitters::load(options.heavyHitterFile));
+
+				for (const auto& file : options.heavyHitterMergeFiles)
+				{
+					heavyHitters->merge(HeavyHitters::load(file));
+				}
+			}
+		}
+
+		if (!options.summaryFile.empty())
+		{
+			summary = SketchStore::load(options.summaryFile);
+
+			for (const auto& file : options.mergeFiles)
+			{
+				summary->merge(SketchStore::load(file));
+			}
+		}
+
+		if (options.sampleSize > 0)
+		{
+			const std::uint64_t threshold = static_cast<std::uint64_t>(options.heavyThresholdMB) * 1024 * 1024;
+			sampler.emplace(options.sampleSize, static_cast<Bytes>(std::min<std::uint64_t>(threshold, SIZE_MAX)));
+		}
+
+		if (options.showModules || !options.loadedBy.empty())
+		{
+			const auto view = ModuleView::collect(service.enumerateProcessIds());
+
+			if (options.showModules)
+			{
+				printModuleSummary(view, options.topN);
+			}
+
+			if (!options.loadedBy.empty())
+			{
+				printLoadedBy(view, options.loadedBy);
+			}
+
+			return EXIT_SUCCESS;
+		}
+
+		if (options.threadsPid != 0)
+		{
+			const auto view = ThreadView::collect(regionService, options.threadsPid);
+
+			if (!view)
+			{
+				std::wcout << L"Process " << options.threadsPid << L" could not be opened.\n";
+				return EXIT_FAILURE;
+			}
+
+			auto handleOpt = ProcessHandle::open(options.threadsPid);
+			const std::wstring name = handleOpt ? ProcessQueryService::tryGetProcessName(handleOpt->get()) : L"<unknown>";
+
+			printThreadView(*view, options.threadsPid, name, options.topN);
+			return EXIT_SUCCESS;
+		}
+
+		if (options.showStats)
+		{
+			profiler.emplace();
+		}
+
+		if (!options.traceFile.empty())
+		{
+			tracer.emplace(std::chrono::microseconds(options.traceSlowQueryUs));
+			service.attachTrace(&*tracer);
+		}
+
+		PhaseProfiler* const phases = profiler ? &*profiler : nullptr;
+		TraceRecorder* const trace = tracer ? &*tracer : nullptr;
+
+		// With --no-cache the resolver still needs somewhere to keep what it resolved during the run; an empty path is never saved.
+		metadataCache.emplace(options.useMetadataCache ? MetadataCache::defaultPath() : std::wstring{});
+		metadataCache->primeAccounts(accounts);
+		resolver.emplace(*metadataCache, trace);
+		service.attachResolver(&*resolver);
+
+		if (options.liveView)
+		{
+			// No wait here: the first frame shows "<pending>" names, which fill in on the following refreshes.
+			runLiveView(options, service, accounts);
+			resolver->stop();
+			(void)metadataCache->save(accounts);
+
+			return EXIT_SUCCESS;
+		}
+
+		std::optional<OutputBuffer> exportBuffer;
+		std::optional<RowExporter> exporter;
+		std::optional<ArrowStreamWriter> arrowWriter;
+
+		if (options.format == OutputFormat::Arrow)
+		{
+			exportBuffer.emplace(::GetStdHandle(STD_OUTPUT_HANDLE));
+			arrowWriter.emplace(*exportBuffer);
+		}
+		else if (options.format != OutputFormat::Table)
+		{
+			exportBuffer.emplace(::GetStdHandle(STD_OUTPUT_HANDLE));
+			exporter.emplace(options.format == OutputFormat::Csv ? ExportFormat::Csv : ExportFormat::Ndjson, *exportBuffer);
+			exporter->writeHeader();
+		}
+
+		if (options.columns == ColumnPreset::CommandLine)
+		{
+			commandLines.emplace(options.commandLineMaxLength);
+		}
+
+		auto lastTick = std::chrono::steady_clock::now();
+		std::unordered_map<ProcessKey, Bytes, ProcessKeyHash> previousWorkingSets;
+
+		for (std::size_t tick = 0; tick < options.ticks; tick++)
+		{
+			if (tick > 0)
+			{
+				::Sleep(options.intervalMs);
+
+				if (!exportBuffer)
+				{
+					std::wcout << L"\n";
+				}
+			}
+
+			TickScope tickScope(phases, trace);
+			std::vector<ProcessInfo> processes;
+			std::optional<SampleEstimate> estimate;
+			std::optional<SystemMemory> systemMemory;
+
+			std::vector<DWORD> enumerated;
+			std::vector<DWORD> pids;
+
+			{
+				PhaseScope scope(phases, trace, Phase::Enumerate);
+				enumerated = service.enumerateProcessIds();
+				pids = sampler ? sampler->plan(enumerated) : enumerated;
+			}
+
+			{
+				PhaseScope scope(phases, trace, Phase::Query);
+				processes = service.collectProcesses(pids);
+
+				// Right after the processes, so the system figures and the process sums describe the same moment.
+				if (options.showSystem)
+				{
+					systemMemory = querySystemMemory();
+				}
+
+				// On the first tick nearly every process is pending, so wait for the names once, for at most one interval: a hung
+				// query must not stall a one-shot run, and what is not resolved by then is printed as "<pending>". Later ticks
+				// never wait and show "<pending>" for the few processes that started since the previous tick.
+				if (tick == 0)
+				{
+					(void)resolver->waitUntilIdle(std::max(std::chrono::milliseconds(options.intervalMs), MIN_METADATA_WAIT));
+				}
+
+				resolver->fill(processes);
+				resolver->retain(enumerated, processes);
+			}
+
+			if (sampler)
+			{
+				estimate = sampler->record(processes);
+			}
+
+			if (summary)
+			{
+				for (const auto& p : processes)
+				{
+					if (!p.metadataPending)
+					{
+						summary->add(p.name, p.workingSetBytes);
+					}
+				}
+			}
+
+			if (heavyHitters)
+			{
+				// Each sample stands for the time since the previous one; the first stands for one interval.
+				const auto now = std::chrono::steady_clock::now();
+				const double seconds = tick == 0
+					? static_cast<double>(options.intervalMs) / 1000.0
+					: std::chrono::duration<double>(now - lastTick).count();
+				lastTick = now;
+
+				for (const auto& p : processes)
+				{
+					if (!p.metadataPending)
+					{
+						heavyHitters->add(p.name, static_cast<double>(p.workingSetBytes) * seconds);
+					}
+				}
+			}
+
+			if (exportBuffer)
+			{
+				PhaseScope scope(phases, trace, Phase::Export);
+				const std::uint64_t timestamp = RowExporter::currentTimestampMs();
+
+				if (arrowWriter)
+				{
+					arrowWriter->writeBatch(processes, tick, timestamp);
+				}
+				else
+				{
+					for (const auto& p : processes)
+					{
+						exporter->writeRow(p, tick, timestamp);
+					}
+				}
+
+				// One flush per tick so consumers see complete ticks promptly; within a tick the buffer flushes whenever it fills.
+				exportBuffer->flush();
+				continue;
+			}
+
+			const auto top = selectTopByWorkingSet(processes, options.topN);
+
+			{
+				PhaseScope scope(phases, trace, Phase::Render);
+				printTopByWorkingSet(top, options.columns, previousWorkingSets, accounts, commandLines ? &*commandLines : nullptr);
+			}
+
+			if (commandLines)
+			{
+				commandLines->retain(processes);
+			}
+
+			previousWorkingSets.clear();
+
+			for (const auto& p : processes)
+			{
+				previousWorkingSets.emplace(p.key(), p.workingSetBytes);
+			}
+
+			if (estimate)
+			{
+				printEstimate(*estimate, options.heavyThresholdMB);
+			}
+
+			if (systemMemory)
+			{
+				printSystemSummary(*systemMemory, processes, top, estimate ? &*estimate : nullptr);
+			}
+
+			if (options.byUser)
+			{
+				printByUser(processes, accounts);
+			}
+
+			if (options.showRegions)
+			{
+				PhaseScope scope(phases, trace, Phase::Regions);
+				printRegionStats(top, regionService, regionTracker, trace);
+			}
+		}
+
+		if (summary)
+		{
+			summary->save(options.summaryFile);
+
+			if (!exportBuffer)
+			{
+				printSummary(*summary, options.topN);
+			}
+		}
+
+		if (heavyHitters)
+		{
+			if (!options.heavyHitterFile.empty())
+			{
+				heavyHitters->save(options.heavyHitterFile);
+			}
+
+			printHeavyHitters(*heavyHitters, options.topN);
+		}
+
+		if (arrowWriter)
+		{
+			arrowWriter->finish();
+		}
+
+		// The worker records to the trace, so it has to be stopped before the trace is written. A worker stuck in a hung
+		// query is detached rather than waited for.
+		resolver->stop();
+
+		if (tracer)
+		{
+			tracer->write(options.traceFile);
+		}
+
+		// Best effort: a cache that cannot be written only makes the next run start cold.
+		(void)metadataCache->save(accounts);
+
+		if (profiler)
+		{
+			// stderr, so the statistics never mix with exported rows on stdout.
+			profiler->print(std::wcerr);
+
+			std::wcerr << L"\nMetadata cache: " << metadataCache->hits() << L" hits, " << metadataCache->misses() << L" misses\n";
+
+			if (commandLines)
+			{
+				std::wcerr << L"Command lines: " << commandLines->size() << L" processes in " << formatBytes(commandLines->memoryBytes()) << L"\n";
+			}
+		}
 	}
 	catch (const Win32Error& ex)
 	{
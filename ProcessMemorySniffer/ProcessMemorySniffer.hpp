@@ -1,5 +1,170 @@
 #pragma once
 
+#include <Windows.h>
+
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ProcessInfo.hpp"
+
+/// <summary>
+/// How each tick's processes are written.
+/// </summary>
+enum class OutputFormat
+{
+	Table,
+	Csv,
+	Ndjson,
+	Arrow
+};
+
+/// <summary>
+/// Which columns the process table shows.
+/// </summary>
+enum class ColumnPreset
+{
+	Default,
+	Compact,
+	Memory,
+	Full,
+	CommandLine
+};
+
+/// <summary>
+/// Options controlling a sniffer run, usually parsed from the command line by parseCommandLine().
+/// </summary>
+struct SnifferOptions
+{
+	/// <summary>
+	/// The number of processes to print per tick.
+	/// </summary>
+	std::size_t		topN{ 10 };
+
+	/// <summary>
+	/// The number of collection ticks to run. One tick is a one-shot snapshot.
+	/// </summary>
+	std::size_t		ticks{ 1 };
+
+	/// <summary>
+	/// The delay between ticks, in milliseconds.
+	/// </summary>
+	DWORD			intervalMs{ 1000 };
+
+	/// <summary>
+	/// How each tick's processes are written. Csv, Ndjson and Arrow stream every collected process to standard output instead of printing the table.
+	/// </summary>
+	OutputFormat	format{ OutputFormat::Table };
+
+	/// <summary>
+	/// The columns of the process table.
+	/// </summary>
+	ColumnPreset	columns{ ColumnPreset::Default };
+
+	/// <summary>
+	/// The longest command line the command line column shows, in characters; longer ones are cut and end with "...".
+	/// </summary>
+	std::size_t		commandLineMaxLength{ 512 };
+
+	/// <summary>
+	/// Whether to print virtual memory region statistics (fragmentation and churn) for the printed processes.
+	/// </summary>
+	bool			showRegions{ false };
+
+	/// <summary>
+	/// Whether to print the tool's own cost per collection phase (enumerate, query, regions, render, export) at the end of the run.
+	/// </summary>
+	bool			showStats{ false };
+
+	/// <summary>
+	/// If not empty, a file the run's phases and slow per-process queries are written to as Chrome trace-event JSON.
+	/// </summary>
+	std::wstring	traceFile;
+
+	/// <summary>
+	/// With a trace file, the duration in microseconds from which a per-process query or address space walk gets its own trace event.
+	/// </summary>
+	std::uint32_t	traceSlowQueryUs{ 1000 };
+
+	/// <summary>
+	/// If non-zero, the approximate mode is used: each tick queries the known heavy hitters plus this many randomly sampled PIDs.
+	/// </summary>
+	std::size_t		sampleSize{ 0 };
+
+	/// <summary>
+	/// In the approximate mode, the working set in MiB at or above which a process is queried on every tick once seen.
+	/// </summary>
+	std::size_t		heavyThresholdMB{ 256 };
+
+	/// <summary>
+	/// Whether to print per-user totals (process count, working set, private bytes) after the process table.
+	/// </summary>
+	bool			byUser{ false };
+
+	/// <summary>
+	/// Whether to print system-wide memory (RAM in use, file cache, kernel pools) after the process table, reconciled with the
+	/// process totals of the same tick.
+	/// </summary>
+	bool			showSystem{ false };
+
+	/// <summary>
+	/// If not empty, a sketch file: per-name working set quantile sketches are loaded from it, updated every tick, saved back and summarized.
+	/// </summary>
+	std::wstring	summaryFile;
+
+	/// <summary>
+	/// Additional sketch files (other runs or hosts) to merge into the summary before it is saved.
+	/// </summary>
+	std::vector<std::wstring> mergeFiles;
+
+	/// <summary>
+	/// If non-zero, the number of counters of a Space-Saving summary tracking which executables accumulate the most working set
+	/// memory-seconds over the run, or over all runs saved to heavyHitterFile; the summary is printed at the end.
+	/// </summary>
+	std::size_t		heavyHitterCapacity{ 0 };
+
+	/// <summary>
+	/// If not empty, a heavy hitter file: the summary saved there by earlier runs is merged in first and the result saved back.
+	/// </summary>
+	std::wstring	heavyHitterFile;
+
+	/// <summary>
+	/// Additional heavy hitter files (other runs or hosts) to merge into the summary before it is saved.
+	/// </summary>
+	std::vector<std::wstring> heavyHitterMergeFiles;
+
+	/// <summary>
+	/// Whether to run the interactive live view instead of printing tables.
+	/// </summary>
+	bool			liveView{ false };
+
+	/// <summary>
+	/// Whether to print the modules shared by the most processes instead of the process table.
+	/// </summary>
+	bool			showModules{ false };
+
+	/// <summary>
+	/// If not empty, a module name or path; the processes that have a matching module loaded are printed instead of the process table.
+	/// </summary>
+	std::wstring	loadedBy;
+
+	/// <summary>
+	/// If non-zero, a PID whose per-thread memory (stacks, heap-like allocations) is printed instead of the process table.
+	/// </summary>
+	DWORD			threadsPid{ 0 };
+
+	/// <summary>
+	/// Whether process names, owners and account names are taken from and saved to the metadata cache file of previous runs.
+	/// </summary>
+	bool			useMetadataCache{ true };
+
+	/// <summary>
+	/// Whether usage information was requested instead of a run.
+	/// </summary>
+	bool			showHelp{ false };
+};
+
+[[nodiscard]] std::vector<ProcessInfo> selectTopByWorkingSet(const std::vector<ProcessInfo>& processes, std::size_t topN);
 
-int runSniffer(std::size_t topN);
\ No newline at end of file
+int runSniffer(const SnifferOptions& options);
\ No newline at end of file
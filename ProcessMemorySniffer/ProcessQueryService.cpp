@@ -1,13 +1,16 @@
 #include <Windows.h>
 #include <Psapi.h>>
+#include <sddl.h>
 
 #include <algorithm>
 
 #include "ProcessQueryService.hpp"
 #include "ProcessHandle.hpp"
+#include "ResourceCounters.hpp"
 #include "Win32Error.hpp"
 
 #pragma comment(lib, "Psapi.lib")
+#pragma comment(lib, "Advapi32.lib")
 
 /// <summary>
 /// Defines a compile-time constant for the PID vector size.
@@ -25,6 +28,7 @@ std::vector<DWORD> ProcessQueryService::enumerateProcessIds() const
 	while (true)
 	{
 		DWORD bytesReturned = 0;
+		countSystemCall();
 		if (!::EnumProcesses(
 			pids.data(),
 			static_cast<DWORD>(pids.size() * sizeof(DWORD)), &bytesReturned))
@@ -51,8 +55,8 @@ std::vector<DWORD> ProcessQueryService::enumerateProcessIds() const
 /// Retrieves runtime information about a process identified by its PID. Returns a ProcessInfo when the process can be opened and memory info retrieved; otherwise returns std::nullopt.
 /// </summary>
 /// <param name="pid">The process identifier (DWORD) to query. If pid is 0 or the process cannot be opened or queried, the function returns std::nullopt.</param>
-/// <returns>std::optional<ProcessInfo> containing the process information (pid, name, workingSetBytes, privateBytes) on success; std::nullopt if the PID is 0, access is denied/cannot open the process, or memory information could not be obtained. The function is noexcept and does not throw.</returns>
-std::optional<ProcessInfo>ProcessQueryService::queryProcess(DWORD pid) const noexcept
+/// <returns>std::optional<ProcessInfo> containing the process information (pid, name, workingSetBytes, privateBytes) on success; std::nullopt if the PID is 0, access is denied/cannot open the process, or memory information could not be obtained. Failures to query a process are reported as std::nullopt; only resource failures of the resolver (std::bad_alloc, std::system_error) are thrown, to be handled by the caller.</returns>
+std::optional<ProcessInfo>ProcessQueryService::queryProcess(DWORD pid) const
 {
 	if (pid == 0)
 	{
@@ -69,6 +73,7 @@ std::optional<ProcessInfo>ProcessQueryService::queryProcess(DWORD pid) const noe
 
 	PROCESS_MEMORY_COUNTERS_EX pmc{};
 
+	countSystemCall();
 	if (!::GetProcessMemoryInfo(
 		handleOpt->get(),
 		reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc),
@@ -79,9 +84,26 @@ std::optional<ProcessInfo>ProcessQueryService::queryProcess(DWORD pid) const noe
 
 	ProcessInfo info;
 	info.pid = pid;
-	info.name = tryGetProcessName(handleOpt->get());
+	info.startTime = queryProcessStartTime(handleOpt->get()).value_or(0);
+
+	if (resolver_ != nullptr && info.startTime != 0)
+	{
+		// Without a start time the resolver could not tell the process from a later one reusing its PID; resolved inline below.
+		(void)resolver_->lookup(info.key(), info);
+	}
+	else
+	{
+		info.name = tryGetProcessName(handleOpt->get());
+		info.userSid = tryGetProcessUser(handleOpt->get());
+	}
+
 	info.workingSetBytes = static_cast<Bytes>(pmc.WorkingSetSize);
 	info.privateBytes = static_cast<Bytes>(pmc.PrivateUsage);
+	info.peakWorkingSetBytes = static_cast<Bytes>(pmc.PeakWorkingSetSize);
+
+	// Kernel pool usage comes with the same GetProcessMemoryInfo call, so it costs no extra system call.
+	info.pagedPoolBytes = static_cast<Bytes>(pmc.QuotaPagedPoolUsage);
+	info.nonPagedPoolBytes = static_cast<Bytes>(pmc.QuotaNonPagedPoolUsage);
 
 	return info;
 }
@@ -91,10 +113,11 @@ std::optional<ProcessInfo>ProcessQueryService::queryProcess(DWORD pid) const noe
 /// </summary>
 /// <param name="process">Handle to the process to query. Must refer to a valid process and have sufficient access rights for name/query operations.</param>
 /// <returns>A std::wstring containing the process name (module base name or full image path). Returns "<unknown>" if the name could not be determined.</returns>
-std::wstring ProcessQueryService::tryGetProcessName(HANDLE process) const noexcept
+std::wstring ProcessQueryService::tryGetProcessName(HANDLE process) noexcept
 {
 	wchar_t buffer[MAX_PATH];
 
+	countSystemCall();
 	if (::GetModuleBaseNameW(process, nullptr, buffer, static_cast<DWORD>(std::size(buffer))))
 	{
 		return buffer;
@@ -102,6 +125,7 @@ std::wstring ProcessQueryService::tryGetProcessName(HANDLE process) const noexce
 
 	DWORD size = static_cast<DWORD>(std::size(buffer));
 
+	countSystemCall();
 	if (::QueryFullProcessImageNameW(process, 0, buffer, &size))
 	{
 		return buffer;
@@ -110,20 +134,87 @@ std::wstring ProcessQueryService::tryGetProcessName(HANDLE process) const noexce
 	return L"<unknown>";
 }
 
+/// <summary>
+/// Retrieves the owner of the specified process as a string SID, read from the TokenUser information of its primary token.
+/// </summary>
+/// <param name="process">Handle to the process to query. Must have PROCESS_QUERY_INFORMATION access.</param>
+/// <returns>The string SID of the process owner, e.g. "S-1-5-18" for SYSTEM. Returns an empty string if the token could not be opened or queried.</returns>
+std::wstring ProcessQueryService::tryGetProcessUser(HANDLE process) noexcept
+{
+	HANDLE rawToken = nullptr;
+
+	countSystemCall();
+	if (!::OpenProcessToken(process, TOKEN_QUERY, &rawToken))
+	{
+		return {};
+	}
+
+	// ProcessHandle only owns a HANDLE and closes it with ::CloseHandle, which is exactly what a token handle needs.
+	const ProcessHandle token(rawToken);
+
+	// TOKEN_USER is followed by the variable-length SID it points to; SECURITY_MAX_SID_SIZE bounds it.
+	alignas(TOKEN_USER) BYTE buffer[sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE];
+	DWORD length = 0;
+
+	countSystemCall();
+	if (!::GetTokenInformation(token.get(), TokenUser, buffer, sizeof(buffer), &length))
+	{
+		return {};
+	}
+
+	LPWSTR sidString = nullptr;
+
+	if (!::ConvertSidToStringSidW(reinterpret_cast<TOKEN_USER*>(buffer)->User.Sid, &sidString))
+	{
+		return {};
+	}
+
+	std::wstring result = sidString;
+	::LocalFree(sidString);
+
+	return result;
+}
+
 /// <summary>
 /// Enumerates process IDs, queries each process for information, and returns a collection of the gathered ProcessInfo objects.
+/// Processes that exited since the previous call are dropped from an attached resolver.
 /// </summary>
 /// <returns>A std::vector<ProcessInfo> containing the ProcessInfo entries for processes that could be successfully queried. Processes for which queryProcess() returns no data are omitted.</returns>
 std::vector<ProcessInfo> ProcessQueryService::collectProcesses() const
 {
-	const auto pids = enumerateProcessIds();
+	const std::vector<DWORD> pids = enumerateProcessIds();
+	std::vector<ProcessInfo> result = collectProcesses(pids);
+
+	if (resolver_ != nullptr)
+	{
+		resolver_->retain(pids, result);
+	}
+
+	return result;
+}
 
+/// <summary>
+/// Queries each of the given processes for information and returns a collection of the gathered ProcessInfo objects.
+/// </summary>
+/// <param name="pids">The process identifiers to query, e.g. a subset of enumerateProcessIds() chosen by SamplingPlanner.</param>
+/// <returns>A std::vector<ProcessInfo> containing the ProcessInfo entries for processes that could be successfully queried. Processes for which queryProcess() returns no data are omitted.</returns>
+std::vector<ProcessInfo> ProcessQueryService::collectProcesses(const std::vector<DWORD>& pids) const
+{
 	std::vector<ProcessInfo> result;
 	result.reserve(pids.size());
 
 	for (DWORD pid : pids)
 	{
-		if (auto info = queryProcess(pid))
+		const std::uint64_t start = trace_ != nullptr ? trace_->now() : 0;
+		auto info = queryProcess(pid);
+
+		if (trace_ != nullptr)
+		{
+			static const std::wstring NO_NAME;
+			trace_->recordQuery("query", pid, info ? info->name : NO_NAME, start, trace_->now());
+		}
+
+		if (info)
 		{
 			result.push_back(std::move(*info));
 		}
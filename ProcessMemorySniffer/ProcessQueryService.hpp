@@ -6,7 +6,9 @@
 #include <optional>
 #include <string>
 
+#include "MetadataResolver.hpp"
 #include "ProcessInfo.hpp"
+#include "TraceRecorder.hpp"
 
 /// <summary>
 /// Service for enumerating running processes and collecting information about them.
@@ -16,10 +18,44 @@ class ProcessQueryService
 public:
 	[[nodiscard]] std::vector<ProcessInfo> collectProcesses() const;
 
-private:
+	[[nodiscard]] std::vector<ProcessInfo> collectProcesses(const std::vector<DWORD>& pids) const;
+
 	[[nodiscard]] std::vector<DWORD> enumerateProcessIds() const;
 
-	[[nodiscard]] std::optional<ProcessInfo> queryProcess(DWORD pid) const noexcept;
+	/// <summary>
+	/// Records per-process queries that exceed the recorder's slow-query threshold; nullptr (the default) disables tracing.
+	/// </summary>
+	/// <param name="recorder">The recorder, or nullptr.</param>
+	void attachTrace(TraceRecorder* recorder) noexcept
+	{
+		trace_ = recorder;
+	}
+
+	/// <summary>
+	/// Hands process names and owners to a background resolver instead of resolving them while collecting; processes it does not
+	/// know yet are returned with metadataPending set. The resolver keeps what it resolved in its metadata cache. nullptr (the
+	/// default) resolves inline.
+	/// </summary>
+	/// <param name="resolver">The resolver, or nullptr.</param>
+	void attachResolver(MetadataResolver* resolver) noexcept
+	{
+		resolver_ = resolver;
+	}
+
+	[[nodiscard]] static std::wstring tryGetProcessName(HANDLE process) noexcept;
+
+	[[nodiscard]] static std::wstring tryGetProcessUser(HANDLE process) noexcept;
+
+private:
+	[[nodiscard]] std::optional<ProcessInfo> queryProcess(DWORD pid) const;
+
+	/// <summary>
+	/// The trace recorder, or nullptr.
+	/// </summary>
+	TraceRecorder*	trace_{ nullptr };
 
-	[[nodiscard]] std::wstring tryGetProcessName(HANDLE process) const noexcept;
+	/// <summary>
+	/// The background metadata resolver, or nullptr.
+	/// </summary>
+	MetadataResolver*	resolver_{ nullptr };
 };
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+#include "QuantileSketch.hpp"
+
+/// <summary>
+/// Ratio between consecutive bucket boundaries: (1 + a) / (1 - a) for relative accuracy a.
+/// </summary>
+constexpr double GAMMA = (1.0 + QuantileSketch::RELATIVE_ACCURACY) / (1.0 - QuantileSketch::RELATIVE_ACCURACY);
+
+/// <summary>
+/// 1 / ln(GAMMA), so that a value's bucket index is ceil(ln(value) * INV_LOG_GAMMA).
+/// </summary>
+static const double INV_LOG_GAMMA = 1.0 / std::log(GAMMA);
+
+/// <summary>
+/// Adds one value to the sketch.
+/// </summary>
+/// <param name="value">The value to add, e.g. a working set in bytes.</param>
+void QuantileSketch::add(std::uint64_t value)
+{
+	count_++;
+
+	if (value == 0)
+	{
+		zeroCount_++;
+		return;
+	}
+
+	addToBucket(static_cast<std::int32_t>(std::ceil(std::log(static_cast<double>(value)) * INV_LOG_GAMMA)), 1);
+}
+
+/// <summary>
+/// Adds count to the bucket with the given index, widening the dense bucket window as needed. If the window would exceed MAX_BUCKETS, the lowest buckets are folded into the lowest bucket that is kept.
+/// </summary>
+/// <param name="index">The logarithmic bucket index.</param>
+/// <param name="count">The count to add.</param>
+void QuantileSketch::addToBucket(std::int32_t index, std::uint64_t count)
+{
+	if (counts_.empty())
+	{
+		offset_ = index;
+		counts_.assign(1, 0);
+	}
+
+	if (index < offset_)
+	{
+		const std::int32_t highest = offset_ + static_cast<std::int32_t>(counts_.size()) - 1;
+		const std::int32_t lowestAllowed = highest - static_cast<std::int32_t>(MAX_BUCKETS) + 1;
+		const std::int32_t newOffset = std::max(index, lowestAllowed);
+
+		counts_.insert(counts_.begin(), static_cast<std::size_t>(offset_ - newOffset), 0);
+		offset_ = newOffset;
+		index = std::max(index, offset_);
+	}
+	else if (index >= offset_ + static_cast<std::int32_t>(counts_.size()))
+	{
+		counts_.resize(static_cast<std::size_t>(index - offset_) + 1, 0);
+
+		if (counts_.size() > MAX_BUCKETS)
+		{
+			// Collapse the lowest buckets so the window ends at index.
+			const std::size_t excess = counts_.size() - MAX_BUCKETS;
+			std::uint64_t folded = 0;
+
+			for (std::size_t i = 0; i < excess; i++)
+			{
+				folded += counts_[i];
+			}
+
+			counts_.erase(counts_.begin(), counts_.begin() + static_cast<std::ptrdiff_t>(excess));
+			counts_[0] += folded;
+			offset_ += static_cast<std::int32_t>(excess);
+		}
+	}
+
+	counts_[static_cast<std::size_t>(index - offset_)] += count;
+}
+
+/// <summary>
+/// Merges another sketch into this one, as if every value added to other had been added here.
+/// </summary>
+/// <param name="other">The sketch to merge.</param>
+void QuantileSketch::merge(const QuantileSketch& other)
+{
+	count_ += other.count_;
+	zeroCount_ += other.zeroCount_;
+
+	for (std::size_t i = 0; i < other.counts_.size(); i++)
+	{
+		if (other.counts_[i] != 0)
+		{
+			addToBucket(other.offset_ + static_cast<std::int32_t>(i), other.counts_[i]);
+		}
+	}
+}
+
+/// <summary>
+/// Estimates a quantile of the added values.
+/// </summary>
+/// <param name="q">The quantile in [0, 1], e.g. 0.99 for p99.</param>
+/// <returns>The estimated value, within RELATIVE_ACCURACY of the true quantile; 0 if the sketch is empty.</returns>
+std::uint64_t QuantileSketch::quantile(double q) const noexcept
+{
+	if (count_ == 0)
+	{
+		return 0;
+	}
+
+	const auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(count_ - 1));
+
+	if (rank < zeroCount_)
+	{
+		return 0;
+	}
+
+	std::uint64_t seen = zeroCount_;
+
+	for (std::size_t i = 0; i < counts_.size(); i++)
+	{
+		seen += counts_[i];
+
+		if (seen > rank)
+		{
+			// The midpoint (in relative terms) of bucket (gamma^(k-1), gamma^k].
+			const double k = static_cast<double>(offset_ + static_cast<std::int32_t>(i));
+			return static_cast<std::uint64_t>(2.0 * std::pow(GAMMA, k) / (GAMMA + 1.0));
+		}
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Appends the sketch as text: "count zeroCount offset c0,c1,...", with runs of empty buckets written as "z<n>" to keep sparse sketches short.
+/// </summary>
+/// <param name="out">The string to append to.</param>
+void QuantileSketch::serialize(std::string& out) const
+{
+	out += std::to_string(count_);
+	out += ' ';
+	out += std::to_string(zeroCount_);
+	out += ' ';
+	out += std::to_string(offset_);
+	out += ' ';
+
+	for (std::size_t i = 0; i < counts_.size(); i++)
+	{
+		if (i > 0)
+		{
+			out += ',';
+		}
+
+		if (counts_[i] == 0)
+		{
+			std::size_t run = 1;
+
+			while (i + run < counts_.size() && counts_[i + run] == 0)
+			{
+				run++;
+			}
+
+			out += 'z';
+			out += std::to_string(run);
+			i += run - 1;
+			continue;
+		}
+
+		out += std::to_string(counts_[i]);
+	}
+}
+
+/// <summary>
+/// Parses one unsigned or signed integer at the front of text and advances past it.
+/// </summary>
+/// <param name="text">The remaining text; advanced past the number on success.</param>
+/// <param name="value">Receives the number.</param>
+/// <returns>true if a number was parsed.</returns>
+template <typename T>
+static bool parseInteger(std::string_view& text, T& value)
+{
+	const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+	if (ec != std::errc{})
+	{
+		return false;
+	}
+
+	text.remove_prefix(static_cast<std::size_t>(end - text.data()));
+	return true;
+}
+
+/// <summary>
+/// Parses a sketch written by serialize().
+/// </summary>
+/// <param name="text">The serialized sketch.</param>
+/// <param name="sketch">Receives the parsed sketch.</param>
+/// <returns>true on success; false if text is malformed, in which case sketch is left unspecified.</returns>
+bool QuantileSketch::parse(std::string_view text, QuantileSketch& sketch)
+{
+	sketch = QuantileSketch{};
+
+	const auto expect = [&text](char c)
+		{
+			if (text.empty() || text.front() != c)
+			{
+				return false;
+			}
+
+			text.remove_prefix(1);
+			return true;
+		};
+
+	if (!parseInteger(text, sketch.count_) || !expect(' ')
+		|| !parseInteger(text, sketch.zeroCount_) || !expect(' ')
+		|| !parseInteger(text, sketch.offset_) || !expect(' '))
+	{
+		return false;
+	}
+
+	std::uint64_t total = sketch.zeroCount_;
+
+	while (!text.empty())
+	{
+		if (!sketch.counts_.empty() && !expect(','))
+		{
+			return false;
+		}
+
+		std::uint64_t value = 0;
+
+		if (expect('z'))
+		{
+			if (!parseInteger(text, value) || value == 0 || sketch.counts_.size() + value > MAX_BUCKETS)
+			{
+				return false;
+			}
+
+			sketch.counts_.insert(sketch.counts_.end(), static_cast<std::size_t>(value), 0);
+			continue;
+		}
+
+		if (!parseInteger(text, value) || sketch.counts_.size() >= MAX_BUCKETS)
+		{
+			return false;
+		}
+
+		sketch.counts_.push_back(value);
+		total += value;
+	}
+
+	return total == sketch.count_;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Mergeable quantile sketch with bounded relative error, in the style of DDSketch.
+/// Positive values are counted in logarithmic buckets whose boundaries grow by GAMMA, so any quantile is answered within
+/// RELATIVE_ACCURACY of the true value. Buckets are stored densely between the lowest and highest one in use, which for the RSS of one
+/// program over a day is a few hundred counters; if the range would exceed MAX_BUCKETS the lowest buckets are collapsed together,
+/// trading accuracy of the lowest quantiles for bounded memory.
+/// Two sketches merge by adding bucket counts, so summaries from different runs or hosts can be combined without loss.
+/// </summary>
+class QuantileSketch
+{
+public:
+	/// <summary>
+	/// Relative accuracy of quantile estimates (1%).
+	/// </summary>
+	static constexpr double RELATIVE_ACCURACY = 0.01;
+
+	/// <summary>
+	/// Maximum number of buckets kept per sketch.
+	/// </summary>
+	static constexpr std::size_t MAX_BUCKETS = 2048;
+
+	void add(std::uint64_t value);
+
+	void merge(const QuantileSketch& other);
+
+	[[nodiscard]] std::uint64_t quantile(double q) const noexcept;
+
+	/// <summary>
+	/// Returns the number of values added (directly or through merges).
+	/// </summary>
+	/// <returns>The total count.</returns>
+	[[nodiscard]] std::uint64_t count() const noexcept
+	{
+		return count_;
+	}
+
+	void serialize(std::string& out) const;
+
+	[[nodiscard]] static bool parse(std::string_view text, QuantileSketch& sketch);
+
+private:
+	void addToBucket(std::int32_t index, std::uint64_t count);
+
+	/// <summary>
+	/// The number of values added.
+	/// </summary>
+	std::uint64_t				count_{ 0 };
+
+	/// <summary>
+	/// The number of zero values added; zero has no logarithmic bucket.
+	/// </summary>
+	std::uint64_t				zeroCount_{ 0 };
+
+	/// <summary>
+	/// Bucket index of counts_[0].
+	/// </summary>
+	std::int32_t				offset_{ 0 };
+
+	/// <summary>
+	/// Dense bucket counts for indices [offset_, offset_ + counts_.size()).
+	/// </summary>
+	std::vector<std::uint64_t>	counts_;
+};
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <Windows.h>
+
+#include "RegionQueryService.hpp"
+#include "ProcessHandle.hpp"
+#include "ResourceCounters.hpp"
+
+/// <summary>
+/// Opens the process identified by pid and collects its non-free regions into regions.
+/// </summary>
+/// <param name="pid">The process identifier (DWORD) of the process to walk.</param>
+/// <param name="regions">Output vector that receives the regions in ascending address order. It is cleared first, so its capacity is reused across calls.</param>
+/// <returns>true if the process could be opened and walked; false if access was denied or the process has exited.</returns>
+bool RegionQueryService::collectRegions(DWORD pid, std::vector<MemoryRegion>& regions) const
+{
+	auto handleOpt = ProcessHandle::open(pid);
+
+	if (!handleOpt)
+	{
+		regions.clear();
+		return false;
+	}
+
+	return collectRegions(handleOpt->get(), regions);
+}
+
+/// <summary>
+/// Opens the process identified by key and collects its non-free regions into regions. Unlike the PID overload this never walks
+/// a different process that reused the PID after the key was taken.
+/// </summary>
+/// <param name="key">The process to walk.</param>
+/// <param name="regions">Output vector that receives the regions in ascending address order. It is cleared first, so its capacity is reused across calls.</param>
+/// <returns>true if the process could be opened and walked; false if access was denied, the process has exited or its PID now belongs to another process.</returns>
+bool RegionQueryService::collectRegions(const ProcessKey& key, std::vector<MemoryRegion>& regions) const
+{
+	auto handleOpt = ProcessHandle::open(key);
+
+	if (!handleOpt)
+	{
+		regions.clear();
+		return false;
+	}
+
+	return collectRegions(handleOpt->get(), regions);
+}
+
+/// <summary>
+/// Walks the address space of an already opened process with VirtualQueryEx and collects its non-free regions. Free regions are skipped; the gaps between consecutive regions describe them.
+/// </summary>
+/// <param name="process">Handle to the process. Must have PROCESS_QUERY_INFORMATION access.</param>
+/// <param name="regions">Output vector that receives the regions in ascending address order. It is cleared first, so its capacity is reused across calls.</param>
+/// <returns>true if at least one region was read; false if the address space could not be queried.</returns>
+bool RegionQueryService::collectRegions(HANDLE process, std::vector<MemoryRegion>& regions) const
+{
+	regions.clear();
+
+	MEMORY_BASIC_INFORMATION mbi{};
+	std::uintptr_t address = 0;
+
+	// One count per VirtualQueryEx call: the first here, each following one at the end of the loop body.
+	countSystemCall();
+
+	while (::VirtualQueryEx(process, reinterpret_cast<LPCVOID>(address), &mbi, sizeof(mbi)) == sizeof(mbi))
+	{
+		const auto base = reinterpret_cast<std::uintptr_t>(mbi.BaseAddress);
+
+		if (mbi.State != MEM_FREE)
+		{
+			MemoryRegion region;
+			region.base = base;
+			region.allocationBase = reinterpret_cast<std::uintptr_t>(mbi.AllocationBase);
+			region.size = static_cast<Bytes>(mbi.RegionSize);
+			region.protect = mbi.Protect;
+			region.state = mbi.State == MEM_COMMIT ? RegionState::Committed : RegionState::Reserved;
+			region.type = mbi.Type == MEM_IMAGE ? RegionType::Image
+				: mbi.Type == MEM_MAPPED ? RegionType::Mapped
+				: RegionType::Private;
+
+			regions.push_back(region);
+		}
+
+		const std::uintptr_t next = base + mbi.RegionSize;
+
+		if (next <= address)
+		{
+			// Wrapped around the top of the address space.
+			break;
+		}
+
+		address = next;
+		countSystemCall();
+	}
+
+	return !regions.empty();
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <vector>
+
+#include "MemoryRegion.hpp"
+#include "ProcessKey.hpp"
+
+/// <summary>
+/// Service for walking the virtual address space of a process and collecting its non-free regions.
+/// </summary>
+class RegionQueryService
+{
+public:
+	[[nodiscard]] bool collectRegions(DWORD pid, std::vector<MemoryRegion>& regions) const;
+
+	[[nodiscard]] bool collectRegions(const ProcessKey& key, std::vector<MemoryRegion>& regions) const;
+
+	[[nodiscard]] bool collectRegions(HANDLE process, std::vector<MemoryRegion>& regions) const;
+};
\ No newline at end of file
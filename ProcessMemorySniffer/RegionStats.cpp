@@ -0,0 +1,160 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <bit>
+
+#include "RegionStats.hpp"
+
+/// <summary>
+/// log2 of the smallest histogram bucket boundary (4 KiB, one page).
+/// </summary>
+constexpr std::size_t HISTOGRAM_MIN_SHIFT = 12;
+
+/// <summary>
+/// Returns the histogram bucket for a size in bytes. Bucket 0 holds sizes up to one page; bucket k holds sizes in (2^(k+11), 2^(k+12)].
+/// </summary>
+/// <param name="size">The size in bytes.</param>
+/// <returns>The bucket index in [0, REGION_HISTOGRAM_BUCKETS).</returns>
+std::size_t regionHistogramBucket(Bytes size) noexcept
+{
+	if (size <= (Bytes{ 1 } << HISTOGRAM_MIN_SHIFT))
+	{
+		return 0;
+	}
+
+	// bit_width(size - 1) is ceil(log2(size)), so exact powers of two land in their own bucket.
+	const std::size_t shift = static_cast<std::size_t>(std::bit_width(size - 1));
+
+	return std::min(shift - HISTOGRAM_MIN_SHIFT, REGION_HISTOGRAM_BUCKETS - 1);
+}
+
+/// <summary>
+/// Returns the upper bound in bytes of a histogram bucket, for labelling. The last bucket is open ended; its ceiling is the smallest size it holds.
+/// </summary>
+/// <param name="bucket">The bucket index.</param>
+/// <returns>The largest size that falls into the bucket, or for the last bucket the exclusive lower bound.</returns>
+std::uint64_t regionHistogramBucketCeiling(std::size_t bucket) noexcept
+{
+	return std::uint64_t{ 1 } << (std::min(bucket, REGION_HISTOGRAM_BUCKETS - 2) + HISTOGRAM_MIN_SHIFT);
+}
+
+/// <summary>
+/// Computes the static statistics of a region list: region and allocation counts, committed and reserved totals and the size and gap histograms.
+/// </summary>
+/// <param name="regions">The region list, sorted by base address as returned by RegionQueryService.</param>
+/// <returns>A RegionStats with hasBaseline == false and no churn information.</returns>
+RegionStats computeRegionStats(const std::vector<MemoryRegion>& regions) noexcept
+{
+	RegionStats stats;
+	stats.regionCount = regions.size();
+
+	std::uintptr_t previousEnd = 0;
+	std::uintptr_t previousAllocation = 0;
+
+	for (std::size_t i = 0; i < regions.size(); i++)
+	{
+		const auto& region = regions[i];
+
+		if (region.state == RegionState::Committed)
+		{
+			stats.committedBytes += region.size;
+		}
+		else
+		{
+			stats.reservedBytes += region.size;
+		}
+
+		stats.sizeHistogram[regionHistogramBucket(region.size)]++;
+
+		if (i == 0 || region.allocationBase != previousAllocation)
+		{
+			stats.allocationCount++;
+		}
+
+		if (i > 0 && region.base > previousEnd)
+		{
+			stats.gapHistogram[regionHistogramBucket(region.base - previousEnd)]++;
+		}
+
+		previousEnd = region.end();
+		previousAllocation = region.allocationBase;
+	}
+
+	return stats;
+}
+
+/// <summary>
+/// Counts added and removed regions with a single linear merge of two sorted region lists. A region is considered unchanged if a region with the same base and size exists in both lists; a region that was resized counts as one removal and one addition.
+/// </summary>
+/// <param name="previous">The region list from the previous tick, sorted by base address.</param>
+/// <param name="current">The region list from the current tick, sorted by base address.</param>
+/// <param name="stats">Receives added and removed counts; hasBaseline is set to true.</param>
+void diffRegions(const std::vector<MemoryRegion>& previous, const std::vector<MemoryRegion>& current, RegionStats& stats) noexcept
+{
+	std::size_t i = 0;
+	std::size_t j = 0;
+	std::size_t added = 0;
+	std::size_t removed = 0;
+
+	while (i < previous.size() && j < current.size())
+	{
+		const auto& before = previous[i];
+		const auto& now = current[j];
+
+		if (before.base < now.base)
+		{
+			removed++;
+			i++;
+		}
+		else if (now.base < before.base)
+		{
+			added++;
+			j++;
+		}
+		else
+		{
+			if (before.size != now.size)
+			{
+				removed++;
+				added++;
+			}
+
+			i++;
+			j++;
+		}
+	}
+
+	stats.hasBaseline = true;
+	stats.removed = removed + (previous.size() - i);
+	stats.added = added + (current.size() - j);
+}
+
+/// <summary>
+/// Records the region list of a process for the current tick and computes its statistics, including churn against the list recorded on the previous tick if there is one.
+/// </summary>
+/// <param name="key">The process the regions belong to.</param>
+/// <param name="regions">The region list, sorted by base address. Ownership is taken so the list can serve as the baseline of the next tick without a copy.</param>
+/// <returns>The RegionStats of the process; hasBaseline is false if the process was not seen on the previous tick.</returns>
+RegionStats RegionTracker::update(const ProcessKey& key, std::vector<MemoryRegion>&& regions)
+{
+	auto stats = computeRegionStats(regions);
+
+	if (const auto it = previous_.find(key); it != previous_.end())
+	{
+		diffRegions(it->second, regions, stats);
+	}
+
+	current_[key] = std::move(regions);
+
+	return stats;
+}
+
+/// <summary>
+/// Finishes a tick: the region lists recorded during it become the baseline for the next tick, and processes that were not updated are dropped.
+/// </summary>
+void RegionTracker::endTick()
+{
+	previous_ = std::move(current_);
+	current_.clear();
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryRegion.hpp"
+#include "ProcessKey.hpp"
+
+/// <summary>
+/// Number of power-of-two buckets in the region size and gap histograms. Bucket 0 holds everything up to 4 KiB, the last bucket everything above 32 GiB.
+/// </summary>
+constexpr std::size_t REGION_HISTOGRAM_BUCKETS = 25;
+
+/// <summary>
+/// Power-of-two histogram of byte sizes, bucketed from one page (4 KiB) upwards.
+/// </summary>
+using RegionHistogram = std::array<std::size_t, REGION_HISTOGRAM_BUCKETS>;
+
+/// <summary>
+/// Fragmentation and churn statistics for the region list of a single process.
+/// </summary>
+struct RegionStats
+{
+	/// <summary>
+	/// The number of non-free regions.
+	/// </summary>
+	std::size_t		regionCount{ 0 };
+
+	/// <summary>
+	/// The number of distinct allocations (allocation bases) the regions belong to.
+	/// </summary>
+	std::size_t		allocationCount{ 0 };
+
+	/// <summary>
+	/// The total size of committed regions.
+	/// </summary>
+	Bytes			committedBytes{ 0 };
+
+	/// <summary>
+	/// The total size of reserved but uncommitted regions.
+	/// </summary>
+	Bytes			reservedBytes{ 0 };
+
+	/// <summary>
+	/// Histogram of region sizes.
+	/// </summary>
+	RegionHistogram	sizeHistogram{};
+
+	/// <summary>
+	/// Histogram of the free gaps between consecutive regions.
+	/// </summary>
+	RegionHistogram	gapHistogram{};
+
+	/// <summary>
+	/// Whether a region list from a previous tick was available. When false, added and removed are meaningless.
+	/// </summary>
+	bool			hasBaseline{ false };
+
+	/// <summary>
+	/// The number of regions present now that were not present on the previous tick.
+	/// </summary>
+	std::size_t		added{ 0 };
+
+	/// <summary>
+	/// The number of regions present on the previous tick that are gone now.
+	/// </summary>
+	std::size_t		removed{ 0 };
+};
+
+[[nodiscard]] std::size_t regionHistogramBucket(Bytes size) noexcept;
+
+[[nodiscard]] std::uint64_t regionHistogramBucketCeiling(std::size_t bucket) noexcept;
+
+[[nodiscard]] RegionStats computeRegionStats(const std::vector<MemoryRegion>& regions) noexcept;
+
+void diffRegions(const std::vector<MemoryRegion>& previous, const std::vector<MemoryRegion>& current, RegionStats& stats) noexcept;
+
+/// <summary>
+/// Keeps the region list of each process from the previous tick so that churn can be reported per tick.
+/// Call update() for every process of interest during a tick and endTick() afterwards; processes that were not updated during a tick are forgotten.
+/// </summary>
+class RegionTracker
+{
+public:
+	[[nodiscard]] RegionStats update(const ProcessKey& key, std::vector<MemoryRegion>&& regions);
+
+	void endTick();
+
+private:
+	/// <summary>
+	/// Region lists recorded on the previous tick. Keyed by PID and start time, so a process reusing an exited process' PID starts without a baseline.
+	/// </summary>
+	std::unordered_map<ProcessKey, std::vector<MemoryRegion>, ProcessKeyHash> previous_;
+
+	/// <summary>
+	/// Region lists recorded during the current tick.
+	/// </summary>
+	std::unordered_map<ProcessKey, std::vector<MemoryRegion>, ProcessKeyHash> current_;
+};
\ No newline at end of file
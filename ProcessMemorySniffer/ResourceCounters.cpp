@@ -0,0 +1,185 @@
+#include <cstdlib>
+#include <new>
+
+#include "ResourceCounters.hpp"
+
+#ifdef SNIFFER_RESOURCE_COUNTERS
+
+/// <summary>
+/// The allocation counters of one group of threads. Relaxed atomics: the counts are only read as totals, never used to order
+/// other memory accesses.
+/// </summary>
+struct AllocationCounters
+{
+	std::atomic<std::uint64_t>	allocations{ 0 };
+	std::atomic<std::uint64_t>	allocatedBytes{ 0 };
+	std::atomic<std::uint64_t>	frees{ 0 };
+};
+
+/// <summary>
+/// The allocation counters of the collecting thread(s) and of background threads. Memory is charged to the thread that frees
+/// it, which is the allocating thread for nearly everything the tool allocates.
+/// </summary>
+static AllocationCounters foregroundAllocations;
+static AllocationCounters backgroundAllocations;
+
+/// <summary>
+/// Returns the allocation counters of the calling thread.
+/// </summary>
+/// <returns>The background counters on a thread marked by markBackgroundThread(); the foreground counters otherwise.</returns>
+static AllocationCounters& threadAllocations() noexcept
+{
+	return countsAsBackground ? backgroundAllocations : foregroundAllocations;
+}
+
+/// <summary>
+/// Allocates memory the way the default operator new does, counting the call: retries through the new handler and throws std::bad_alloc.
+/// </summary>
+/// <param name="size">The requested size.</param>
+/// <returns>The allocated memory.</returns>
+static void* countedAllocate(std::size_t size)
+{
+	AllocationCounters& counters = threadAllocations();
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	while (true)
+	{
+		if (void* memory = std::malloc(size))
+		{
+			return memory;
+		}
+
+		const std::new_handler handler = std::get_new_handler();
+
+		if (handler == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+
+		handler();
+	}
+}
+
+/// <summary>
+/// Frees memory from countedAllocate(), counting the call.
+/// </summary>
+/// <param name="memory">The memory, or nullptr.</param>
+static void countedFree(void* memory) noexcept
+{
+	if (memory != nullptr)
+	{
+		threadAllocations().frees.fetch_add(1, std::memory_order_relaxed);
+		std::free(memory);
+	}
+}
+
+// Replacements of the global allocation functions. The over-aligned (std::align_val_t) forms keep their default
+// implementation, which allocates separately, so they are not counted; nothing in the tool uses over-aligned types.
+
+void* operator new(std::size_t size)
+{
+	return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return countedAllocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return countedAllocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* memory) noexcept
+{
+	countedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	countedFree(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	countedFree(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	countedFree(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	countedFree(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	countedFree(memory);
+}
+
+#endif
+
+/// <summary>
+/// Reads the allocation and system call counters of the threads not marked by markBackgroundThread().
+/// </summary>
+/// <returns>The counts since process start; all zero when SNIFFER_RESOURCE_COUNTERS is not defined.</returns>
+ResourceCounts readResourceCounts() noexcept
+{
+	ResourceCounts counts;
+
+#ifdef SNIFFER_RESOURCE_COUNTERS
+	counts.allocations = foregroundAllocations.allocations.load(std::memory_order_relaxed);
+	counts.allocatedBytes = foregroundAllocations.allocatedBytes.load(std::memory_order_relaxed);
+	counts.frees = foregroundAllocations.frees.load(std::memory_order_relaxed);
+	counts.systemCalls = systemCallCount.load(std::memory_order_relaxed);
+#endif
+
+	return counts;
+}
+
+/// <summary>
+/// Reads the allocation and system call counters of the threads marked by markBackgroundThread().
+/// </summary>
+/// <returns>The counts since process start; all zero when SNIFFER_RESOURCE_COUNTERS is not defined.</returns>
+ResourceCounts readBackgroundResourceCounts() noexcept
+{
+	ResourceCounts counts;
+
+#ifdef SNIFFER_RESOURCE_COUNTERS
+	counts.allocations = backgroundAllocations.allocations.load(std::memory_order_relaxed);
+	counts.allocatedBytes = backgroundAllocations.allocatedBytes.load(std::memory_order_relaxed);
+	counts.frees = backgroundAllocations.frees.load(std::memory_order_relaxed);
+	counts.systemCalls = backgroundSystemCallCount.load(std::memory_order_relaxed);
+#endif
+
+	return counts;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// SNIFFER_RESOURCE_COUNTERS is defined in Debug builds, including the Debug benchmarks. It replaces the global
+// operator new/delete with counting versions and makes countSystemCall() count; in other builds both cost nothing.
+// Release benchmarks leave it undefined so their timings measure the allocator the shipping binary uses.
+
+/// <summary>
+/// Whether allocations and system calls are counted in this build.
+/// </summary>
+#ifdef SNIFFER_RESOURCE_COUNTERS
+constexpr bool RESOURCE_COUNTERS_ENABLED = true;
+#else
+constexpr bool RESOURCE_COUNTERS_ENABLED = false;
+#endif
+
+/// <summary>
+/// Cumulative allocation and system call counts of the process, excluding or only covering background threads; the cost of an
+/// interval is the difference of two readings.
+/// </summary>
+struct ResourceCounts
+{
+	/// <summary>
+	/// Calls of the global operator new (all non-aligned forms) and the bytes they requested.
+	/// </summary>
+	std::uint64_t	allocations{ 0 };
+	std::uint64_t	allocatedBytes{ 0 };
+
+	/// <summary>
+	/// Calls of the global operator delete with a non-null pointer.
+	/// </summary>
+	std::uint64_t	frees{ 0 };
+
+	/// <summary>
+	/// Win32 calls on the collection and export paths that enter the kernel (process and token queries, address space walks,
+	/// handle opens and closes, writes). Counted per Win32 call; one call may issue several native system calls.
+	/// </summary>
+	std::uint64_t	systemCalls{ 0 };
+
+	[[nodiscard]] friend constexpr ResourceCounts operator-(const ResourceCounts& a, const ResourceCounts& b) noexcept
+	{
+		return { a.allocations - b.allocations, a.allocatedBytes - b.allocatedBytes, a.frees - b.frees, a.systemCalls - b.systemCalls };
+	}
+
+	constexpr ResourceCounts& operator+=(const ResourceCounts& other) noexcept
+	{
+		allocations += other.allocations;
+		allocatedBytes += other.allocatedBytes;
+		frees += other.frees;
+		systemCalls += other.systemCalls;
+		return *this;
+	}
+};
+
+#ifdef SNIFFER_RESOURCE_COUNTERS
+/// <summary>
+/// The system call counters of the collecting thread(s) and of background threads, incremented by countSystemCall(). The
+/// allocation counters live in ResourceCounters.cpp.
+/// </summary>
+inline std::atomic<std::uint64_t> systemCallCount{ 0 };
+inline std::atomic<std::uint64_t> backgroundSystemCallCount{ 0 };
+
+/// <summary>
+/// Whether the calling thread is a background thread, set by markBackgroundThread(). Constant-initialized, so reading it
+/// from the allocation functions needs no thread-local construction.
+/// </summary>
+inline thread_local bool countsAsBackground = false;
+#endif
+
+/// <summary>
+/// Counts one kernel-entering Win32 call; placed directly before the call.
+/// </summary>
+inline void countSystemCall() noexcept
+{
+#ifdef SNIFFER_RESOURCE_COUNTERS
+	(countsAsBackground ? backgroundSystemCallCount : systemCallCount).fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+/// <summary>
+/// Counts the allocations and system calls of the calling thread from now on separately, in readBackgroundResourceCounts()
+/// instead of readResourceCounts(), so work a background thread (the metadata resolver) does while a phase is measured on the
+/// collecting thread is not charged to that phase. Called first thing on the background thread.
+/// </summary>
+inline void markBackgroundThread() noexcept
+{
+#ifdef SNIFFER_RESOURCE_COUNTERS
+	countsAsBackground = true;
+#endif
+}
+
+[[nodiscard]] ResourceCounts readResourceCounts() noexcept;
+
+[[nodiscard]] ResourceCounts readBackgroundResourceCounts() noexcept;
\ No newline at end of file
@@ -0,0 +1,269 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ROW_EXPORTER_SSE2 1
+#endif
+
+#include "RowExporter.hpp"
+
+/// <summary>
+/// Worst-case UTF-8 output of one UTF-16 code unit after escaping: a JSON "\u00XX" escape.
+/// </summary>
+constexpr std::size_t MAX_ESCAPED_BYTES = 6;
+
+/// <summary>
+/// Number of UTF-16 code units examined per block.
+/// </summary>
+constexpr std::size_t BLOCK = 8;
+
+/// <summary>
+/// 100-nanosecond intervals between 1601-01-01 (FILETIME epoch) and 1970-01-01 (Unix epoch).
+/// </summary>
+constexpr std::uint64_t FILETIME_UNIX_EPOCH = 116'444'736'000'000'000ULL;
+
+/// <summary>
+/// Constructs an exporter.
+/// </summary>
+/// <param name="format">The output format.</param>
+/// <param name="out">The buffer rows are written to; must outlive the exporter.</param>
+RowExporter::RowExporter(ExportFormat format, OutputBuffer& out) noexcept : format_(format), out_(out)
+{ }
+
+/// <summary>
+/// Returns the current wall clock time.
+/// </summary>
+/// <returns>Milliseconds since the Unix epoch.</returns>
+std::uint64_t RowExporter::currentTimestampMs() noexcept
+{
+	FILETIME now{};
+	::GetSystemTimeAsFileTime(&now);
+
+	const std::uint64_t ticks = (static_cast<std::uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+	return (ticks - FILETIME_UNIX_EPOCH) / 10'000;
+}
+
+/// <summary>
+/// Writes the CSV header line. NDJSON has no header, so nothing is written in that format.
+/// </summary>
+void RowExporter::writeHeader()
+{
+	if (format_ == ExportFormat::Csv)
+	{
+		out_.append("tick,timestamp_ms,pid,name,user_sid,working_set_bytes,private_bytes\n");
+	}
+}
+
+/// <summary>
+/// Writes one process as a row. A row whose metadata is still pending gets a null name and SID (an empty unquoted CSV field,
+/// JSON null) rather than the PENDING_METADATA placeholder, so consumers never mistake it for a process name.
+/// </summary>
+/// <param name="process">The process.</param>
+/// <param name="tick">The zero-based tick the process was collected on.</param>
+/// <param name="timestampMs">The collection time of the tick, in milliseconds since the Unix epoch.</param>
+void RowExporter::writeRow(const ProcessInfo& process, std::size_t tick, std::uint64_t timestampMs)
+{
+	if (format_ == ExportFormat::Csv)
+	{
+		out_.appendUnsigned(tick);
+		out_.append(',');
+		out_.appendUnsigned(timestampMs);
+		out_.append(',');
+		out_.appendUnsigned(process.pid);
+		out_.append(',');
+
+		if (process.metadataPending)
+		{
+			appendNull();
+			out_.append(',');
+			appendNull();
+		}
+		else
+		{
+			appendString(process.name);
+			out_.append(',');
+			appendString(process.userSid);
+		}
+
+		out_.append(',');
+		out_.appendUnsigned(process.workingSetBytes);
+		out_.append(',');
+		out_.appendUnsigned(process.privateBytes);
+		out_.append('\n');
+		return;
+	}
+
+	out_.append("{\"tick\":");
+	out_.appendUnsigned(tick);
+	out_.append(",\"timestamp_ms\":");
+	out_.appendUnsigned(timestampMs);
+	out_.append(",\"pid\":");
+	out_.appendUnsigned(process.pid);
+	out_.append(",\"name\":");
+
+	if (process.metadataPending)
+	{
+		appendNull();
+		out_.append(",\"user_sid\":");
+		appendNull();
+	}
+	else
+	{
+		appendString(process.name);
+		out_.append(",\"user_sid\":");
+		appendString(process.userSid);
+	}
+
+	out_.append(",\"working_set_bytes\":");
+	out_.appendUnsigned(process.workingSetBytes);
+	out_.append(",\"private_bytes\":");
+	out_.appendUnsigned(process.privateBytes);
+	out_.append("}\n");
+}
+
+/// <summary>
+/// Returns whether a UTF-16 code unit can be copied as a single byte in both formats: printable ASCII other than '"' and '\'.
+/// </summary>
+/// <param name="c">The code unit.</param>
+/// <returns>true if no escaping or multi-byte encoding is needed.</returns>
+static bool isPlain(wchar_t c) noexcept
+{
+	return c >= 0x20 && c <= 0x7E && c != L'"' && c != L'\\';
+}
+
+/// <summary>
+/// Writes a string as a quoted field: UTF-16 is converted to UTF-8, and quotes are doubled (CSV) or characters escaped per RFC 8259 (JSON).
+/// Blocks of eight code units are tested with SSE2 where available; blocks that are entirely plain ASCII are narrowed and stored
+/// with one pack and one 8-byte store, and only blocks containing something special take the per-character path.
+/// </summary>
+/// <param name="text">The string.</param>
+void RowExporter::appendString(std::wstring_view text)
+{
+	const bool json = format_ == ExportFormat::Ndjson;
+	out_.append('"');
+
+	std::size_t i = 0;
+
+	while (i < text.size())
+	{
+		const std::size_t block = std::min(BLOCK, text.size() - i);
+		char* dst = out_.claim(BLOCK * MAX_ESCAPED_BYTES);
+		char* p = dst;
+
+#ifdef ROW_EXPORTER_SSE2
+		static_assert(sizeof(wchar_t) == 2, "The SSE2 path assumes UTF-16 wchar_t.");
+
+		if (block == BLOCK)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+
+			// Signed compares: code units >= 0x8000 are negative and so are caught by the "< 0x20" test.
+			const __m128i special = _mm_or_si128(
+				_mm_or_si128(_mm_cmplt_epi16(v, _mm_set1_epi16(0x20)), _mm_cmpgt_epi16(v, _mm_set1_epi16(0x7E))),
+				_mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16('"')), _mm_cmpeq_epi16(v, _mm_set1_epi16('\\'))));
+
+			if (_mm_movemask_epi8(special) == 0)
+			{
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(v, v));
+				out_.commit(BLOCK);
+				i += BLOCK;
+				continue;
+			}
+		}
+#endif
+
+		const std::size_t blockEnd = i + block;
+
+		for (; i < blockEnd; i++)
+		{
+			const auto c = static_cast<std::uint32_t>(static_cast<std::uint16_t>(text[i]));
+
+			if (isPlain(static_cast<wchar_t>(c)))
+			{
+				*p++ = static_cast<char>(c);
+			}
+			else if (c == '"')
+			{
+				*p++ = json ? '\\' : '"';
+				*p++ = '"';
+			}
+			else if (c == '\\')
+			{
+				if (json)
+				{
+					*p++ = '\\';
+				}
+
+				*p++ = '\\';
+			}
+			else if (c < 0x20)
+			{
+				if (!json)
+				{
+					// Control characters are legal inside a quoted CSV field.
+					*p++ = static_cast<char>(c);
+					continue;
+				}
+
+				constexpr char hex[] = "0123456789abcdef";
+				*p++ = '\\';
+				*p++ = 'u';
+				*p++ = '0';
+				*p++ = '0';
+				*p++ = hex[c >> 4];
+				*p++ = hex[c & 0xF];
+			}
+			else if (c < 0x80)
+			{
+				// DEL.
+				*p++ = static_cast<char>(c);
+			}
+			else if (c < 0x800)
+			{
+				*p++ = static_cast<char>(0xC0 | (c >> 6));
+				*p++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else if (c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size()
+				&& text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF)
+			{
+				const std::uint32_t low = static_cast<std::uint16_t>(text[i + 1]);
+				const std::uint32_t cp = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+
+				*p++ = static_cast<char>(0xF0 | (cp >> 18));
+				*p++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+				*p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+				*p++ = static_cast<char>(0x80 | (cp & 0x3F));
+
+				// The low surrogate may belong to the next block; consuming it here is fine since the claim covers it.
+				i++;
+			}
+			else
+			{
+				// Unpaired surrogates become U+FFFD.
+				const std::uint32_t cp = (c >= 0xD800 && c <= 0xDFFF) ? 0xFFFD : c;
+
+				*p++ = static_cast<char>(0xE0 | (cp >> 12));
+				*p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+				*p++ = static_cast<char>(0x80 | (cp & 0x3F));
+			}
+		}
+
+		out_.commit(static_cast<std::size_t>(p - dst));
+	}
+
+	out_.append('"');
+}
+
+/// <summary>
+/// Writes a missing value: nothing in CSV, where an unquoted empty field differs from the empty string "", and null in JSON.
+/// </summary>
+void RowExporter::appendNull()
+{
+	if (format_ == ExportFormat::Ndjson)
+	{
+		out_.append("null");
+	}
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "OutputBuffer.hpp"
+#include "ProcessInfo.hpp"
+
+/// <summary>
+/// Machine-readable row formats.
+/// </summary>
+enum class ExportFormat
+{
+	Csv,
+	Ndjson
+};
+
+/// <summary>
+/// Streams process rows as CSV or newline-delimited JSON into an OutputBuffer. Rows are formatted straight into the buffer with
+/// hand-rolled integer formatting and an escaping routine that converts names to UTF-8 eight characters at a time when they need
+/// no escaping, so exporting performs no per-row allocation.
+/// </summary>
+class RowExporter
+{
+public:
+	RowExporter(ExportFormat format, OutputBuffer& out) noexcept;
+
+	void writeHeader();
+
+	void writeRow(const ProcessInfo& process, std::size_t tick, std::uint64_t timestampMs);
+
+	[[nodiscard]] static std::uint64_t currentTimestampMs() noexcept;
+
+private:
+	void appendString(std::wstring_view text);
+
+	void appendNull();
+
+	/// <summary>
+	/// The output format.
+	/// </summary>
+	ExportFormat	format_;
+
+	/// <summary>
+	/// The buffer rows are written to.
+	/// </summary>
+	OutputBuffer&	out_;
+};
\ No newline at end of file
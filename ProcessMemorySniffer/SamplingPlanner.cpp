@@ -0,0 +1,139 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "SamplingPlanner.hpp"
+
+/// <summary>
+/// Two-sided 95% quantile of the standard normal distribution.
+/// </summary>
+constexpr double Z_95 = 1.959964;
+
+/// <summary>
+/// Constructs a planner.
+/// </summary>
+/// <param name="sampleSize">The number of non-heavy PIDs to query per tick.</param>
+/// <param name="heavyThreshold">Working set at or above which a process is always queried once seen.</param>
+SamplingPlanner::SamplingPlanner(std::size_t sampleSize, Bytes heavyThreshold)
+	: sampleSize_(sampleSize), heavyThreshold_(heavyThreshold), random_(std::random_device{}())
+{ }
+
+/// <summary>
+/// Chooses the PIDs to query this tick: every enumerated PID that is a known heavy hitter, plus a uniform random sample without replacement of the others (a partial Fisher-Yates shuffle, so the cost is proportional to the sample, not the population).
+/// </summary>
+/// <param name="pids">All PIDs enumerated this tick.</param>
+/// <returns>The PIDs to query, heavy hitters first.</returns>
+std::vector<DWORD> SamplingPlanner::plan(const std::vector<DWORD>& pids)
+{
+	std::vector<DWORD> planned;
+	std::vector<DWORD> rest;
+	rest.reserve(pids.size());
+	plannedHeavy_.clear();
+
+	for (DWORD pid : pids)
+	{
+		if (heavy_.contains(pid))
+		{
+			planned.push_back(pid);
+			plannedHeavy_.insert(pid);
+		}
+		else
+		{
+			rest.push_back(pid);
+		}
+	}
+
+	population_ = pids.size();
+	remaining_ = rest.size();
+	sampled_ = std::min(sampleSize_, rest.size());
+
+	for (std::size_t i = 0; i < sampled_; i++)
+	{
+		std::uniform_int_distribution<std::size_t> pick(i, rest.size() - 1);
+		std::swap(rest[i], rest[pick(random_)]);
+		planned.push_back(rest[i]);
+	}
+
+	return planned;
+}
+
+/// <summary>
+/// Estimates the totals over all processes from the processes queried this tick, and updates the heavy hitter set for the next tick.
+/// The heavy stratum contributes exactly. The sampled stratum is scaled up by remaining / sampled; sampled PIDs that could not be queried count as zero,
+/// matching the full mode which omits inaccessible processes. The margin uses the sample variance with the finite population correction.
+/// </summary>
+/// <param name="queried">The processes successfully queried from the PIDs returned by plan().</param>
+/// <returns>The estimate for this tick.</returns>
+SampleEstimate SamplingPlanner::record(const std::vector<ProcessInfo>& queried)
+{
+	SampleEstimate estimate;
+	estimate.population = population_;
+	estimate.heavyCount = plannedHeavy_.size();
+	estimate.sampledCount = sampled_;
+
+	double heavyWs = 0.0;
+	double heavyPriv = 0.0;
+	double sumWs = 0.0;
+	double sumPriv = 0.0;
+	double sumSqWs = 0.0;
+	double sumSqPriv = 0.0;
+
+	heavy_.clear();
+
+	for (const auto& p : queried)
+	{
+		const double ws = static_cast<double>(p.workingSetBytes);
+		const double priv = static_cast<double>(p.privateBytes);
+
+		if (plannedHeavy_.contains(p.pid))
+		{
+			heavyWs += ws;
+			heavyPriv += priv;
+		}
+		else
+		{
+			sumWs += ws;
+			sumPriv += priv;
+			sumSqWs += ws * ws;
+			sumSqPriv += priv * priv;
+		}
+
+		if (p.workingSetBytes >= heavyThreshold_)
+		{
+			heavy_.insert(p.pid);
+		}
+	}
+
+	const auto scaled = [this](double heavySum, double sum, double sumSq)
+		{
+			EstimatedTotal total;
+			total.value = heavySum;
+
+			if (sampled_ == 0)
+			{
+				return total;
+			}
+
+			const double n = static_cast<double>(sampled_);
+			const double population = static_cast<double>(remaining_);
+			const double mean = sum / n;
+
+			total.value += population * mean;
+
+			if (sampled_ > 1 && sampled_ < remaining_)
+			{
+				const double variance = std::max(0.0, (sumSq - n * mean * mean) / (n - 1.0));
+				const double correction = 1.0 - n / population;
+				total.margin = Z_95 * population * std::sqrt(variance * correction / n);
+			}
+
+			return total;
+		};
+
+	estimate.workingSetBytes = scaled(heavyWs, sumWs, sumSqWs);
+	estimate.privateBytes = scaled(heavyPriv, sumPriv, sumSqPriv);
+
+	return estimate;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "ProcessInfo.hpp"
+
+/// <summary>
+/// An estimated total together with the half-width of its 95% confidence interval.
+/// </summary>
+struct EstimatedTotal
+{
+	/// <summary>
+	/// The point estimate.
+	/// </summary>
+	double	value{ 0.0 };
+
+	/// <summary>
+	/// Half-width of the 95% confidence interval; the interval is value +/- margin.
+	/// </summary>
+	double	margin{ 0.0 };
+};
+
+/// <summary>
+/// Result of one approximate tick: what was queried and the estimated totals over all processes.
+/// </summary>
+struct SampleEstimate
+{
+	/// <summary>
+	/// The number of PIDs enumerated this tick.
+	/// </summary>
+	std::size_t		population{ 0 };
+
+	/// <summary>
+	/// The number of previously known heavy hitters queried this tick (the exact stratum).
+	/// </summary>
+	std::size_t		heavyCount{ 0 };
+
+	/// <summary>
+	/// The number of randomly sampled PIDs queried this tick.
+	/// </summary>
+	std::size_t		sampledCount{ 0 };
+
+	/// <summary>
+	/// Estimated total working set over all accessible processes.
+	/// </summary>
+	EstimatedTotal	workingSetBytes;
+
+	/// <summary>
+	/// Estimated total private bytes over all accessible processes.
+	/// </summary>
+	EstimatedTotal	privateBytes;
+};
+
+/// <summary>
+/// Plans which PIDs to query on each tick of the approximate mode and turns the results into estimates.
+/// Every tick queries all known heavy hitters (processes whose working set reached the threshold when last seen) plus a uniform random
+/// sample of the remaining PIDs. Totals combine the exact heavy stratum with a scaled-up estimate of the sampled stratum.
+/// A process at or above the threshold is queried on every tick once it has been sampled, so the top-N is exact for every such
+/// process; a new one is sampled with probability sampleSize / remaining PIDs per tick.
+/// </summary>
+class SamplingPlanner
+{
+public:
+	SamplingPlanner(std::size_t sampleSize, Bytes heavyThreshold);
+
+	[[nodiscard]] std::vector<DWORD> plan(const std::vector<DWORD>& pids);
+
+	[[nodiscard]] SampleEstimate record(const std::vector<ProcessInfo>& queried);
+
+private:
+	/// <summary>
+	/// The number of non-heavy PIDs to sample per tick.
+	/// </summary>
+	std::size_t					sampleSize_;
+
+	/// <summary>
+	/// Working set at or above which a process joins the heavy hitters.
+	/// </summary>
+	Bytes						heavyThreshold_;
+
+	/// <summary>
+	/// PIDs of the known heavy hitters. Plain PIDs suffice: the set is rebuilt from each tick's results, and a PID reused by a
+	/// small process only costs one query on the next tick (counted exactly, like any process queried with certainty) before it drops out.
+	/// </summary>
+	std::unordered_set<DWORD>	heavy_;
+
+	/// <summary>
+	/// The heavy hitters planned for the current tick.
+	/// </summary>
+	std::unordered_set<DWORD>	plannedHeavy_;
+
+	/// <summary>
+	/// The number of PIDs enumerated for the current tick.
+	/// </summary>
+	std::size_t					population_{ 0 };
+
+	/// <summary>
+	/// The number of non-heavy PIDs the sample was drawn from.
+	/// </summary>
+	std::size_t					remaining_{ 0 };
+
+	/// <summary>
+	/// The number of non-heavy PIDs sampled for the current tick, including those that turned out to be inaccessible.
+	/// </summary>
+	std::size_t					sampled_{ 0 };
+
+	/// <summary>
+	/// Random engine used to draw the samples.
+	/// </summary>
+	std::mt19937				random_;
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include <Windows.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "SketchStore.hpp"
+#include "TextEncoding.hpp"
+
+/// <summary>
+/// First line of a sketch file. Files with another header (a different format or relative accuracy) are rejected, since their buckets would not line up.
+/// </summary>
+constexpr const char* SKETCH_FILE_HEADER = "# ProcessMemorySniffer quantile sketches v1 accuracy=0.01";
+
+/// <summary>
+/// Adds one sample for a process name, creating its sketch on first use.
+/// </summary>
+/// <param name="name">The process name.</param>
+/// <param name="value">The sample, e.g. the working set in bytes.</param>
+void SketchStore::add(const std::wstring& name, std::uint64_t value)
+{
+	sketches_[name].add(value);
+}
+
+/// <summary>
+/// Merges every sketch of another store into this one, by name.
+/// </summary>
+/// <param name="other">The store to merge.</param>
+void SketchStore::merge(const SketchStore& other)
+{
+	for (const auto& [name, sketch] : other.sketches_)
+	{
+		sketches_[name].merge(sketch);
+	}
+}
+
+/// <summary>
+/// Loads a store from a sketch file. A missing file yields an empty store so that the first run of a summary starts from scratch.
+/// Each line after the header is "name<TAB>sketch" with the name UTF-8 encoded. Throws std::runtime_error if the file exists but is malformed.
+/// </summary>
+/// <param name="path">The file to load.</param>
+/// <returns>The loaded store.</returns>
+SketchStore SketchStore::load(const std::wstring& path)
+{
+	SketchStore store;
+	std::ifstream in(std::filesystem::path(path), std::ios::binary);
+
+	if (!in)
+	{
+		return store;
+	}
+
+	std::string line;
+
+	if (!std::getline(in, line) || line != SKETCH_FILE_HEADER)
+	{
+		throw std::runtime_error("Not a sketch file or unsupported sketch format: " + toUtf8(path));
+	}
+
+	std::size_t lineNumber = 1;
+
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+
+		if (line.empty())
+		{
+			continue;
+		}
+
+		const auto tab = line.find('\t');
+		QuantileSketch sketch;
+
+		if (tab == std::string::npos || !QuantileSketch::parse(std::string_view(line).substr(tab + 1), sketch))
+		{
+			throw std::runtime_error("Malformed sketch on line " + std::to_string(lineNumber) + " of " + toUtf8(path));
+		}
+
+		store.sketches_[fromUtf8(std::string_view(line).substr(0, tab))].merge(sketch);
+	}
+
+	return store;
+}
+
+/// <summary>
+/// Writes the store to a sketch file, replacing it. Throws std::runtime_error if the file cannot be written.
+/// </summary>
+/// <param name="path">The file to write.</param>
+void SketchStore::save(const std::wstring& path) const
+{
+	std::string text = SKETCH_FILE_HEADER;
+	text += '\n';
+
+	for (const auto& [name, sketch] : sketches_)
+	{
+		text += toUtf8(name);
+		text += '\t';
+		sketch.serialize(text);
+		text += '\n';
+	}
+
+	std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+	out.write(text.data(), static_cast<std::streamsize>(text.size()));
+
+	if (!out)
+	{
+		throw std::runtime_error("Failed to write sketch file: " + toUtf8(path));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "QuantileSketch.hpp"
+
+/// <summary>
+/// A set of quantile sketches keyed by process name, persisted as a text file with one sketch per line.
+/// Keying by name rather than PID lets summaries from different runs and hosts be merged.
+/// </summary>
+class SketchStore
+{
+public:
+	void add(const std::wstring& name, std::uint64_t value);
+
+	void merge(const SketchStore& other);
+
+	[[nodiscard]] static SketchStore load(const std::wstring& path);
+
+	void save(const std::wstring& path) const;
+
+	/// <summary>
+	/// Returns the sketches keyed by process name.
+	/// </summary>
+	/// <returns>A const reference to the sketch map.</returns>
+	[[nodiscard]] const std::map<std::wstring, QuantileSketch>& sketches() const noexcept
+	{
+		return sketches_;
+	}
+
+private:
+	/// <summary>
+	/// The sketches keyed by process name.
+	/// </summary>
+	std::map<std::wstring, QuantileSketch> sketches_;
+};
\ No newline at end of file
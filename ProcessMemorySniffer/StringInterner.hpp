@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// <summary>
+/// Identifier of an interned string. Valid only for the StringInterner that produced it.
+/// </summary>
+using StringId = std::uint32_t;
+
+/// <summary>
+/// Stores each distinct string once and hands out dense integer identifiers for them, so that collections referring to the same
+/// strings many times (module paths, process names, user names) only hold a 4-byte id per reference.
+/// Not thread safe; callers interning from several threads must serialize access.
+/// </summary>
+class StringInterner
+{
+public:
+	/// <summary>
+	/// Returns the identifier of a string, storing the string first if it has not been seen before.
+	/// </summary>
+	/// <param name="text">The string to intern.</param>
+	/// <returns>The identifier of the stored copy of text.</returns>
+	StringId intern(std::wstring_view text)
+	{
+		if (const auto it = ids_.find(text); it != ids_.end())
+		{
+			return it->second;
+		}
+
+		const auto id = static_cast<StringId>(strings_.size());
+
+		// std::deque never relocates existing elements on push_back, so the views used as map keys stay valid.
+		const std::wstring& stored = strings_.emplace_back(text);
+		ids_.emplace(std::wstring_view(stored), id);
+
+		return id;
+	}
+
+	/// <summary>
+	/// Returns the identifier of a string that has already been interned.
+	/// </summary>
+	/// <param name="text">The string to look up.</param>
+	/// <param name="id">Receives the identifier if the string is known.</param>
+	/// <returns>true if the string has been interned; false otherwise.</returns>
+	[[nodiscard]] bool tryFind(std::wstring_view text, StringId& id) const noexcept
+	{
+		const auto it = ids_.find(text);
+
+		if (it == ids_.end())
+		{
+			return false;
+		}
+
+		id = it->second;
+		return true;
+	}
+
+	/// <summary>
+	/// Returns the string for an identifier.
+	/// </summary>
+	/// <param name="id">An identifier returned by intern().</param>
+	/// <returns>A reference to the stored string. It stays valid for the lifetime of the interner.</returns>
+	[[nodiscard]] const std::wstring& lookup(StringId id) const noexcept
+	{
+		return strings_[id];
+	}
+
+	/// <summary>
+	/// Returns the number of distinct strings stored.
+	/// </summary>
+	/// <returns>The number of strings; identifiers range over [0, size()).</returns>
+	[[nodiscard]] std::size_t size() const noexcept
+	{
+		return strings_.size();
+	}
+
+private:
+	/// <summary>
+	/// The stored strings, indexed by identifier.
+	/// </summary>
+	std::deque<std::wstring> strings_;
+
+	/// <summary>
+	/// Maps each stored string (viewed in place) to its identifier.
+	/// </summary>
+	std::unordered_map<std::wstring_view, StringId> ids_;
+};
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include <Windows.h>
+#include <Psapi.h>
+#include <winternl.h>
+
+#include "SystemMemory.hpp"
+#include "ResourceCounters.hpp"
+
+#pragma comment(lib, "Psapi.lib")
+#pragma comment(lib, "ntdll.lib")
+
+/// <summary>
+/// The information class returning SYSTEM_FILECACHE_INFORMATION; not named in winternl.h.
+/// </summary>
+constexpr auto SYSTEM_FILE_CACHE_INFORMATION = static_cast<SYSTEM_INFORMATION_CLASS>(21);
+
+/// <summary>
+/// The leading members of SYSTEM_FILECACHE_INFORMATION, which winternl.h does not declare. CurrentSize is the system working
+/// set in bytes.
+/// </summary>
+struct FileCacheInformation
+{
+	SIZE_T	CurrentSize;
+	SIZE_T	PeakSize;
+	ULONG	PageFaultCount;
+	SIZE_T	MinimumWorkingSet;
+	SIZE_T	MaximumWorkingSet;
+	SIZE_T	CurrentSizeIncludingTransitionInPages;
+	SIZE_T	PeakSizeIncludingTransitionInPages;
+	ULONG	TransitionRePurposeCount;
+	ULONG	Flags;
+};
+
+/// <summary>
+/// Reads the size of the system working set. Querying it needs no privilege, unlike changing its limits.
+/// </summary>
+/// <returns>The size in bytes; std::nullopt if NtQuerySystemInformation failed.</returns>
+static std::optional<Bytes> querySystemWorkingSet() noexcept
+{
+	FileCacheInformation info{};
+	ULONG length = 0;
+
+	countSystemCall();
+	if (::NtQuerySystemInformation(SYSTEM_FILE_CACHE_INFORMATION, &info, sizeof(info), &length) < 0)
+	{
+		return std::nullopt;
+	}
+
+	return static_cast<Bytes>(info.CurrentSize);
+}
+
+/// <summary>
+/// Reads the system-wide memory figures with a GetPerformanceInfo call, which reports physical memory, the system cache,
+/// the kernel pools and the commit charge together (GlobalMemoryStatusEx would only add the memory load, derived from the same counts),
+/// plus the system working set, which GetPerformanceInfo only reports combined with the standby list.
+/// </summary>
+/// <returns>The figures in bytes; std::nullopt if GetPerformanceInfo failed.</returns>
+std::optional<SystemMemory> querySystemMemory() noexcept
+{
+	PERFORMANCE_INFORMATION info{};
+
+	countSystemCall();
+	if (!::GetPerformanceInfo(&info, sizeof(info)))
+	{
+		return std::nullopt;
+	}
+
+	// Everything but the counts is reported in pages.
+	const Bytes page = static_cast<Bytes>(info.PageSize);
+
+	SystemMemory memory;
+	memory.physicalTotalBytes = static_cast<Bytes>(info.PhysicalTotal) * page;
+	memory.physicalAvailableBytes = static_cast<Bytes>(info.PhysicalAvailable) * page;
+	memory.systemCacheBytes = static_cast<Bytes>(info.SystemCache) * page;
+	memory.kernelPagedBytes = static_cast<Bytes>(info.KernelPaged) * page;
+	memory.kernelNonPagedBytes = static_cast<Bytes>(info.KernelNonpaged) * page;
+	memory.commitTotalBytes = static_cast<Bytes>(info.CommitTotal) * page;
+	memory.commitLimitBytes = static_cast<Bytes>(info.CommitLimit) * page;
+	memory.processCount = info.ProcessCount;
+	memory.systemWorkingSetBytes = querySystemWorkingSet();
+
+	return memory;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <optional>
+
+#include "ProcessInfo.hpp"
+
+/// <summary>
+/// System-wide memory figures, the context the per-process table is read against.
+/// </summary>
+struct SystemMemory
+{
+	/// <summary>
+	/// The physical memory installed and usable by Windows.
+	/// </summary>
+	Bytes	physicalTotalBytes{ 0 };
+
+	/// <summary>
+	/// The physical memory available without trimming any working set: free, zeroed and standby (cached, reclaimable) pages.
+	/// </summary>
+	Bytes	physicalAvailableBytes{ 0 };
+
+	/// <summary>
+	/// The system cache as GetPerformanceInfo counts it: the standby list plus the system working set. Standby pages are
+	/// also counted as available, so this is only partly in use and must not be subtracted from the memory in use.
+	/// </summary>
+	Bytes	systemCacheBytes{ 0 };
+
+	/// <summary>
+	/// The system working set (the file cache pages actually resident and in use); std::nullopt if it could not be queried.
+	/// </summary>
+	std::optional<Bytes>	systemWorkingSetBytes;
+
+	/// <summary>
+	/// The paged kernel pool, which may be partly paged out.
+	/// </summary>
+	Bytes	kernelPagedBytes{ 0 };
+
+	/// <summary>
+	/// The non-paged kernel pool, always resident.
+	/// </summary>
+	Bytes	kernelNonPagedBytes{ 0 };
+
+	/// <summary>
+	/// The committed memory of the whole system and its current limit (physical memory plus page files).
+	/// </summary>
+	Bytes	commitTotalBytes{ 0 };
+	Bytes	commitLimitBytes{ 0 };
+
+	/// <summary>
+	/// The number of processes running, including those the sniffer cannot open.
+	/// </summary>
+	DWORD	processCount{ 0 };
+
+	/// <summary>
+	/// Returns the physical memory in use.
+	/// </summary>
+	/// <returns>The total minus the available physical memory.</returns>
+	[[nodiscard]] Bytes physicalInUseBytes() const noexcept
+	{
+		return physicalTotalBytes - physicalAvailableBytes;
+	}
+};
+
+[[nodiscard]] std::optional<SystemMemory> querySystemMemory() noexcept;
\ No newline at end of file
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "AccountNameCache.hpp"
+#include "ByteFormat.hpp"
+#include "ProcessInfo.hpp"
+
+/// <summary>
+/// The longest process name shown as is, in characters; longer names are cut by displayNameOf().
+/// </summary>
+constexpr std::size_t MAX_NAME_LEN = 28;
+
+/// <summary>
+/// Shortens a process name for display: a name longer than MAX_NAME_LEN characters keeps its first MAX_NAME_LEN - 1
+/// characters followed by "...". Used by every report that prints process or executable names, so they are cut alike.
+/// </summary>
+/// <param name="name">The process name.</param>
+/// <returns>The name, shortened if necessary.</returns>
+inline std::wstring displayNameOf(const std::wstring& name)
+{
+	if (name.size() > MAX_NAME_LEN)
+	{
+		return name.substr(0, MAX_NAME_LEN - 1) + L"...";
+	}
+
+	return name;
+}
+
+/// <summary>
+/// Everything a column may read for one row of the process table.
+/// </summary>
+struct TableRow
+{
+	/// <summary>
+	/// The process shown on the row.
+	/// </summary>
+	const ProcessInfo&	process;
+
+	/// <summary>
+	/// The working set of the same process (PID and start time) on the previous tick, or nullptr if it was not seen (first tick, or a new process, including one that reused a PID).
+	/// Only looked up when the column list contains WorkingSetDeltaColumn.
+	/// </summary>
+	const Bytes*		previousWorkingSet;
+
+	/// <summary>
+	/// Resolves owner SIDs; only used by UserColumn.
+	/// </summary>
+	AccountNameCache&	accounts;
+
+	/// <summary>
+	/// The command line of the process, empty if it could not be read. Only read when the column list contains CommandLineColumn.
+	/// </summary>
+	std::wstring_view	commandLine;
+};
+
+// Each column is a stateless type with a header, a width and a static write() that performs exactly one stream insertion,
+// so the std::setw() issued by ColumnList applies to it. A width of 0 leaves the column unpadded (last column).
+
+/// <summary>
+/// The process id.
+/// </summary>
+struct PidColumn
+{
+	static constexpr const wchar_t* HEADER = L"PID";
+	static constexpr int WIDTH = 8;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << row.process.pid;
+	}
+};
+
+/// <summary>
+/// The process name, shortened by displayNameOf().
+/// </summary>
+struct NameColumn
+{
+	static constexpr const wchar_t* HEADER = L"Process";
+	static constexpr int WIDTH = 30;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << displayNameOf(row.process.name);
+	}
+};
+
+/// <summary>
+/// The working set.
+/// </summary>
+struct WorkingSetColumn
+{
+	static constexpr const wchar_t* HEADER = L"Working Set";
+	static constexpr int WIDTH = 16;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << formatBytes(row.process.workingSetBytes);
+	}
+};
+
+/// <summary>
+/// The change of the working set since the previous tick, signed; "-" on the first tick and for processes not seen on the previous tick.
+/// </summary>
+struct WorkingSetDeltaColumn
+{
+	static constexpr const wchar_t* HEADER = L"WS Delta";
+	static constexpr int WIDTH = 16;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		if (row.previousWorkingSet == nullptr)
+		{
+			out << L"-";
+			return;
+		}
+
+		out << formatByteDelta(static_cast<std::int64_t>(row.process.workingSetBytes) - static_cast<std::int64_t>(*row.previousWorkingSet));
+	}
+};
+
+/// <summary>
+/// The peak working set.
+/// </summary>
+struct PeakWorkingSetColumn
+{
+	static constexpr const wchar_t* HEADER = L"Peak WS";
+	static constexpr int WIDTH = 16;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << formatBytes(row.process.peakWorkingSetBytes);
+	}
+};
+
+/// <summary>
+/// The private bytes (commit charge).
+/// </summary>
+struct PrivateColumn
+{
+	static constexpr const wchar_t* HEADER = L"Private";
+	static constexpr int WIDTH = 16;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << formatBytes(row.process.privateBytes);
+	}
+};
+
+/// <summary>
+/// The kernel pool memory charged to the process (paged plus non-paged).
+/// </summary>
+struct KernelPoolColumn
+{
+	static constexpr const wchar_t* HEADER = L"Kernel Pool";
+	static constexpr int WIDTH = 16;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << formatBytes(row.process.kernelBytes());
+	}
+};
+
+/// <summary>
+/// The private bytes plus the kernel pool memory charged to the process.
+/// </summary>
+struct TrueCostColumn
+{
+	static constexpr const wchar_t* HEADER = L"True Cost";
+	static constexpr int WIDTH = 16;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << formatBytes(row.process.trueCostBytes());
+	}
+};
+
+/// <summary>
+/// The account owning the process.
+/// </summary>
+struct UserColumn
+{
+	static constexpr const wchar_t* HEADER = L"User";
+	static constexpr int WIDTH = 0;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		out << row.accounts.resolve(row.process.userSid);
+	}
+};
+
+/// <summary>
+/// The command line of the process, as truncated by CommandLineStore; "-" if it could not be read.
+/// </summary>
+struct CommandLineColumn
+{
+	static constexpr const wchar_t* HEADER = L"Command Line";
+	static constexpr int WIDTH = 0;
+
+	static void write(std::wostream& out, const TableRow& row)
+	{
+		if (row.commandLine.empty())
+		{
+			out << L"-";
+			return;
+		}
+
+		out << row.commandLine;
+	}
+};
+
+/// <summary>
+/// A compile-time list of columns. The header and row writers are fold expressions over the list, so each instantiation
+/// formats its columns in sequence with no per-cell branching or indirect calls; columns that are not listed cost nothing,
+/// including the lookups they would need (e.g. the owner name or the previous tick).
+/// </summary>
+template <typename... Columns>
+struct ColumnList
+{
+	/// <summary>
+	/// Whether Column is part of the list.
+	/// </summary>
+	template <typename Column>
+	static constexpr bool CONTAINS = (std::is_same_v<Column, Columns> || ...);
+
+	/// <summary>
+	/// Writes the header line.
+	/// </summary>
+	/// <param name="out">The stream to write to.</param>
+	static void writeHeader(std::wostream& out)
+	{
+		out << std::left;
+		((out << std::setw(Columns::WIDTH) << Columns::HEADER), ...);
+		out << L"\n";
+	}
+
+	/// <summary>
+	/// Writes one row.
+	/// </summary>
+	/// <param name="out">The stream to write to.</param>
+	/// <param name="row">The row.</param>
+	static void writeRow(std::wostream& out, const TableRow& row)
+	{
+		out << std::left;
+		((out << std::setw(Columns::WIDTH), Columns::write(out, row)), ...);
+		out << L"\n";
+	}
+};
+
+/// <summary>
+/// The column presets selectable with --columns; each is instantiated once and chosen at run time by a single switch.
+/// </summary>
+using DefaultColumns = ColumnList<PidColumn, NameColumn, WorkingSetColumn, PrivateColumn, UserColumn>;
+using CompactColumns = ColumnList<PidColumn, NameColumn, WorkingSetColumn>;
+using MemoryColumns = ColumnList<PidColumn, NameColumn, WorkingSetColumn, WorkingSetDeltaColumn, PeakWorkingSetColumn, PrivateColumn, KernelPoolColumn, TrueCostColumn>;
+using FullColumns = ColumnList<PidColumn, NameColumn, WorkingSetColumn, WorkingSetDeltaColumn, PeakWorkingSetColumn, PrivateColumn, KernelPoolColumn, TrueCostColumn, UserColumn>;
+using CommandLineColumns = ColumnList<PidColumn, NameColumn, WorkingSetColumn, PrivateColumn, CommandLineColumn>;
\ No newline at end of file
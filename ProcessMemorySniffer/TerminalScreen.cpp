@@ -0,0 +1,253 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+
+#include "TerminalScreen.hpp"
+#include "Win32Error.hpp"
+
+/// <summary>
+/// Returns the SGR escape sequence selecting a cell style.
+/// </summary>
+/// <param name="style">The style.</param>
+/// <returns>The escape sequence.</returns>
+static std::wstring_view styleSequence(CellStyle style) noexcept
+{
+	switch (style)
+	{
+	case CellStyle::Header:
+		return L"\x1b[0;7m";
+	case CellStyle::Highlight:
+		return L"\x1b[0;1;33m";
+	default:
+		return L"\x1b[0m";
+	}
+}
+
+/// <summary>
+/// Switches the console to the alternate screen with virtual terminal processing enabled and key input delivered unbuffered. Throws a Win32Error if standard output or input is not a console or a console mode cannot be set, with the original modes restored.
+/// </summary>
+TerminalScreen::TerminalScreen()
+	: output_(::GetStdHandle(STD_OUTPUT_HANDLE)), input_(::GetStdHandle(STD_INPUT_HANDLE))
+{
+	if (!::GetConsoleMode(output_, &originalOutputMode_) || !::GetConsoleMode(input_, &originalInputMode_))
+	{
+		throw Win32Error("The live view requires an interactive console.");
+	}
+
+	if (!::SetConsoleMode(output_, originalOutputMode_ | ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+	{
+		throw Win32Error("Failed to enable virtual terminal processing.");
+	}
+
+	// The destructor does not run if the constructor throws, so the modes set so far are restored here.
+	try
+	{
+		if (!::SetConsoleMode(input_, originalInputMode_ & ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT | ENABLE_PROCESSED_INPUT)))
+		{
+			throw Win32Error("Failed to switch console input to unbuffered mode.");
+		}
+
+		// Alternate screen, hidden cursor.
+		write(L"\x1b[?1049h\x1b[?25l");
+	}
+	catch (...)
+	{
+		::SetConsoleMode(input_, originalInputMode_);
+		::SetConsoleMode(output_, originalOutputMode_);
+		throw;
+	}
+}
+
+/// <summary>
+/// Restores the primary screen, the cursor and the original console modes.
+/// </summary>
+TerminalScreen::~TerminalScreen() noexcept
+{
+	try
+	{
+		write(L"\x1b[0m\x1b[?25h\x1b[?1049l");
+	}
+	catch (...)
+	{
+	}
+
+	::SetConsoleMode(input_, originalInputMode_);
+	::SetConsoleMode(output_, originalOutputMode_);
+}
+
+/// <summary>
+/// Starts a new frame: picks up console window size changes and clears the back buffer.
+/// </summary>
+void TerminalScreen::beginFrame()
+{
+	CONSOLE_SCREEN_BUFFER_INFO info{};
+	int width = 80;
+	int height = 25;
+
+	if (::GetConsoleScreenBufferInfo(output_, &info))
+	{
+		width = info.srWindow.Right - info.srWindow.Left + 1;
+		height = info.srWindow.Bottom - info.srWindow.Top + 1;
+	}
+
+	if (width != width_ || height != height_)
+	{
+		width_ = width;
+		height_ = height;
+		front_.assign(static_cast<std::size_t>(width_) * height_, Cell{});
+		frontValid_ = false;
+	}
+
+	back_.assign(static_cast<std::size_t>(width_) * height_, Cell{});
+}
+
+/// <summary>
+/// Draws text into the back buffer, clipped to the screen. Each UTF-16 code unit occupies one cell.
+/// </summary>
+/// <param name="x">Zero-based column of the first character.</param>
+/// <param name="y">Zero-based row.</param>
+/// <param name="text">The text to draw.</param>
+/// <param name="style">The style to draw it with.</param>
+void TerminalScreen::put(int x, int y, std::wstring_view text, CellStyle style)
+{
+	if (y < 0 || y >= height_ || x >= width_)
+	{
+		return;
+	}
+
+	const std::size_t row = static_cast<std::size_t>(y) * width_;
+
+	for (std::size_t i = 0; i < text.size() && x + static_cast<int>(i) < width_; i++)
+	{
+		if (x + static_cast<int>(i) < 0)
+		{
+			continue;
+		}
+
+		Cell& cell = back_[row + x + i];
+		cell.ch = text[i] < L' ' ? L' ' : text[i];
+		cell.style = style;
+	}
+}
+
+/// <summary>
+/// Writes the differences between the back buffer and the screen. Runs of changed cells are emitted after a single cursor
+/// position sequence, which is skipped when the cursor already sits at the run start; style sequences are emitted only when the
+/// style changes. The whole update goes out in one WriteConsoleW call, and the back buffer becomes the front buffer.
+/// </summary>
+void TerminalScreen::present()
+{
+	out_.clear();
+
+	if (!frontValid_)
+	{
+		out_ += L"\x1b[0m\x1b[2J";
+	}
+
+	int cursorX = -1;
+	int cursorY = -1;
+	CellStyle currentStyle = CellStyle::Normal;
+	bool styleKnown = false;
+
+	for (int y = 0; y < height_; y++)
+	{
+		const std::size_t row = static_cast<std::size_t>(y) * width_;
+
+		for (int x = 0; x < width_; x++)
+		{
+			const Cell& cell = back_[row + x];
+
+			if (frontValid_ && cell == front_[row + x])
+			{
+				continue;
+			}
+
+			if (y == height_ - 1 && x == width_ - 1)
+			{
+				// Writing the bottom-right cell would scroll the screen on consoles without deferred wrap.
+				continue;
+			}
+
+			if (x != cursorX || y != cursorY)
+			{
+				out_ += L"\x1b[";
+				out_ += std::to_wstring(y + 1);
+				out_ += L';';
+				out_ += std::to_wstring(x + 1);
+				out_ += L'H';
+			}
+
+			if (!styleKnown || cell.style != currentStyle)
+			{
+				out_ += styleSequence(cell.style);
+				currentStyle = cell.style;
+				styleKnown = true;
+			}
+
+			out_ += cell.ch;
+			cursorX = x + 1;
+			cursorY = y;
+		}
+	}
+
+	if (!out_.empty())
+	{
+		write(out_);
+	}
+
+	std::swap(front_, back_);
+	frontValid_ = true;
+}
+
+/// <summary>
+/// Waits for the next key press.
+/// </summary>
+/// <param name="timeoutMs">How long to wait, in milliseconds.</param>
+/// <param name="key">Receives the key event.</param>
+/// <returns>true if a key was pressed within the timeout; false on timeout.</returns>
+bool TerminalScreen::readKey(DWORD timeoutMs, KEY_EVENT_RECORD& key)
+{
+	const ULONGLONG deadline = ::GetTickCount64() + timeoutMs;
+
+	while (true)
+	{
+		const ULONGLONG now = ::GetTickCount64();
+		const DWORD remaining = now >= deadline ? 0 : static_cast<DWORD>(deadline - now);
+
+		if (::WaitForSingleObject(input_, remaining) != WAIT_OBJECT_0)
+		{
+			return false;
+		}
+
+		INPUT_RECORD record{};
+		DWORD read = 0;
+
+		if (!::ReadConsoleInputW(input_, &record, 1, &read))
+		{
+			throw Win32Error("ReadConsoleInputW failed.");
+		}
+
+		if (read == 1 && record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown)
+		{
+			key = record.Event.KeyEvent;
+			return true;
+		}
+
+		// Other events (key releases, focus, window size) are consumed; keep waiting for the remaining time.
+	}
+}
+
+/// <summary>
+/// Writes text to the console in a single call. Throws a Win32Error on failure.
+/// </summary>
+/// <param name="text">The text, including escape sequences.</param>
+void TerminalScreen::write(std::wstring_view text)
+{
+	DWORD written = 0;
+
+	if (!::WriteConsoleW(output_, text.data(), static_cast<DWORD>(text.size()), &written, nullptr))
+	{
+		throw Win32Error("WriteConsoleW failed.");
+	}
+}
\ No newline at end of file
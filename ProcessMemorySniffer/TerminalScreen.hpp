@@ -0,0 +1,132 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// Visual style of a screen cell.
+/// </summary>
+enum class CellStyle : std::uint8_t
+{
+	Normal,
+	Header,
+	Highlight
+};
+
+/// <summary>
+/// A single character cell of the terminal.
+/// </summary>
+struct Cell
+{
+	/// <summary>
+	/// The character shown in the cell.
+	/// </summary>
+	wchar_t		ch{ L' ' };
+
+	/// <summary>
+	/// The style the character is drawn with.
+	/// </summary>
+	CellStyle	style{ CellStyle::Normal };
+
+	[[nodiscard]] bool operator==(const Cell&) const noexcept = default;
+};
+
+/// <summary>
+/// Double-buffered full-screen terminal using virtual terminal sequences. Callers draw a frame into the back buffer with put();
+/// present() diffs it against the frame currently on screen and writes only the changed cells, with the cursor moves and style
+/// changes they need, in a single console write.
+/// The constructor switches to the alternate screen and raw key input; the destructor restores the console.
+/// </summary>
+class TerminalScreen
+{
+public:
+	TerminalScreen();
+
+	TerminalScreen(const TerminalScreen&) = delete;
+	TerminalScreen& operator=(const TerminalScreen&) = delete;
+
+	~TerminalScreen() noexcept;
+
+	void beginFrame();
+
+	void put(int x, int y, std::wstring_view text, CellStyle style = CellStyle::Normal);
+
+	void present();
+
+	[[nodiscard]] bool readKey(DWORD timeoutMs, KEY_EVENT_RECORD& key);
+
+	/// <summary>
+	/// Returns the width of the visible console window in cells.
+	/// </summary>
+	/// <returns>The width.</returns>
+	[[nodiscard]] int width() const noexcept
+	{
+		return width_;
+	}
+
+	/// <summary>
+	/// Returns the height of the visible console window in cells.
+	/// </summary>
+	/// <returns>The height.</returns>
+	[[nodiscard]] int height() const noexcept
+	{
+		return height_;
+	}
+
+private:
+	void write(std::wstring_view text);
+
+	/// <summary>
+	/// The console output handle.
+	/// </summary>
+	HANDLE				output_{ nullptr };
+
+	/// <summary>
+	/// The console input handle.
+	/// </summary>
+	HANDLE				input_{ nullptr };
+
+	/// <summary>
+	/// The output console mode to restore on destruction.
+	/// </summary>
+	DWORD				originalOutputMode_{ 0 };
+
+	/// <summary>
+	/// The input console mode to restore on destruction.
+	/// </summary>
+	DWORD				originalInputMode_{ 0 };
+
+	/// <summary>
+	/// The width of the buffers in cells.
+	/// </summary>
+	int					width_{ 0 };
+
+	/// <summary>
+	/// The height of the buffers in cells.
+	/// </summary>
+	int					height_{ 0 };
+
+	/// <summary>
+	/// Whether the front buffer reflects the screen; false after a resize, forcing a full repaint.
+	/// </summary>
+	bool				frontValid_{ false };
+
+	/// <summary>
+	/// The frame being drawn.
+	/// </summary>
+	std::vector<Cell>	back_;
+
+	/// <summary>
+	/// The frame currently on screen.
+	/// </summary>
+	std::vector<Cell>	front_;
+
+	/// <summary>
+	/// Escape sequence output of the current present(), reused across frames.
+	/// </summary>
+	std::wstring		out_;
+};
\ No newline at end of file
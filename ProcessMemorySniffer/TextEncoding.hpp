@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <string>
+#include <string_view>
+
+/// <summary>
+/// Converts a UTF-16 string to UTF-8.
+/// </summary>
+/// <param name="text">The wide string to convert.</param>
+/// <returns>The UTF-8 encoded string; unpaired surrogates are replaced with U+FFFD.</returns>
+[[nodiscard]] inline std::string toUtf8(std::wstring_view text)
+{
+	if (text.empty())
+	{
+		return {};
+	}
+
+	const int length = ::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+	std::string result(static_cast<std::size_t>(length), '\0');
+	::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), result.data(), length, nullptr, nullptr);
+
+	return result;
+}
+
+/// <summary>
+/// Converts a UTF-8 string to UTF-16.
+/// </summary>
+/// <param name="text">The UTF-8 string to convert.</param>
+/// <returns>The wide string; invalid sequences are replaced with U+FFFD.</returns>
+[[nodiscard]] inline std::wstring fromUtf8(std::string_view text)
+{
+	if (text.empty())
+	{
+		return {};
+	}
+
+	const int length = ::MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+	std::wstring result(static_cast<std::size_t>(length), L'\0');
+	::MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), result.data(), length);
+
+	return result;
+}
\ No newline at end of file
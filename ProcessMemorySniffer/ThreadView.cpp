@@ -0,0 +1,282 @@
+#include <Windows.h>
+#include <TlHelp32.h>
+#include <winternl.h>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "ThreadView.hpp"
+#include "AddressIndex.hpp"
+#include "ProcessHandle.hpp"
+#include "ResourceCounters.hpp"
+#include "Win32Error.hpp"
+
+#pragma comment(lib, "ntdll.lib")
+
+/// <summary>
+/// The information class returning THREAD_BASIC_INFORMATION; not named in winternl.h.
+/// </summary>
+constexpr auto THREAD_BASIC_INFORMATION_CLASS = static_cast<THREADINFOCLASS>(0);
+
+/// <summary>
+/// The offset of the 32-bit TEB of a WOW64 thread from its 64-bit TEB.
+/// </summary>
+constexpr std::uintptr_t WOW64_TEB_OFFSET = 0x2000;
+
+/// <summary>
+/// THREAD_BASIC_INFORMATION as returned by NtQueryInformationThread; not declared in the SDK headers.
+/// </summary>
+struct ThreadBasicInformation
+{
+	NTSTATUS	exitStatus;
+	PVOID		tebBaseAddress;
+	HANDLE		uniqueProcess;
+	HANDLE		uniqueThread;
+	ULONG_PTR	affinityMask;
+	LONG		priority;
+	LONG		basePriority;
+};
+
+/// <summary>
+/// Lists the threads of a process from a single system-wide Toolhelp snapshot. Throws a Win32Error if the snapshot cannot be taken.
+/// </summary>
+/// <param name="pid">The process.</param>
+/// <returns>The thread ids of the process.</returns>
+static std::vector<DWORD> enumerateThreads(DWORD pid)
+{
+	countSystemCall();
+	const HANDLE rawSnapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+
+	if (rawSnapshot == INVALID_HANDLE_VALUE)
+	{
+		throw Win32Error("CreateToolhelp32Snapshot failed.");
+	}
+
+	const ProcessHandle snapshot(rawSnapshot);
+	THREADENTRY32 entry{};
+	entry.dwSize = sizeof(entry);
+	std::vector<DWORD> tids;
+
+	// One count per Thread32First / Thread32Next call, like the VirtualQueryEx loop of RegionQueryService.
+	countSystemCall();
+
+	for (BOOL more = ::Thread32First(snapshot.get(), &entry); more; more = ::Thread32Next(snapshot.get(), &entry))
+	{
+		if (entry.th32OwnerProcessID == pid)
+		{
+			tids.push_back(entry.th32ThreadID);
+		}
+
+		countSystemCall();
+	}
+
+	return tids;
+}
+
+/// <summary>
+/// Reads the stack range of a thread from the NT_TIB at the start of its TEB. For a WOW64 process the 32-bit TEB is read, as
+/// its stack is the one the thread's code runs on; the 64-bit stack only serves the WOW64 layer.
+/// </summary>
+/// <param name="process">The process; needs PROCESS_VM_READ access.</param>
+/// <param name="wow64">Whether the process runs under WOW64.</param>
+/// <param name="stack">The thread; receives top and limit.</param>
+/// <returns>true if the range was read; false if the thread could not be opened or has exited.</returns>
+static bool readStackRange(HANDLE process, bool wow64, ThreadStack& stack)
+{
+	countSystemCall();
+	const HANDLE rawThread = ::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, stack.tid);
+
+	if (rawThread == nullptr)
+	{
+		return false;
+	}
+
+	const ProcessHandle thread(rawThread);
+	ThreadBasicInformation basic{};
+
+	countSystemCall();
+	if (::NtQueryInformationThread(thread.get(), THREAD_BASIC_INFORMATION_CLASS, &basic, sizeof(basic), nullptr) < 0)
+	{
+		return false;
+	}
+
+	const auto teb = reinterpret_cast<std::uintptr_t>(basic.tebBaseAddress);
+
+#ifdef _WIN64
+	if (wow64)
+	{
+		NT_TIB32 tib{};
+
+		countSystemCall();
+		if (!::ReadProcessMemory(process, reinterpret_cast<LPCVOID>(teb + WOW64_TEB_OFFSET), &tib, sizeof(tib), nullptr))
+		{
+			return false;
+		}
+
+		stack.top = tib.StackBase;
+		stack.limit = tib.StackLimit;
+		return stack.top != 0;
+	}
+#else
+	(void)wow64;
+#endif
+
+	NT_TIB tib{};
+
+	countSystemCall();
+	if (!::ReadProcessMemory(process, reinterpret_cast<LPCVOID>(teb), &tib, sizeof(tib), nullptr))
+	{
+		return false;
+	}
+
+	stack.top = reinterpret_cast<std::uintptr_t>(tib.StackBase);
+	stack.limit = reinterpret_cast<std::uintptr_t>(tib.StackLimit);
+	return stack.top != 0;
+}
+
+/// <summary>
+/// Adds an allocation to a group's totals.
+/// </summary>
+/// <param name="totals">The group.</param>
+/// <param name="reserved">The reserved size of the allocation.</param>
+/// <param name="committed">The committed size of the allocation.</param>
+static void addAllocation(AllocationTotals& totals, Bytes reserved, Bytes committed) noexcept
+{
+	totals.count++;
+	totals.reservedBytes += reserved;
+	totals.committedBytes += committed;
+}
+
+/// <summary>
+/// Collects the thread stacks and heap-like allocations of a process. The stack ranges come from the TEBs (one small read per
+/// thread); everything else comes from a single walk of the address space: the stack tops are resolved to their reservations in
+/// one sorted merge against the region index, and one pass over the regions, grouped into allocations, sizes the stacks and
+/// classifies the remaining private allocations. Throws a Win32Error if the threads cannot be enumerated.
+/// </summary>
+/// <param name="regionService">Walks the address space.</param>
+/// <param name="pid">The process.</param>
+/// <returns>The view; std::nullopt if the process could not be opened or its address space not walked.</returns>
+std::optional<ThreadView> ThreadView::collect(const RegionQueryService& regionService, DWORD pid)
+{
+	auto handleOpt = ProcessHandle::open(pid);
+
+	if (!handleOpt)
+	{
+		return std::nullopt;
+	}
+
+	ThreadView view;
+	BOOL wow64 = FALSE;
+
+	countSystemCall();
+	view.wow64_ = ::IsWow64Process(handleOpt->get(), &wow64) && wow64;
+
+	for (const DWORD tid : enumerateThreads(pid))
+	{
+		ThreadStack stack;
+		stack.tid = tid;
+
+		if (readStackRange(handleOpt->get(), view.wow64_, stack))
+		{
+			view.stacks_.push_back(stack);
+		}
+		else
+		{
+			view.unreadableThreads_++;
+		}
+	}
+
+	std::vector<MemoryRegion> regions;
+
+	if (!regionService.collectRegions(handleOpt->get(), regions))
+	{
+		return std::nullopt;
+	}
+
+	const AddressIndex index(std::move(regions));
+
+	// The top of a stack is one past its highest address, so top - 1 lies in the committed part of the reservation.
+	std::vector<std::size_t> byTop(view.stacks_.size());
+	std::iota(byTop.begin(), byTop.end(), std::size_t{ 0 });
+	std::sort(byTop.begin(), byTop.end(), [&view](std::size_t a, std::size_t b) { return view.stacks_[a].top < view.stacks_[b].top; });
+
+	std::vector<std::uintptr_t> addresses;
+	addresses.reserve(byTop.size());
+
+	for (const std::size_t i : byTop)
+	{
+		addresses.push_back(view.stacks_[i].top - 1);
+	}
+
+	std::vector<const MemoryRegion*> found;
+	index.findSorted(addresses, found);
+
+	// (allocation base, stack index), sorted by allocation base to be merged with the region list below.
+	std::vector<std::pair<std::uintptr_t, std::size_t>> stackAllocations;
+	stackAllocations.reserve(found.size());
+
+	for (std::size_t k = 0; k < found.size(); k++)
+	{
+		if (found[k] != nullptr && found[k]->type == RegionType::Private)
+		{
+			stackAllocations.emplace_back(found[k]->allocationBase, byTop[k]);
+		}
+	}
+
+	std::sort(stackAllocations.begin(), stackAllocations.end());
+
+	const auto& all = index.regions();
+	std::size_t nextStack = 0;
+
+	for (std::size_t r = 0; r < all.size();)
+	{
+		// The regions of one allocation are adjacent in the sorted list.
+		const std::uintptr_t allocation = all[r].allocationBase;
+		const bool isPrivate = all[r].type == RegionType::Private;
+		Bytes reserved = 0;
+		Bytes committed = 0;
+		bool readWrite = true;
+		bool guard = false;
+
+		for (; r < all.size() && all[r].allocationBase == allocation; r++)
+		{
+			reserved += all[r].size;
+
+			if (all[r].state == RegionState::Committed)
+			{
+				committed += all[r].size;
+				readWrite = readWrite && (all[r].protect & 0xFF) == PAGE_READWRITE;
+				guard = guard || (all[r].protect & PAGE_GUARD) != 0;
+			}
+		}
+
+		while (nextStack < stackAllocations.size() && stackAllocations[nextStack].first < allocation)
+		{
+			nextStack++;
+		}
+
+		if (nextStack < stackAllocations.size() && stackAllocations[nextStack].first == allocation)
+		{
+			ThreadStack& stack = view.stacks_[stackAllocations[nextStack].second];
+			stack.reservedBytes = reserved;
+			stack.committedBytes = committed;
+			stack.hasGuard = guard;
+			addAllocation(view.stackTotals_, reserved, committed);
+			nextStack++;
+			continue;
+		}
+
+		if (isPrivate)
+		{
+			addAllocation(readWrite && reserved >= MIN_ARENA_BYTES ? view.arenaTotals_ : view.otherPrivateTotals_, reserved, committed);
+		}
+	}
+
+	// Stacks whose top did not resolve to a private allocation (the thread exited between the reads) are not reported.
+	const std::size_t before = view.stacks_.size();
+	std::erase_if(view.stacks_, [](const ThreadStack& stack) { return stack.reservedBytes == 0; });
+	view.unreadableThreads_ += before - view.stacks_.size();
+
+	return view;
+}
\ No newline at end of file
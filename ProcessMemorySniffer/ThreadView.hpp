@@ -0,0 +1,171 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ProcessInfo.hpp"
+#include "RegionQueryService.hpp"
+
+/// <summary>
+/// The stack of one thread: the range the thread currently uses, read from its TEB, and the reservation holding it.
+/// </summary>
+struct ThreadStack
+{
+	/// <summary>
+	/// The thread id.
+	/// </summary>
+	DWORD			tid{ 0 };
+
+	/// <summary>
+	/// The top of the stack (NT_TIB.StackBase; stacks grow down from it).
+	/// </summary>
+	std::uintptr_t	top{ 0 };
+
+	/// <summary>
+	/// The lowest committed address of the stack (NT_TIB.StackLimit).
+	/// </summary>
+	std::uintptr_t	limit{ 0 };
+
+	/// <summary>
+	/// The size of the stack reservation (the whole allocation, including its reserved and guard pages).
+	/// </summary>
+	Bytes			reservedBytes{ 0 };
+
+	/// <summary>
+	/// The committed part of the stack reservation.
+	/// </summary>
+	Bytes			committedBytes{ 0 };
+
+	/// <summary>
+	/// Whether the stack still has a guard page, i.e. can grow further on demand.
+	/// </summary>
+	bool			hasGuard{ false };
+};
+
+/// <summary>
+/// Totals of a group of allocations (VirtualAlloc reservations).
+/// </summary>
+struct AllocationTotals
+{
+	/// <summary>
+	/// The number of allocations.
+	/// </summary>
+	std::size_t	count{ 0 };
+
+	/// <summary>
+	/// The reserved size, including the committed part.
+	/// </summary>
+	Bytes		reservedBytes{ 0 };
+
+	/// <summary>
+	/// The committed size.
+	/// </summary>
+	Bytes		committedBytes{ 0 };
+};
+
+/// <summary>
+/// Per-thread memory of one process: each thread's stack, and the private allocations that look like heap segments or
+/// allocator arenas. Windows heaps are not tied to threads, so arenas are reported for the process, not per thread.
+/// </summary>
+class ThreadView
+{
+public:
+	/// <summary>
+	/// The smallest reservation counted as a heap segment or arena: NT heap segments, the low fragmentation heap and common
+	/// allocators (jemalloc, mimalloc, tcmalloc) all reserve at least 1 MiB at a time, while one-off VirtualAlloc buffers are
+	/// often smaller.
+	/// </summary>
+	static constexpr Bytes MIN_ARENA_BYTES = 1024 * 1024;
+
+	[[nodiscard]] static std::optional<ThreadView> collect(const RegionQueryService& regionService, DWORD pid);
+
+	/// <summary>
+	/// Returns the threads whose stack was found, in the order the system listed them.
+	/// </summary>
+	/// <returns>A const reference to the thread stacks.</returns>
+	[[nodiscard]] const std::vector<ThreadStack>& stacks() const noexcept
+	{
+		return stacks_;
+	}
+
+	/// <summary>
+	/// Returns the number of threads whose stack could not be read (exited meanwhile, or access denied).
+	/// </summary>
+	/// <returns>The number of threads.</returns>
+	[[nodiscard]] std::size_t unreadableThreads() const noexcept
+	{
+		return unreadableThreads_;
+	}
+
+	/// <summary>
+	/// Returns the totals of all thread stacks.
+	/// </summary>
+	/// <returns>The totals; count is the number of stacks.</returns>
+	[[nodiscard]] const AllocationTotals& stackTotals() const noexcept
+	{
+		return stackTotals_;
+	}
+
+	/// <summary>
+	/// Returns the totals of the private read/write allocations of at least MIN_ARENA_BYTES that are not stacks.
+	/// </summary>
+	/// <returns>The totals.</returns>
+	[[nodiscard]] const AllocationTotals& arenaTotals() const noexcept
+	{
+		return arenaTotals_;
+	}
+
+	/// <summary>
+	/// Returns the totals of the remaining private allocations.
+	/// </summary>
+	/// <returns>The totals.</returns>
+	[[nodiscard]] const AllocationTotals& otherPrivateTotals() const noexcept
+	{
+		return otherPrivateTotals_;
+	}
+
+	/// <summary>
+	/// Returns whether the process is a 32-bit process on 64-bit Windows, whose stacks are read from its 32-bit TEBs.
+	/// </summary>
+	/// <returns>true for a WOW64 process.</returns>
+	[[nodiscard]] bool wow64() const noexcept
+	{
+		return wow64_;
+	}
+
+private:
+	/// <summary>
+	/// The thread stacks.
+	/// </summary>
+	std::vector<ThreadStack>	stacks_;
+
+	/// <summary>
+	/// The number of threads whose stack could not be read.
+	/// </summary>
+	std::size_t					unreadableThreads_{ 0 };
+
+	/// <summary>
+	/// The totals of all thread stacks.
+	/// </summary>
+	AllocationTotals			stackTotals_;
+
+	/// <summary>
+	/// The totals of the heap- or arena-like allocations.
+	/// </summary>
+	AllocationTotals			arenaTotals_;
+
+	/// <summary>
+	/// The totals of the other private allocations.
+	/// </summary>
+	AllocationTotals			otherPrivateTotals_;
+
+	/// <summary>
+	/// Whether the process runs under WOW64.
+	/// </summary>
+	bool						wow64_{ false };
+};
\ No newline at end of file
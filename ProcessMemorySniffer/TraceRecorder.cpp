@@ -0,0 +1,212 @@
+#include <Windows.h>
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "TraceRecorder.hpp"
+#include "TextEncoding.hpp"
+
+/// <summary>
+/// The next recorder id; 0 is never handed out, so it marks an empty cache entry.
+/// </summary>
+static std::atomic<std::uint64_t> nextRecorderId{ 1 };
+
+/// <summary>
+/// The calling thread's buffer of the recorder it last recorded to.
+/// </summary>
+struct CachedTraceBuffer
+{
+	std::uint64_t	recorderId{ 0 };
+	void*			buffer{ nullptr };
+};
+
+static thread_local CachedTraceBuffer cachedBuffer;
+
+/// <summary>
+/// Constructs a recorder; its creation is time 0 of the trace.
+/// </summary>
+/// <param name="slowQueryThreshold">Queries that take at least this long are recorded as events of their own.</param>
+TraceRecorder::TraceRecorder(std::chrono::microseconds slowQueryThreshold) noexcept
+	: id_(nextRecorderId.fetch_add(1, std::memory_order_relaxed)), mainThreadId_(::GetCurrentThreadId()),
+	slowQueryNs_(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(slowQueryThreshold).count())),
+	origin_(std::chrono::steady_clock::now())
+{ }
+
+/// <summary>
+/// Returns the calling thread's buffer, registering one on the thread's first event.
+/// </summary>
+/// <returns>The buffer.</returns>
+TraceRecorder::ThreadBuffer& TraceRecorder::threadBuffer()
+{
+	if (cachedBuffer.recorderId == id_)
+	{
+		return *static_cast<ThreadBuffer*>(cachedBuffer.buffer);
+	}
+
+	const DWORD threadId = ::GetCurrentThreadId();
+	ThreadBuffer* result = nullptr;
+
+	{
+		std::lock_guard lock(mutex_);
+
+		// The cache holds one recorder per thread; a thread alternating between recorders finds its earlier buffer again.
+		for (const auto& buffer : buffers_)
+		{
+			if (buffer->threadId == threadId)
+			{
+				result = buffer.get();
+				break;
+			}
+		}
+
+		if (result == nullptr)
+		{
+			auto buffer = std::make_unique<ThreadBuffer>();
+			buffer->threadId = threadId;
+			buffer->events.reserve(256);
+			result = buffer.get();
+			buffers_.push_back(std::move(buffer));
+		}
+	}
+
+	cachedBuffer = { id_, result };
+	return *result;
+}
+
+/// <summary>
+/// Records a complete event on the calling thread.
+/// </summary>
+/// <param name="name">The event name, a string literal.</param>
+/// <param name="category">The event category, a string literal.</param>
+/// <param name="startNs">The start, from now().</param>
+/// <param name="endNs">The end, from now().</param>
+void TraceRecorder::record(const char* name, const char* category, std::uint64_t startNs, std::uint64_t endNs)
+{
+	threadBuffer().events.push_back({ name, category, startNs, endNs - startNs, 0, {} });
+}
+
+/// <summary>
+/// Records a per-process query on the calling thread if it took at least the slow-query threshold; faster queries are dropped,
+/// so the trace stays small while still showing the long tail.
+/// </summary>
+/// <param name="name">The event name, a string literal such as "query" or "regions".</param>
+/// <param name="pid">The queried process.</param>
+/// <param name="processName">The queried process' name; may be empty.</param>
+/// <param name="startNs">The start, from now().</param>
+/// <param name="endNs">The end, from now().</param>
+void TraceRecorder::recordQuery(const char* name, DWORD pid, const std::wstring& processName, std::uint64_t startNs, std::uint64_t endNs)
+{
+	if (endNs - startNs < slowQueryNs_)
+	{
+		return;
+	}
+
+	threadBuffer().events.push_back({ name, "slow", startNs, endNs - startNs, pid, processName });
+}
+
+/// <summary>
+/// Appends a string as a JSON string literal.
+/// </summary>
+/// <param name="text">The string to append to.</param>
+/// <param name="value">The UTF-8 string.</param>
+static void appendJsonString(std::string& text, std::string_view value)
+{
+	text += '"';
+
+	for (const char c : value)
+	{
+		if (c == '"' || c == '\\')
+		{
+			text += '\\';
+			text += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			char escape[8];
+			std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(c));
+			text += escape;
+		}
+		else
+		{
+			text += c;
+		}
+	}
+
+	text += '"';
+}
+
+/// <summary>
+/// Appends a nanosecond quantity as microseconds with three decimals, the unit of trace-event timestamps.
+/// </summary>
+/// <param name="text">The string to append to.</param>
+/// <param name="ns">The quantity in nanoseconds.</param>
+static void appendMicroseconds(std::string& text, std::uint64_t ns)
+{
+	char number[32];
+	std::snprintf(number, sizeof(number), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000), static_cast<unsigned long long>(ns % 1000));
+	text += number;
+}
+
+/// <summary>
+/// Writes the recorded events as Chrome trace-event JSON: a thread_name metadata event per recording thread followed by its
+/// complete events. Slow-query events carry the queried PID and process name as arguments.
+/// </summary>
+/// <param name="path">The file to write.</param>
+void TraceRecorder::write(const std::wstring& path) const
+{
+	const std::string selfPid = std::to_string(::GetCurrentProcessId());
+	std::string text = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+
+	auto beginEvent = [&](DWORD threadId)
+	{
+		text += first ? "{" : ",\n{";
+		first = false;
+		text += "\"pid\":" + selfPid + ",\"tid\":" + std::to_string(threadId) + ",";
+	};
+
+	for (const auto& entry : buffers_)
+	{
+		const ThreadBuffer& buffer = *entry;
+
+		beginEvent(buffer.threadId);
+		text += "\"ph\":\"M\",\"name\":\"thread_name\",\"args\":{\"name\":";
+		appendJsonString(text, buffer.threadId == mainThreadId_ ? "main" : "worker");
+		text += "}}";
+
+		for (const auto& event : buffer.events)
+		{
+			beginEvent(buffer.threadId);
+			text += "\"ph\":\"X\",\"name\":";
+			appendJsonString(text, event.name);
+			text += ",\"cat\":";
+			appendJsonString(text, event.category);
+			text += ",\"ts\":";
+			appendMicroseconds(text, event.startNs);
+			text += ",\"dur\":";
+			appendMicroseconds(text, event.durationNs);
+
+			if (event.pid != 0)
+			{
+				text += ",\"args\":{\"pid\":" + std::to_string(event.pid) + ",\"process\":";
+				appendJsonString(text, toUtf8(event.detail));
+				text += "}";
+			}
+
+			text += "}";
+		}
+	}
+
+	text += "\n]}\n";
+
+	std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+	out.write(text.data(), static_cast<std::streamsize>(text.size()));
+
+	if (!out)
+	{
+		throw std::runtime_error("Failed to write trace file: " + toUtf8(path));
+	}
+}
\ No newline at end of file
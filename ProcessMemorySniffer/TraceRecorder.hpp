@@ -0,0 +1,137 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// One complete ("ph": "X") trace event.
+/// </summary>
+struct TraceEvent
+{
+	/// <summary>
+	/// The event name and category; string literals, so recording never copies them.
+	/// </summary>
+	const char*		name{ nullptr };
+	const char*		category{ nullptr };
+
+	/// <summary>
+	/// The start, relative to the recorder's creation, and the duration, in nanoseconds.
+	/// </summary>
+	std::uint64_t	startNs{ 0 };
+	std::uint64_t	durationNs{ 0 };
+
+	/// <summary>
+	/// The queried process, or 0 for events that do not concern one process.
+	/// </summary>
+	DWORD			pid{ 0 };
+
+	/// <summary>
+	/// The queried process' name; only set for slow-query events, which are rare.
+	/// </summary>
+	std::wstring	detail;
+};
+
+/// <summary>
+/// Records phase and slow-query events of a run and writes them as Chrome trace-event JSON, which chrome://tracing and
+/// Perfetto (ui.perfetto.dev) open directly. Each recording thread appends to its own buffer without locking; the recorder's
+/// mutex is only taken the first time a thread records. write() must be called once no thread records anymore.
+/// </summary>
+class TraceRecorder
+{
+public:
+	explicit TraceRecorder(std::chrono::microseconds slowQueryThreshold) noexcept;
+
+	TraceRecorder(const TraceRecorder&) = delete;
+	TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+	/// <summary>
+	/// Returns the time since the recorder was created, the time base of all events.
+	/// </summary>
+	/// <returns>The time in nanoseconds.</returns>
+	[[nodiscard]] std::uint64_t now() const noexcept
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin_).count());
+	}
+
+	void record(const char* name, const char* category, std::uint64_t startNs, std::uint64_t endNs);
+
+	void recordQuery(const char* name, DWORD pid, const std::wstring& processName, std::uint64_t startNs, std::uint64_t endNs);
+
+	void write(const std::wstring& path) const;
+
+private:
+	/// <summary>
+	/// The events of one thread; only that thread appends to it.
+	/// </summary>
+	struct ThreadBuffer
+	{
+		DWORD					threadId;
+		std::vector<TraceEvent>	events;
+	};
+
+	[[nodiscard]] ThreadBuffer& threadBuffer();
+
+	/// <summary>
+	/// Distinguishes recorders in the per-thread buffer cache, so a thread never appends to the buffer of a destroyed recorder.
+	/// </summary>
+	std::uint64_t								id_;
+
+	/// <summary>
+	/// The thread that created the recorder; its buffer is labeled as the main thread in the trace.
+	/// </summary>
+	DWORD										mainThreadId_;
+
+	/// <summary>
+	/// Queries that take at least this long are recorded as events of their own.
+	/// </summary>
+	std::uint64_t								slowQueryNs_;
+
+	/// <summary>
+	/// The time base of the events.
+	/// </summary>
+	std::chrono::steady_clock::time_point		origin_;
+
+	/// <summary>
+	/// Guards buffers_ while a thread registers its buffer.
+	/// </summary>
+	std::mutex									mutex_;
+
+	/// <summary>
+	/// One buffer per thread that recorded, in registration order. Buffers are heap-allocated so they stay put when the vector grows.
+	/// </summary>
+	std::vector<std::unique_ptr<ThreadBuffer>>	buffers_;
+};
+
+/// <summary>
+/// Records a complete event for the lifetime of the scope. Does nothing if the recorder is null.
+/// </summary>
+class TraceScope
+{
+public:
+	TraceScope(TraceRecorder* recorder, const char* name, const char* category) noexcept
+		: recorder_(recorder), name_(name), category_(category), startNs_(recorder != nullptr ? recorder->now() : 0)
+	{ }
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+	~TraceScope()
+	{
+		if (recorder_ != nullptr)
+		{
+			recorder_->record(name_, category_, startNs_, recorder_->now());
+		}
+	}
+
+private:
+	TraceRecorder*	recorder_;
+	const char*		name_;
+	const char*		category_;
+	std::uint64_t	startNs_;
+};
\ No newline at end of file
@@ -1,10 +1,35 @@
+#include <iostream>
+#include <stdexcept>
+
 #include "ProcessMemorySniffer.hpp"
+#include "CommandLine.hpp"
 
 /// <summary>
-/// Windows wide-character program entry point that invokes runSniffer with an argument of 10.
+/// Windows wide-character program entry point that parses the command line and invokes runSniffer with the resulting options.
 /// </summary>
-/// <returns>The integer result returned by runSniffer(10), typically used as the program's exit code.</returns>
-int wmain()
+/// <param name="argc">The argument count.</param>
+/// <param name="argv">The wide-character argument vector.</param>
+/// <returns>The integer result returned by runSniffer, or EXIT_FAILURE if the command line is invalid.</returns>
+int wmain(int argc, wchar_t* argv[])
 {
-	return runSniffer(10);
+	SnifferOptions options;
+
+	try
+	{
+		options = parseCommandLine(argc, argv);
+	}
+	catch (const std::invalid_argument& ex)
+	{
+		std::cerr << "Error: " << ex.what() << "\n\n";
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (options.showHelp)
+	{
+		printUsage();
+		return EXIT_SUCCESS;
+	}
+
+	return runSniffer(options);
 }
\ No newline at end of file
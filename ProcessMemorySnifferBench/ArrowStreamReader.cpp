@@ -0,0 +1,376 @@
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "ArrowStreamReader.hpp"
+
+/// <summary>
+/// Marks the start of every encapsulated message.
+/// </summary>
+constexpr std::uint32_t CONTINUATION = 0xFFFFFFFF;
+
+/// <summary>
+/// Reads a little-endian scalar at a position of a buffer. Throws std::runtime_error if it does not fit.
+/// </summary>
+/// <param name="bytes">The buffer.</param>
+/// <param name="position">The position of the scalar.</param>
+/// <returns>The value.</returns>
+template <typename T>
+static T readScalar(std::span<const std::uint8_t> bytes, std::size_t position)
+{
+	if (position > bytes.size() || bytes.size() - position < sizeof(T))
+	{
+		throw std::runtime_error("Arrow stream: read past the end of a buffer.");
+	}
+
+	T value;
+	std::memcpy(&value, bytes.data() + position, sizeof(T));
+	return value;
+}
+
+/// <summary>
+/// Read-only view of one FlatBuffers table: resolves fields through the table's vtable. Absent fields read as their default.
+/// </summary>
+class FlatTable
+{
+public:
+	/// <summary>
+	/// Constructs a view of the table at a position.
+	/// </summary>
+	/// <param name="bytes">The FlatBuffer.</param>
+	/// <param name="position">The position of the table.</param>
+	FlatTable(std::span<const std::uint8_t> bytes, std::size_t position)
+		: bytes_(bytes), position_(position)
+	{
+		const auto vtable = static_cast<std::int64_t>(position) - readScalar<std::int32_t>(bytes, position);
+
+		if (vtable < 0)
+		{
+			throw std::runtime_error("Arrow stream: vtable outside the metadata.");
+		}
+
+		vtable_ = static_cast<std::size_t>(vtable);
+		vtableSize_ = readScalar<std::uint16_t>(bytes, vtable_);
+	}
+
+	/// <summary>
+	/// Returns the root table of a FlatBuffer.
+	/// </summary>
+	/// <param name="bytes">The FlatBuffer.</param>
+	/// <returns>The root table.</returns>
+	static FlatTable root(std::span<const std::uint8_t> bytes)
+	{
+		return FlatTable(bytes, readScalar<std::uint32_t>(bytes, 0));
+	}
+
+	/// <summary>
+	/// Returns whether a field is present.
+	/// </summary>
+	/// <param name="id">The field id.</param>
+	/// <returns>true if the table stores the field.</returns>
+	[[nodiscard]] bool has(std::uint16_t id) const
+	{
+		return fieldPosition(id) != 0;
+	}
+
+	/// <summary>
+	/// Reads a scalar field.
+	/// </summary>
+	/// <param name="id">The field id.</param>
+	/// <param name="fallback">The value of an absent field.</param>
+	/// <returns>The value.</returns>
+	template <typename T>
+	[[nodiscard]] T scalar(std::uint16_t id, T fallback) const
+	{
+		const std::size_t position = fieldPosition(id);
+		return position == 0 ? fallback : readScalar<T>(bytes_, position);
+	}
+
+	/// <summary>
+	/// Reads a table field. Throws std::runtime_error if the field is absent.
+	/// </summary>
+	/// <param name="id">The field id.</param>
+	/// <returns>The referenced table.</returns>
+	[[nodiscard]] FlatTable table(std::uint16_t id) const
+	{
+		return FlatTable(bytes_, target(id));
+	}
+
+	/// <summary>
+	/// Reads a string field; an absent field reads as empty.
+	/// </summary>
+	/// <param name="id">The field id.</param>
+	/// <returns>The string.</returns>
+	[[nodiscard]] std::string string(std::uint16_t id) const
+	{
+		if (!has(id))
+		{
+			return {};
+		}
+
+		const std::size_t position = target(id);
+		const std::uint32_t length = readScalar<std::uint32_t>(bytes_, position);
+
+		if (bytes_.size() - position - 4 < length)
+		{
+			throw std::runtime_error("Arrow stream: string past the end of the metadata.");
+		}
+
+		return std::string(reinterpret_cast<const char*>(bytes_.data() + position + 4), length);
+	}
+
+	/// <summary>
+	/// Reads a vector field of tables; an absent field reads as empty.
+	/// </summary>
+	/// <param name="id">The field id.</param>
+	/// <returns>The tables.</returns>
+	[[nodiscard]] std::vector<FlatTable> tables(std::uint16_t id) const
+	{
+		std::vector<FlatTable> result;
+
+		if (!has(id))
+		{
+			return result;
+		}
+
+		const std::size_t position = target(id);
+		const std::uint32_t count = readScalar<std::uint32_t>(bytes_, position);
+
+		for (std::uint32_t i = 0; i < count; i++)
+		{
+			const std::size_t element = position + 4 + std::size_t{ i } * 4;
+			result.emplace_back(bytes_, element + readScalar<std::uint32_t>(bytes_, element));
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Reads a vector field of structs made of two int64 members (FieldNode and Buffer); an absent field reads as empty.
+	/// </summary>
+	/// <param name="id">The field id.</param>
+	/// <returns>The (first, second) member pairs.</returns>
+	[[nodiscard]] std::vector<std::pair<std::int64_t, std::int64_t>> int64Pairs(std::uint16_t id) const
+	{
+		std::vector<std::pair<std::int64_t, std::int64_t>> result;
+
+		if (!has(id))
+		{
+			return result;
+		}
+
+		const std::size_t position = target(id);
+		const std::uint32_t count = readScalar<std::uint32_t>(bytes_, position);
+
+		for (std::uint32_t i = 0; i < count; i++)
+		{
+			const std::size_t element = position + 4 + std::size_t{ i } * 16;
+			result.emplace_back(readScalar<std::int64_t>(bytes_, element), readScalar<std::int64_t>(bytes_, element + 8));
+		}
+
+		return result;
+	}
+
+private:
+	/// <summary>
+	/// Returns the position of a field, or 0 if the table does not store it.
+	/// </summary>
+	[[nodiscard]] std::size_t fieldPosition(std::uint16_t id) const
+	{
+		const std::size_t slot = 4 + std::size_t{ id } * 2;
+
+		if (slot >= vtableSize_)
+		{
+			return 0;
+		}
+
+		const std::uint16_t offset = readScalar<std::uint16_t>(bytes_, vtable_ + slot);
+		return offset == 0 ? 0 : position_ + offset;
+	}
+
+	/// <summary>
+	/// Follows the unsigned offset stored in a field. Throws std::runtime_error if the field is absent.
+	/// </summary>
+	[[nodiscard]] std::size_t target(std::uint16_t id) const
+	{
+		const std::size_t position = fieldPosition(id);
+
+		if (position == 0)
+		{
+			throw std::runtime_error("Arrow stream: required field " + std::to_string(id) + " is missing.");
+		}
+
+		return position + readScalar<std::uint32_t>(bytes_, position);
+	}
+
+	/// <summary>
+	/// The FlatBuffer and the position of the table within it.
+	/// </summary>
+	std::span<const std::uint8_t>	bytes_;
+	std::size_t						position_;
+
+	/// <summary>
+	/// The position and size in bytes of the table's vtable.
+	/// </summary>
+	std::size_t						vtable_{ 0 };
+	std::uint16_t					vtableSize_{ 0 };
+};
+
+/// <summary>
+/// Decodes a RecordBatch table into a message.
+/// </summary>
+/// <param name="batch">The RecordBatch table.</param>
+/// <param name="message">Receives the length, nodes and buffers.</param>
+static void readRecordBatch(const FlatTable& batch, ArrowMessage& message)
+{
+	message.length = batch.scalar<std::int64_t>(0, 0);
+
+	for (const auto& [length, nullCount] : batch.int64Pairs(1))
+	{
+		message.nodes.push_back({ length, nullCount });
+	}
+
+	for (const auto& [offset, length] : batch.int64Pairs(2))
+	{
+		message.buffers.push_back({ offset, length });
+	}
+}
+
+/// <summary>
+/// Decodes a Field table.
+/// </summary>
+/// <param name="table">The Field table.</param>
+/// <returns>The field.</returns>
+static ArrowField readField(const FlatTable& table)
+{
+	constexpr std::uint8_t TYPE_INT = 2;
+	constexpr std::uint8_t TYPE_TIMESTAMP = 10;
+
+	ArrowField field;
+	field.name = table.string(0);
+	field.nullable = table.scalar<std::uint8_t>(1, 0) != 0;
+	field.typeType = table.scalar<std::uint8_t>(2, 0);
+
+	if (field.typeType == TYPE_INT)
+	{
+		const FlatTable type = table.table(3);
+		field.bitWidth = type.scalar<std::int32_t>(0, 0);
+		field.isSigned = type.scalar<std::uint8_t>(1, 0) != 0;
+	}
+	else if (field.typeType == TYPE_TIMESTAMP)
+	{
+		const FlatTable type = table.table(3);
+		field.timeUnit = type.scalar<std::int16_t>(0, 0);
+		field.timezone = type.string(1);
+	}
+
+	if (table.has(4))
+	{
+		const FlatTable encoding = table.table(4);
+		field.dictionaryId = encoding.scalar<std::int64_t>(0, 0);
+		field.indexBitWidth = encoding.has(1) ? encoding.table(1).scalar<std::int32_t>(0, 0) : 32;
+	}
+
+	return field;
+}
+
+/// <summary>
+/// Returns one body buffer of a message. Throws std::runtime_error if the buffer does not exist or lies outside the body.
+/// </summary>
+/// <param name="index">The buffer index, in the order of the message's buffer list.</param>
+/// <returns>The buffer bytes.</returns>
+std::span<const std::uint8_t> ArrowMessage::buffer(std::size_t index) const
+{
+	if (index >= buffers.size())
+	{
+		throw std::runtime_error("Arrow stream: buffer " + std::to_string(index) + " does not exist.");
+	}
+
+	const ArrowBuffer& spec = buffers[index];
+
+	if (spec.offset < 0 || spec.length < 0 || static_cast<std::uint64_t>(spec.offset) + static_cast<std::uint64_t>(spec.length) > body.size())
+	{
+		throw std::runtime_error("Arrow stream: buffer " + std::to_string(index) + " lies outside the message body.");
+	}
+
+	return body.subspan(static_cast<std::size_t>(spec.offset), static_cast<std::size_t>(spec.length));
+}
+
+/// <summary>
+/// Constructs a reader.
+/// </summary>
+/// <param name="stream">The complete stream. Must outlive the reader and the messages it returns.</param>
+ArrowStreamReader::ArrowStreamReader(std::span<const std::uint8_t> stream) noexcept : stream_(stream)
+{ }
+
+/// <summary>
+/// Reads the next message. Throws std::runtime_error on malformed input, including a stream that ends without the end-of-stream marker.
+/// </summary>
+/// <param name="message">Receives the message; reset first.</param>
+/// <returns>true if a message was read; false at the end-of-stream marker.</returns>
+bool ArrowStreamReader::next(ArrowMessage& message)
+{
+	message = ArrowMessage();
+
+	if (readScalar<std::uint32_t>(stream_, position_) != CONTINUATION)
+	{
+		throw std::runtime_error("Arrow stream: missing continuation marker at byte " + std::to_string(position_) + ".");
+	}
+
+	const std::uint32_t metadataSize = readScalar<std::uint32_t>(stream_, position_ + 4);
+	position_ += 8;
+
+	if (metadataSize == 0)
+	{
+		return false;
+	}
+
+	if (stream_.size() - position_ < metadataSize)
+	{
+		throw std::runtime_error("Arrow stream: message metadata past the end of the stream.");
+	}
+
+	const auto metadata = stream_.subspan(position_, metadataSize);
+	position_ += metadataSize;
+
+	const FlatTable root = FlatTable::root(metadata);
+	message.version = root.scalar<std::int16_t>(0, 0);
+	message.type = static_cast<ArrowMessageType>(root.scalar<std::uint8_t>(1, 0));
+	const auto bodyLength = root.scalar<std::int64_t>(3, 0);
+
+	if (bodyLength < 0 || static_cast<std::uint64_t>(bodyLength) > stream_.size() - position_)
+	{
+		throw std::runtime_error("Arrow stream: message body past the end of the stream.");
+	}
+
+	message.bodyPosition = position_;
+	message.body = stream_.subspan(position_, static_cast<std::size_t>(bodyLength));
+	position_ += static_cast<std::size_t>(bodyLength);
+
+	const FlatTable header = root.table(2);
+
+	switch (message.type)
+	{
+	case ArrowMessageType::Schema:
+		for (const auto& field : header.tables(1))
+		{
+			message.fields.push_back(readField(field));
+		}
+		break;
+
+	case ArrowMessageType::DictionaryBatch:
+		message.dictionaryId = header.scalar<std::int64_t>(0, 0);
+		message.isDelta = header.scalar<std::uint8_t>(2, 0) != 0;
+		readRecordBatch(header.table(1), message);
+		break;
+
+	case ArrowMessageType::RecordBatch:
+		readRecordBatch(header, message);
+		break;
+
+	default:
+		throw std::runtime_error("Arrow stream: unexpected message header type " + std::to_string(static_cast<int>(message.type)) + ".");
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// One column of an Arrow Schema message. Only the parts of the type ArrowStreamWriter uses are decoded.
+/// </summary>
+struct ArrowField
+{
+	/// <summary>
+	/// The column name and whether it may contain nulls.
+	/// </summary>
+	std::string		name;
+	bool			nullable{ false };
+
+	/// <summary>
+	/// The Type union code, and for Int types their width and signedness.
+	/// </summary>
+	std::uint8_t	typeType{ 0 };
+	std::int32_t	bitWidth{ 0 };
+	bool			isSigned{ false };
+
+	/// <summary>
+	/// For Timestamp types, the time unit and time zone.
+	/// </summary>
+	std::int16_t	timeUnit{ 0 };
+	std::string		timezone;
+
+	/// <summary>
+	/// For dictionary-encoded columns, the dictionary id and the width of the indices; -1 and 0 for plain columns.
+	/// </summary>
+	std::int64_t	dictionaryId{ -1 };
+	std::int32_t	indexBitWidth{ 0 };
+};
+
+/// <summary>
+/// Length and null count of one column within a record batch.
+/// </summary>
+struct ArrowFieldNode
+{
+	std::int64_t	length{ 0 };
+	std::int64_t	nullCount{ 0 };
+};
+
+/// <summary>
+/// Location of one buffer within a message body.
+/// </summary>
+struct ArrowBuffer
+{
+	std::int64_t	offset{ 0 };
+	std::int64_t	length{ 0 };
+};
+
+/// <summary>
+/// The message types of an Arrow IPC stream, with their MessageHeader union codes.
+/// </summary>
+enum class ArrowMessageType : std::uint8_t
+{
+	Schema = 1,
+	DictionaryBatch = 2,
+	RecordBatch = 3
+};
+
+/// <summary>
+/// One decoded encapsulated message. The body refers into the stream the reader was constructed with.
+/// </summary>
+struct ArrowMessage
+{
+	/// <summary>
+	/// The message type and the metadata version it was written with.
+	/// </summary>
+	ArrowMessageType				type{ ArrowMessageType::Schema };
+	std::int16_t					version{ 0 };
+
+	/// <summary>
+	/// The columns, for Schema messages.
+	/// </summary>
+	std::vector<ArrowField>			fields;
+
+	/// <summary>
+	/// The dictionary id and whether the batch extends the dictionary, for DictionaryBatch messages.
+	/// </summary>
+	std::int64_t					dictionaryId{ -1 };
+	bool							isDelta{ false };
+
+	/// <summary>
+	/// The row count, column nodes and body buffers of a RecordBatch message or of the data of a DictionaryBatch message.
+	/// </summary>
+	std::int64_t					length{ 0 };
+	std::vector<ArrowFieldNode>		nodes;
+	std::vector<ArrowBuffer>		buffers;
+
+	/// <summary>
+	/// The position of the body in the stream, and the body itself.
+	/// </summary>
+	std::size_t						bodyPosition{ 0 };
+	std::span<const std::uint8_t>	body;
+
+	[[nodiscard]] std::span<const std::uint8_t> buffer(std::size_t index) const;
+};
+
+/// <summary>
+/// Minimal reader of the Arrow IPC streaming format, covering what ArrowStreamWriter writes: Schema, DictionaryBatch and
+/// RecordBatch messages with continuation markers, and the end-of-stream marker. It exists so the self-checks can decode the
+/// writer's output without the Arrow library; every read is bounds checked and malformed input throws std::runtime_error.
+/// </summary>
+class ArrowStreamReader
+{
+public:
+	explicit ArrowStreamReader(std::span<const std::uint8_t> stream) noexcept;
+
+	bool next(ArrowMessage& message);
+
+	/// <summary>
+	/// Returns the number of stream bytes after the end-of-stream marker, or not yet read.
+	/// </summary>
+	/// <returns>The number of unread bytes.</returns>
+	[[nodiscard]] std::size_t remaining() const noexcept
+	{
+		return stream_.size() - position_;
+	}
+
+private:
+	/// <summary>
+	/// The stream.
+	/// </summary>
+	std::span<const std::uint8_t>	stream_;
+
+	/// <summary>
+	/// The position of the next message.
+	/// </summary>
+	std::size_t						position_{ 0 };
+};
\ No newline at end of file
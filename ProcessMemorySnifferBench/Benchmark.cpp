@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <utility>
+
+#include "Benchmark.hpp"
+
+/// <summary>
+/// Times one batch of a benchmark.
+/// </summary>
+/// <param name="body">The benchmark body.</param>
+/// <param name="iterations">The number of iterations in the batch.</param>
+/// <returns>The elapsed time in nanoseconds.</returns>
+static double timeBatch(const BenchmarkBody& body, std::uint64_t iterations)
+{
+	const auto start = std::chrono::steady_clock::now();
+	body(iterations);
+	const auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+/// <summary>
+/// Returns the median of a list of samples.
+/// </summary>
+/// <param name="samples">The samples.</param>
+/// <returns>The median, or 0 if there are no samples.</returns>
+double medianOf(std::vector<double> samples)
+{
+	if (samples.empty())
+	{
+		return 0.0;
+	}
+
+	const std::size_t middle = samples.size() / 2;
+	std::nth_element(samples.begin(), samples.begin() + middle, samples.end());
+
+	if (samples.size() % 2 != 0)
+	{
+		return samples[middle];
+	}
+
+	return (samples[middle] + *std::max_element(samples.begin(), samples.begin() + middle)) / 2.0;
+}
+
+/// <summary>
+/// Writes a string as a JSON string literal. Benchmark names are ASCII, so only quotes, backslashes and control characters need escaping.
+/// </summary>
+/// <param name="out">The stream to write to.</param>
+/// <param name="text">The string.</param>
+static void writeJsonString(std::ostream& out, std::string_view text)
+{
+	out << '"';
+
+	for (const char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out << '\\' << c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+		}
+		else
+		{
+			out << c;
+		}
+	}
+
+	out << '"';
+}
+
+/// <summary>
+/// Writes a counter value, or null if the counter could not be read.
+/// </summary>
+/// <param name="out">The stream to write to.</param>
+/// <param name="available">Whether the counter was read.</param>
+/// <param name="value">The value.</param>
+static void writeCounter(std::ostream& out, bool available, double value)
+{
+	if (available)
+	{
+		out << value;
+	}
+	else
+	{
+		out << "null";
+	}
+}
+
+/// <summary>
+/// Constructs a runner.
+/// </summary>
+/// <param name="minTime">The minimum total time spent in the timed batches of each benchmark.</param>
+/// <param name="repetitions">The number of timed batches per benchmark, at least 1.</param>
+BenchmarkRunner::BenchmarkRunner(std::chrono::milliseconds minTime, std::size_t repetitions) noexcept
+	: minTime_(minTime), repetitions_(std::max<std::size_t>(repetitions, 1))
+{ }
+
+/// <summary>
+/// Registers a benchmark.
+/// </summary>
+/// <param name="name">The benchmark name, "group/name".</param>
+/// <param name="itemsPerIteration">The number of items one iteration handles, at least 1.</param>
+/// <param name="body">The benchmark body.</param>
+void BenchmarkRunner::add(std::string name, std::size_t itemsPerIteration, BenchmarkBody body)
+{
+	entries_.push_back({ std::move(name), std::max<std::size_t>(itemsPerIteration, 1), std::move(body) });
+}
+
+/// <summary>
+/// Runs the benchmarks whose name contains a filter string, in registration order.
+/// </summary>
+/// <param name="filter">The filter; empty runs every benchmark.</param>
+/// <returns>One result per benchmark run.</returns>
+std::vector<BenchmarkResult> BenchmarkRunner::run(std::string_view filter) const
+{
+	std::vector<BenchmarkResult> results;
+
+	for (const auto& entry : entries_)
+	{
+		if (entry.name.find(filter) != std::string::npos)
+		{
+			results.push_back(measure(entry));
+		}
+	}
+
+	return results;
+}
+
+/// <summary>
+/// Calibrates and times one benchmark.
+/// </summary>
+/// <param name="entry">The benchmark.</param>
+/// <returns>Its result.</returns>
+BenchmarkResult BenchmarkRunner::measure(const Entry& entry) const
+{
+	const double batchNs = std::chrono::duration<double, std::nano>(minTime_).count() / static_cast<double>(repetitions_);
+
+	// Calibration also warms caches and lets lazily built state settle before the timed batches.
+	std::uint64_t iterations = 1;
+
+	while (timeBatch(entry.body, iterations) < batchNs && iterations < (std::uint64_t{ 1 } << 40))
+	{
+		iterations *= 2;
+	}
+
+	BenchmarkResult result;
+	result.name = entry.name;
+	result.itemsPerIteration = entry.itemsPerIteration;
+	result.iterationsPerSample = iterations;
+
+	// The counters are read once around all timed batches; GetProcessTimes is too coarse to resolve a single batch.
+	CounterSample before;
+	const CounterAvailability available = readProcessCounters(before);
+
+	for (std::size_t i = 0; i < repetitions_; i++)
+	{
+		result.samplesNs.push_back(timeBatch(entry.body, iterations) / static_cast<double>(iterations));
+	}
+
+	CounterSample after;
+	const CounterAvailability stillAvailable = readProcessCounters(after);
+	const double totalIterations = static_cast<double>(iterations) * static_cast<double>(repetitions_);
+
+	result.counterAvailability.cycles = available.cycles && stillAvailable.cycles;
+	result.counterAvailability.times = available.times && stillAvailable.times;
+	result.counterAvailability.pageFaults = available.pageFaults && stillAvailable.pageFaults;
+	result.cyclesPerIteration = static_cast<double>(after.cycles - before.cycles) / totalIterations;
+	result.userNsPerIteration = static_cast<double>(after.userNs - before.userNs) / totalIterations;
+	result.kernelNsPerIteration = static_cast<double>(after.kernelNs - before.kernelNs) / totalIterations;
+	result.pageFaultsPerIteration = static_cast<double>(static_cast<std::uint32_t>(after.pageFaults - before.pageFaults)) / totalIterations;
+
+	// Allocations and system calls come from one extra, untimed batch, so the timed samples never include reading them.
+	if constexpr (RESOURCE_COUNTERS_ENABLED)
+	{
+		const ResourceCounts resourcesBefore = readResourceCounts();
+		timeBatch(entry.body, iterations);
+		const ResourceCounts resources = readResourceCounts() - resourcesBefore;
+		const double countedIterations = static_cast<double>(iterations);
+
+		result.hasResourceCounts = true;
+		result.allocationsPerIteration = static_cast<double>(resources.allocations) / countedIterations;
+		result.allocatedBytesPerIteration = static_cast<double>(resources.allocatedBytes) / countedIterations;
+		result.freesPerIteration = static_cast<double>(resources.frees) / countedIterations;
+		result.systemCallsPerIteration = static_cast<double>(resources.systemCalls) / countedIterations;
+	}
+
+	result.medianNs = medianOf(result.samplesNs);
+	result.minNs = *std::min_element(result.samplesNs.begin(), result.samplesNs.end());
+	result.meanNs = std::accumulate(result.samplesNs.begin(), result.samplesNs.end(), 0.0) / static_cast<double>(result.samplesNs.size());
+
+	return result;
+}
+
+/// <summary>
+/// Writes benchmark results as a JSON document:
+/// {"schema": "...", "build": "...", "benchmarks": [{"name", "items_per_iteration", "iterations_per_sample",
+/// "median_ns", "min_ns", "mean_ns", "items_per_second", "counters": {"cycles", "user_ns", "kernel_ns", "page_faults",
+/// "allocations", "allocated_bytes", "frees", "system_calls"},
+/// "samples_ns": [...]}]}. Times and counters are per iteration; unreadable counters are null; items_per_second is derived from the median.
+/// </summary>
+/// <param name="out">The stream to write to.</param>
+/// <param name="results">The results.</param>
+void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+#ifdef _DEBUG
+	constexpr const char* BUILD = "debug";
+#else
+	constexpr const char* BUILD = "release";
+#endif
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\n  \"schema\": \"process-memory-sniffer-bench/1\",\n  \"build\": \"" << BUILD
+		<< "\",\n  \"pointer_bits\": " << sizeof(void*) * 8 << ",\n  \"benchmarks\": [";
+
+	for (std::size_t i = 0; i < results.size(); i++)
+	{
+		const auto& result = results[i];
+		const double itemsPerSecond = result.medianNs > 0.0
+			? static_cast<double>(result.itemsPerIteration) * 1e9 / result.medianNs
+			: 0.0;
+
+		out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+		writeJsonString(out, result.name);
+		out << ", \"items_per_iteration\": " << result.itemsPerIteration
+			<< ", \"iterations_per_sample\": " << result.iterationsPerSample
+			<< ", \"median_ns\": " << result.medianNs
+			<< ", \"min_ns\": " << result.minNs
+			<< ", \"mean_ns\": " << result.meanNs
+			<< ", \"items_per_second\": " << itemsPerSecond
+			<< ", \"counters\": {\"cycles\": ";
+		writeCounter(out, result.counterAvailability.cycles, result.cyclesPerIteration);
+		out << ", \"user_ns\": ";
+		writeCounter(out, result.counterAvailability.times, result.userNsPerIteration);
+		out << ", \"kernel_ns\": ";
+		writeCounter(out, result.counterAvailability.times, result.kernelNsPerIteration);
+		out << ", \"page_faults\": ";
+		writeCounter(out, result.counterAvailability.pageFaults, result.pageFaultsPerIteration);
+		out << ", \"allocations\": ";
+		writeCounter(out, result.hasResourceCounts, result.allocationsPerIteration);
+		out << ", \"allocated_bytes\": ";
+		writeCounter(out, result.hasResourceCounts, result.allocatedBytesPerIteration);
+		out << ", \"frees\": ";
+		writeCounter(out, result.hasResourceCounts, result.freesPerIteration);
+		out << ", \"system_calls\": ";
+		writeCounter(out, result.hasResourceCounts, result.systemCallsPerIteration);
+		out << "}, \"samples_ns\": [";
+
+		for (std::size_t s = 0; s < result.samplesNs.size(); s++)
+		{
+			out << (s == 0 ? "" : ", ") << result.samplesNs[s];
+		}
+
+		out << "]}";
+	}
+
+	out << "\n  ]\n}\n";
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "PhaseProfiler.hpp"
+#include "ResourceCounters.hpp"
+
+/// <summary>
+/// Volatile target of doNotOptimize().
+/// </summary>
+inline const void* volatile benchmarkSink = nullptr;
+
+/// <summary>
+/// Keeps the compiler from discarding a value computed only for timing.
+/// </summary>
+/// <param name="value">The value to keep.</param>
+template <typename T>
+inline void doNotOptimize(const T& value) noexcept
+{
+	benchmarkSink = &value;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+/// <summary>
+/// Body of a benchmark: performs the measured operation the given number of times. Setup that should not be timed
+/// is done when the benchmark is registered and captured by the body.
+/// </summary>
+using BenchmarkBody = std::function<void(std::uint64_t iterations)>;
+
+/// <summary>
+/// Timing of one benchmark.
+/// </summary>
+struct BenchmarkResult
+{
+	/// <summary>
+	/// The benchmark name, "group/name".
+	/// </summary>
+	std::string			name;
+
+	/// <summary>
+	/// The number of items (processes, rows, strings...) one iteration handles; throughput is reported per item.
+	/// </summary>
+	std::size_t			itemsPerIteration{ 1 };
+
+	/// <summary>
+	/// The number of iterations per sample.
+	/// </summary>
+	std::uint64_t		iterationsPerSample{ 0 };
+
+	/// <summary>
+	/// The time per iteration of each sample, in nanoseconds.
+	/// </summary>
+	std::vector<double>	samplesNs;
+
+	/// <summary>
+	/// The median, minimum and mean of samplesNs.
+	/// </summary>
+	double				medianNs{ 0.0 };
+	double				minNs{ 0.0 };
+	double				meanNs{ 0.0 };
+
+	/// <summary>
+	/// Process counters per iteration over all timed batches: CPU cycles, user and kernel CPU time in nanoseconds and page faults.
+	/// Counters that could not be read are flagged in counterAvailability and written as null.
+	/// </summary>
+	double				cyclesPerIteration{ 0.0 };
+	double				userNsPerIteration{ 0.0 };
+	double				kernelNsPerIteration{ 0.0 };
+	double				pageFaultsPerIteration{ 0.0 };
+	CounterAvailability	counterAvailability;
+
+	/// <summary>
+	/// Allocations, allocated bytes, frees and system calls per iteration, measured in a separate untimed batch; only valid if
+	/// hasResourceCounts, i.e. the build counts them (SNIFFER_RESOURCE_COUNTERS, defined for Debug builds only so that Release
+	/// timings run on the real allocator); otherwise written as null.
+	/// </summary>
+	bool				hasResourceCounts{ false };
+	double				allocationsPerIteration{ 0.0 };
+	double				allocatedBytesPerIteration{ 0.0 };
+	double				freesPerIteration{ 0.0 };
+	double				systemCallsPerIteration{ 0.0 };
+};
+
+/// <summary>
+/// Runs registered benchmarks. Each benchmark is first calibrated by doubling its iteration count until one batch takes
+/// at least minTime / repetitions, then timed for repetitions batches of that size; each batch yields one per-iteration sample.
+/// </summary>
+class BenchmarkRunner
+{
+public:
+	BenchmarkRunner(std::chrono::milliseconds minTime, std::size_t repetitions) noexcept;
+
+	void add(std::string name, std::size_t itemsPerIteration, BenchmarkBody body);
+
+	[[nodiscard]] std::vector<BenchmarkResult> run(std::string_view filter) const;
+
+private:
+	/// <summary>
+	/// A registered benchmark.
+	/// </summary>
+	struct Entry
+	{
+		std::string		name;
+		std::size_t		itemsPerIteration;
+		BenchmarkBody	body;
+	};
+
+	[[nodiscard]] BenchmarkResult measure(const Entry& entry) const;
+
+	/// <summary>
+	/// The minimum total time spent in the timed batches of one benchmark.
+	/// </summary>
+	std::chrono::milliseconds	minTime_;
+
+	/// <summary>
+	/// The number of timed batches (samples) per benchmark.
+	/// </summary>
+	std::size_t					repetitions_;
+
+	/// <summary>
+	/// The registered benchmarks, in registration order.
+	/// </summary>
+	std::vector<Entry>			entries_;
+};
+
+[[nodiscard]] double medianOf(std::vector<double> samples);
+
+void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results);
\ No newline at end of file
@@ -0,0 +1,373 @@
+#define NOMINMAX
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "BenchmarkComparison.hpp"
+#include "JsonReader.hpp"
+#include "TextEncoding.hpp"
+
+/// <summary>
+/// The number of bootstrap resamples per comparison.
+/// </summary>
+constexpr std::size_t BOOTSTRAP_RESAMPLES = 2000;
+
+/// <summary>
+/// Fixed bootstrap seed, so comparing the same two files always gives the same interval.
+/// </summary>
+constexpr std::uint32_t BOOTSTRAP_SEED = 0x5EED;
+
+/// <summary>
+/// Returns a required member of a result object or throws.
+/// </summary>
+/// <param name="object">The object.</param>
+/// <param name="key">The member name.</param>
+/// <param name="kind">The required kind.</param>
+/// <returns>The member.</returns>
+static const JsonValue& requireMember(const JsonValue& object, const char* key, JsonValue::Kind kind)
+{
+	const JsonValue* value = object.find(key);
+
+	if (value == nullptr || value->kind != kind)
+	{
+		throw std::runtime_error(std::string("Benchmark result is missing '") + key + "'.");
+	}
+
+	return *value;
+}
+
+/// <summary>
+/// Two-sided p-value of the Mann-Whitney U test, using the normal approximation with tie and continuity corrections.
+/// The test only assumes that samples are independent, not that timings are normally distributed, which they rarely are.
+/// </summary>
+/// <param name="a">The first sample set.</param>
+/// <param name="b">The second sample set.</param>
+/// <returns>The p-value; 1 if either set is empty or all samples are equal.</returns>
+static double mannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b)
+{
+	const double n1 = static_cast<double>(a.size());
+	const double n2 = static_cast<double>(b.size());
+
+	if (a.empty() || b.empty())
+	{
+		return 1.0;
+	}
+
+	std::vector<std::pair<double, bool>> all;
+	all.reserve(a.size() + b.size());
+
+	for (const double x : a)
+	{
+		all.emplace_back(x, true);
+	}
+
+	for (const double x : b)
+	{
+		all.emplace_back(x, false);
+	}
+
+	std::sort(all.begin(), all.end());
+
+	// Average ranks over runs of ties; accumulate the rank sum of a and the tie correction term.
+	double rankSumA = 0.0;
+	double tieTerm = 0.0;
+
+	for (std::size_t i = 0; i < all.size();)
+	{
+		std::size_t j = i;
+
+		while (j < all.size() && all[j].first == all[i].first)
+		{
+			j++;
+		}
+
+		const double rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+		const double ties = static_cast<double>(j - i);
+		tieTerm += ties * ties * ties - ties;
+
+		for (std::size_t k = i; k < j; k++)
+		{
+			if (all[k].second)
+			{
+				rankSumA += rank;
+			}
+		}
+
+		i = j;
+	}
+
+	const double n = n1 + n2;
+	const double u = rankSumA - n1 * (n1 + 1.0) / 2.0;
+	const double mean = n1 * n2 / 2.0;
+	const double variance = n1 * n2 / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+
+	if (variance <= 0.0)
+	{
+		return 1.0;
+	}
+
+	const double z = std::max(std::abs(u - mean) - 0.5, 0.0) / std::sqrt(variance);
+	return std::erfc(z / std::sqrt(2.0));
+}
+
+/// <summary>
+/// Percentile bootstrap confidence interval of the ratio of the medians of two sample sets.
+/// </summary>
+/// <param name="baseline">The baseline samples.</param>
+/// <param name="current">The current samples.</param>
+/// <param name="low">Receives the lower bound.</param>
+/// <param name="high">Receives the upper bound.</param>
+static void bootstrapRatio(const std::vector<double>& baseline, const std::vector<double>& current, double& low, double& high)
+{
+	std::mt19937 random(BOOTSTRAP_SEED);
+	std::uniform_int_distribution<std::size_t> pickBaseline(0, baseline.size() - 1);
+	std::uniform_int_distribution<std::size_t> pickCurrent(0, current.size() - 1);
+
+	std::vector<double> ratios;
+	std::vector<double> a(baseline.size());
+	std::vector<double> b(current.size());
+	ratios.reserve(BOOTSTRAP_RESAMPLES);
+
+	for (std::size_t r = 0; r < BOOTSTRAP_RESAMPLES; r++)
+	{
+		for (auto& x : a)
+		{
+			x = baseline[pickBaseline(random)];
+		}
+
+		for (auto& x : b)
+		{
+			x = current[pickCurrent(random)];
+		}
+
+		const double baselineMedian = medianOf(a);
+
+		if (baselineMedian > 0.0)
+		{
+			ratios.push_back(medianOf(b) / baselineMedian);
+		}
+	}
+
+	if (ratios.empty())
+	{
+		low = high = 1.0;
+		return;
+	}
+
+	std::sort(ratios.begin(), ratios.end());
+	const auto at = [&](double q)
+		{
+			return ratios[static_cast<std::size_t>(q * static_cast<double>(ratios.size() - 1) + 0.5)];
+		};
+
+	low = at(COMPARISON_ALPHA / 2.0);
+	high = at(1.0 - COMPARISON_ALPHA / 2.0);
+}
+
+/// <summary>
+/// Loads results written by writeJson(), e.g. a stored baseline. Throws std::runtime_error if the file cannot be read or is not a result file.
+/// </summary>
+/// <param name="path">The path of the JSON file.</param>
+/// <returns>The results, with the statistics recomputed from the stored samples.</returns>
+std::vector<BenchmarkResult> loadResults(const std::wstring& path)
+{
+	std::ifstream in(std::filesystem::path(path), std::ios::binary);
+
+	if (!in)
+	{
+		throw std::runtime_error("Failed to open " + toUtf8(path));
+	}
+
+	std::ostringstream text;
+	text << in.rdbuf();
+
+	const JsonValue root = parseJson(text.str());
+	const JsonValue* schema = root.find("schema");
+
+	if (schema == nullptr || schema->string != "process-memory-sniffer-bench/1")
+	{
+		throw std::runtime_error("Not a benchmark result file: " + toUtf8(path));
+	}
+
+	std::vector<BenchmarkResult> results;
+
+	for (const auto& entry : requireMember(root, "benchmarks", JsonValue::Kind::Array).array)
+	{
+		BenchmarkResult result;
+		result.name = requireMember(entry, "name", JsonValue::Kind::String).string;
+		result.itemsPerIteration = static_cast<std::size_t>(requireMember(entry, "items_per_iteration", JsonValue::Kind::Number).number);
+		result.iterationsPerSample = static_cast<std::uint64_t>(requireMember(entry, "iterations_per_sample", JsonValue::Kind::Number).number);
+
+		for (const auto& sample : requireMember(entry, "samples_ns", JsonValue::Kind::Array).array)
+		{
+			result.samplesNs.push_back(sample.number);
+		}
+
+		if (result.samplesNs.empty())
+		{
+			throw std::runtime_error("Benchmark '" + result.name + "' has no samples in " + toUtf8(path));
+		}
+
+		// Counters are optional: older result files and builds without SNIFFER_RESOURCE_COUNTERS do not have them.
+		if (const JsonValue* counters = entry.find("counters"); counters != nullptr && counters->kind == JsonValue::Kind::Object)
+		{
+			const JsonValue* allocations = counters->find("allocations");
+
+			if (allocations != nullptr && allocations->kind == JsonValue::Kind::Number)
+			{
+				result.hasResourceCounts = true;
+				result.allocationsPerIteration = allocations->number;
+			}
+		}
+
+		result.medianNs = medianOf(result.samplesNs);
+		result.minNs = *std::min_element(result.samplesNs.begin(), result.samplesNs.end());
+		result.meanNs = std::accumulate(result.samplesNs.begin(), result.samplesNs.end(), 0.0) / static_cast<double>(result.samplesNs.size());
+		results.push_back(std::move(result));
+	}
+
+	return results;
+}
+
+/// <summary>
+/// Compares current results with a baseline by name. A benchmark regressed when the difference is significant - the
+/// Mann-Whitney p-value is below COMPARISON_ALPHA and the bootstrap interval of the ratio of medians lies entirely above 1 -
+/// and the median slowed down by more than the threshold, or when it allocates more than the threshold plus ALLOCATION_SLACK
+/// per iteration; improvements are the mirror image of the timing rule. Benchmarks present on only one side are reported as New or Missing.
+/// </summary>
+/// <param name="baseline">The baseline results.</param>
+/// <param name="current">The current results.</param>
+/// <param name="threshold">The smallest relative change that counts, e.g. 0.05 for 5%.</param>
+/// <returns>One comparison per benchmark: current order first, then benchmarks missing from the current run.</returns>
+std::vector<BenchmarkComparison> compareResults(const std::vector<BenchmarkResult>& baseline,
+	const std::vector<BenchmarkResult>& current, double threshold)
+{
+	std::unordered_map<std::string, const BenchmarkResult*> byName;
+
+	for (const auto& result : baseline)
+	{
+		byName.emplace(result.name, &result);
+	}
+
+	std::vector<BenchmarkComparison> comparisons;
+
+	for (const auto& result : current)
+	{
+		BenchmarkComparison comparison;
+		comparison.name = result.name;
+		comparison.currentMedianNs = result.medianNs;
+
+		const auto it = byName.find(result.name);
+
+		if (it == byName.end())
+		{
+			comparison.verdict = ComparisonVerdict::New;
+			comparisons.push_back(std::move(comparison));
+			continue;
+		}
+
+		const BenchmarkResult& base = *it->second;
+		byName.erase(it);
+
+		comparison.baselineMedianNs = base.medianNs;
+		comparison.ratio = base.medianNs > 0.0 ? result.medianNs / base.medianNs : 1.0;
+		comparison.pValue = mannWhitneyPValue(base.samplesNs, result.samplesNs);
+		bootstrapRatio(base.samplesNs, result.samplesNs, comparison.ratioLow, comparison.ratioHigh);
+
+		const bool significant = comparison.pValue < COMPARISON_ALPHA;
+
+		comparison.hasAllocations = base.hasResourceCounts && result.hasResourceCounts;
+		comparison.baselineAllocations = base.allocationsPerIteration;
+		comparison.currentAllocations = result.allocationsPerIteration;
+
+		const bool allocationsGrew = comparison.hasAllocations
+			&& comparison.currentAllocations > comparison.baselineAllocations * (1.0 + threshold) + ALLOCATION_SLACK;
+
+		if (allocationsGrew || (significant && comparison.ratioLow > 1.0 && comparison.ratio > 1.0 + threshold))
+		{
+			comparison.verdict = ComparisonVerdict::Regression;
+		}
+		else if (significant && comparison.ratioHigh < 1.0 && comparison.ratio < 1.0 / (1.0 + threshold))
+		{
+			comparison.verdict = ComparisonVerdict::Improvement;
+		}
+
+		comparisons.push_back(std::move(comparison));
+	}
+
+	for (const auto& result : baseline)
+	{
+		if (byName.contains(result.name))
+		{
+			BenchmarkComparison comparison;
+			comparison.name = result.name;
+			comparison.baselineMedianNs = result.medianNs;
+			comparison.verdict = ComparisonVerdict::Missing;
+			comparisons.push_back(std::move(comparison));
+		}
+	}
+
+	return comparisons;
+}
+
+/// <summary>
+/// Prints a comparison table: medians, change with its confidence interval, p-value and verdict.
+/// </summary>
+/// <param name="out">The stream to write to.</param>
+/// <param name="comparisons">The comparisons.</param>
+/// <param name="threshold">The threshold the verdicts were computed with.</param>
+void printComparison(std::ostream& out, const std::vector<BenchmarkComparison>& comparisons, double threshold)
+{
+	constexpr const char* VERDICTS[] = { "", "improved", "REGRESSED", "new", "missing" };
+
+	out << "\nComparison with baseline (threshold " << threshold * 100.0 << "%, alpha " << COMPARISON_ALPHA << "):\n\n";
+	out << std::left
+		<< std::setw(36) << "Benchmark"
+		<< std::setw(16) << "Baseline (ns)"
+		<< std::setw(16) << "Current (ns)"
+		<< std::setw(26) << "Change (95% CI)"
+		<< std::setw(10) << "p"
+		<< std::setw(20) << "Allocs/iteration"
+		<< "Verdict\n";
+
+	out << std::fixed;
+
+	for (const auto& c : comparisons)
+	{
+		out << std::setw(36) << c.name << std::setprecision(1)
+			<< std::setw(16) << c.baselineMedianNs
+			<< std::setw(16) << c.currentMedianNs;
+
+		if (c.verdict == ComparisonVerdict::New || c.verdict == ComparisonVerdict::Missing)
+		{
+			out << std::setw(26) << "-" << std::setw(10) << "-";
+		}
+		else
+		{
+			std::ostringstream change;
+			change << std::fixed << std::setprecision(1) << std::showpos
+				<< (c.ratio - 1.0) * 100.0 << "% [" << (c.ratioLow - 1.0) * 100.0 << ", " << (c.ratioHigh - 1.0) * 100.0 << "]";
+			out << std::setw(26) << change.str() << std::setprecision(4) << std::setw(10) << c.pValue;
+		}
+
+		if (c.hasAllocations)
+		{
+			std::ostringstream allocations;
+			allocations << std::fixed << std::setprecision(1) << c.baselineAllocations << " -> " << c.currentAllocations;
+			out << std::setw(20) << allocations.str();
+		}
+		else
+		{
+			out << std::setw(20) << "-";
+		}
+
+		out << VERDICTS[static_cast<int>(c.verdict)] << "\n";
+	}
+}
\ No newline at end of file
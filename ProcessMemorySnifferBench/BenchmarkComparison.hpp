@@ -0,0 +1,82 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.hpp"
+
+/// <summary>
+/// The outcome of comparing one benchmark with its baseline.
+/// </summary>
+enum class ComparisonVerdict
+{
+	Unchanged,
+	Improvement,
+	Regression,
+	New,
+	Missing
+};
+
+/// <summary>
+/// One benchmark compared with its baseline. Times are per iteration, so a ratio above 1 means lower throughput and higher latency.
+/// </summary>
+struct BenchmarkComparison
+{
+	/// <summary>
+	/// The benchmark name.
+	/// </summary>
+	std::string			name;
+
+	/// <summary>
+	/// The median time per iteration in the baseline and in the current run, in nanoseconds.
+	/// </summary>
+	double				baselineMedianNs{ 0.0 };
+	double				currentMedianNs{ 0.0 };
+
+	/// <summary>
+	/// currentMedianNs / baselineMedianNs.
+	/// </summary>
+	double				ratio{ 1.0 };
+
+	/// <summary>
+	/// The 95% bootstrap confidence interval of the ratio of medians.
+	/// </summary>
+	double				ratioLow{ 1.0 };
+	double				ratioHigh{ 1.0 };
+
+	/// <summary>
+	/// The two-sided Mann-Whitney U p-value of the two sample sets.
+	/// </summary>
+	double				pValue{ 1.0 };
+
+	/// <summary>
+	/// Allocations per iteration in the baseline and in the current run; only valid if both runs counted them.
+	/// </summary>
+	bool				hasAllocations{ false };
+	double				baselineAllocations{ 0.0 };
+	double				currentAllocations{ 0.0 };
+
+	/// <summary>
+	/// The verdict.
+	/// </summary>
+	ComparisonVerdict	verdict{ ComparisonVerdict::Unchanged };
+};
+
+/// <summary>
+/// Extra allocations per iteration, beyond the relative threshold, from which a benchmark counts as regressed. Allocation counts
+/// are deterministic except for one-time allocations amortized over the iterations, so they need no statistical test.
+/// </summary>
+constexpr double ALLOCATION_SLACK = 0.5;
+
+/// <summary>
+/// Significance level for both the Mann-Whitney test and the bootstrap interval.
+/// </summary>
+constexpr double COMPARISON_ALPHA = 0.05;
+
+[[nodiscard]] std::vector<BenchmarkResult> loadResults(const std::wstring& path);
+
+[[nodiscard]] std::vector<BenchmarkComparison> compareResults(const std::vector<BenchmarkResult>& baseline,
+	const std::vector<BenchmarkResult>& current, double threshold);
+
+void printComparison(std::ostream& out, const std::vector<BenchmarkComparison>& comparisons, double threshold);
\ No newline at end of file
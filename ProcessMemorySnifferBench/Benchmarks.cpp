@@ -0,0 +1,546 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "AccountNameCache.hpp"
+#include "AddressIndex.hpp"
+#include "ArrowStreamWriter.hpp"
+#include "ByteFormat.hpp"
+#include "CommandLineArena.hpp"
+#include "CommandLine.hpp"
+#include "HeavyHitters.hpp"
+#include "MetadataCache.hpp"
+#include "MetadataResolver.hpp"
+#include "OutputBuffer.hpp"
+#include "ProcessMemorySniffer.hpp"
+#include "ProcessQueryService.hpp"
+#include "QuantileSketch.hpp"
+#include "RowExporter.hpp"
+#include "Snapshot.hpp"
+#include "SketchStore.hpp"
+#include "StringInterner.hpp"
+#include "TableColumns.hpp"
+#include "Win32Error.hpp"
+
+/// <summary>
+/// The number of rows a rendering benchmark prints, like a tall console window.
+/// </summary>
+constexpr std::size_t RENDERED_ROWS = 50;
+
+/// <summary>
+/// The number of regions in the synthetic address space, about what a large browser or IDE process maps.
+/// </summary>
+constexpr std::size_t SYNTHETIC_REGIONS = 20'000;
+
+/// <summary>
+/// The number of addresses an address lookup benchmark resolves per iteration, like the stacks of a process with many threads.
+/// </summary>
+constexpr std::size_t LOOKUP_ADDRESSES = 4096;
+
+/// <summary>
+/// How long the resolver benchmarks wait for the resolver to resolve every live process before they are timed; a process whose
+/// query hangs stays pending and is timed as such.
+/// </summary>
+constexpr std::chrono::seconds RESOLVER_WARMUP(10);
+
+/// <summary>
+/// A query service whose names and owners come from a background resolver, with the cache the resolver stores them in. The
+/// members are declared in the order they depend on each other, so the resolver is stopped before its cache is destroyed.
+/// </summary>
+struct ResolvedCollection
+{
+	/// <summary>
+	/// The resolved names and owners; in memory only.
+	/// </summary>
+	MetadataCache		cache{ std::wstring() };
+
+	/// <summary>
+	/// The resolver, without tracing.
+	/// </summary>
+	MetadataResolver	resolver{ cache, nullptr };
+
+	/// <summary>
+	/// The service, with the resolver attached.
+	/// </summary>
+	ProcessQueryService	service;
+};
+
+/// <summary>
+/// Owns a handle to the NUL device, so the exporters' WriteFile calls are timed without disk or pipe effects.
+/// </summary>
+class NullDevice
+{
+public:
+	NullDevice()
+		: handle_(::CreateFileW(L"NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr))
+	{
+		if (handle_ == INVALID_HANDLE_VALUE)
+		{
+			throw Win32Error("CreateFileW(NUL) failed.");
+		}
+	}
+
+	NullDevice(const NullDevice&) = delete;
+	NullDevice& operator=(const NullDevice&) = delete;
+
+	~NullDevice() noexcept
+	{
+		::CloseHandle(handle_);
+	}
+
+	[[nodiscard]] HANDLE get() const noexcept
+	{
+		return handle_;
+	}
+
+private:
+	HANDLE	handle_;
+};
+
+/// <summary>
+/// Renders the default process table for the top rows of a process list into a reused string stream.
+/// </summary>
+/// <param name="out">The stream; cleared first.</param>
+/// <param name="processes">The processes.</param>
+/// <param name="accounts">Resolves owner SIDs.</param>
+static void renderTable(std::wostringstream& out, const std::vector<ProcessInfo>& processes, AccountNameCache& accounts)
+{
+	out.str({});
+	DefaultColumns::writeHeader(out);
+
+	for (const auto& p : selectTopByWorkingSet(processes, RENDERED_ROWS))
+	{
+		DefaultColumns::writeRow(out, TableRow{ p, nullptr, accounts, {} });
+	}
+
+	doNotOptimize(out.tellp());
+}
+
+/// <summary>
+/// Runs everything a tick does after collection on a process list: summary sketches, heavy hitters, the top-N table and a CSV export.
+/// </summary>
+/// <param name="processes">The processes.</param>
+/// <param name="accounts">Resolves owner SIDs.</param>
+/// <param name="sink">Receives the export.</param>
+static void processTick(const std::vector<ProcessInfo>& processes, AccountNameCache& accounts, OutputBuffer& sink)
+{
+	SketchStore summary;
+	HeavyHitters heavyHitters(64);
+
+	for (const auto& p : processes)
+	{
+		summary.add(p.name, p.workingSetBytes);
+		heavyHitters.add(p.name, static_cast<double>(p.workingSetBytes));
+	}
+
+	std::wostringstream table;
+	renderTable(table, processes, accounts);
+
+	RowExporter exporter(ExportFormat::Csv, sink);
+	exporter.writeHeader();
+
+	for (const auto& p : processes)
+	{
+		exporter.writeRow(p, 0, 0);
+	}
+
+	sink.flush();
+	doNotOptimize(summary);
+	doNotOptimize(heavyHitters);
+}
+
+/// <summary>
+/// Registers the benchmarks that need a live system: PID enumeration, per-process queries, account name resolution and a full tick.
+/// </summary>
+/// <param name="runner">The runner.</param>
+static void registerCollectionBenchmarks(BenchmarkRunner& runner)
+{
+	auto service = std::make_shared<ProcessQueryService>();
+	const auto pids = std::make_shared<std::vector<DWORD>>(service->enumerateProcessIds());
+	const auto live = service->collectProcesses(*pids);
+
+	runner.add("collect/enumerate_pids", pids->size(), [service](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				doNotOptimize(service->enumerateProcessIds());
+			}
+		});
+
+	runner.add("collect/query_processes", pids->size(), [service, pids](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				doNotOptimize(service->collectProcesses(*pids));
+			}
+		});
+
+	// The same queries through the background resolver once it has resolved every process, as on the second tick of a run or
+	// after a warm start: names and owners come from the resolver's cache instead of being queried.
+	auto resolved = std::make_shared<ResolvedCollection>();
+	resolved->service.attachResolver(&resolved->resolver);
+	doNotOptimize(resolved->service.collectProcesses(*pids));
+	(void)resolved->resolver.waitUntilIdle(RESOLVER_WARMUP);
+
+	runner.add("collect/query_processes_cached", pids->size(), [resolved, pids](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				doNotOptimize(resolved->service.collectProcesses(*pids));
+			}
+		});
+
+	std::set<std::wstring> uniqueSids;
+
+	for (const auto& p : live)
+	{
+		uniqueSids.insert(p.userSid);
+	}
+
+	const auto sids = std::make_shared<std::vector<std::wstring>>(uniqueSids.begin(), uniqueSids.end());
+
+	runner.add("resolve/account_names_cold", sids->size(), [sids](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				AccountNameCache accounts;
+
+				for (const auto& sid : *sids)
+				{
+					doNotOptimize(accounts.resolve(sid));
+				}
+			}
+		});
+
+	auto warmAccounts = std::make_shared<AccountNameCache>();
+
+	runner.add("resolve/account_names_warm", sids->size(), [sids, warmAccounts](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				for (const auto& sid : *sids)
+				{
+					doNotOptimize(warmAccounts->resolve(sid));
+				}
+			}
+		});
+
+	auto accounts = std::make_shared<AccountNameCache>();
+	auto sink = std::make_shared<NullDevice>();
+
+	runner.add("end_to_end/live_tick", pids->size(), [service, accounts, sink](std::uint64_t iterations)
+		{
+			OutputBuffer out(sink->get());
+
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				processTick(service->collectProcesses(), *accounts, out);
+			}
+		});
+}
+
+/// <summary>
+/// Registers the benchmarks of one collection-independent stage on a process list.
+/// </summary>
+/// <param name="runner">The runner.</param>
+/// <param name="suffix">Appended to each name, e.g. "synthetic" or "recorded".</param>
+/// <param name="processes">The process list.</param>
+static void registerListBenchmarks(BenchmarkRunner& runner, const std::string& suffix, const std::vector<ProcessInfo>& processes)
+{
+	const auto list = std::make_shared<std::vector<ProcessInfo>>(processes);
+	const std::size_t n = list->size();
+	auto accounts = std::make_shared<AccountNameCache>();
+	auto sink = std::make_shared<NullDevice>();
+
+	runner.add("resolve/intern_names_" + suffix, n, [list](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				StringInterner names;
+
+				for (const auto& p : *list)
+				{
+					doNotOptimize(names.intern(p.name));
+				}
+			}
+		});
+
+	runner.add("sort/top_10_" + suffix, n, [list](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				doNotOptimize(selectTopByWorkingSet(*list, 10));
+			}
+		});
+
+	runner.add("sort/top_all_" + suffix, n, [list](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				doNotOptimize(selectTopByWorkingSet(*list, list->size()));
+			}
+		});
+
+	runner.add("render/table_" + suffix, std::min(n, RENDERED_ROWS), [list, accounts](std::uint64_t iterations)
+		{
+			std::wostringstream out;
+
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				renderTable(out, *list, *accounts);
+			}
+		});
+
+	runner.add("render/format_bytes_" + suffix, n, [list](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				for (const auto& p : *list)
+				{
+					doNotOptimize(formatBytes(p.workingSetBytes));
+				}
+			}
+		});
+
+	const std::pair<const char*, ExportFormat> rowFormats[] = { { "csv", ExportFormat::Csv }, { "ndjson", ExportFormat::Ndjson } };
+
+	for (const auto& [name, format] : rowFormats)
+	{
+		runner.add(std::string("export/") + name + "_" + suffix, n, [list, sink, format](std::uint64_t iterations)
+			{
+				OutputBuffer out(sink->get());
+				RowExporter exporter(format, out);
+
+				for (std::uint64_t i = 0; i < iterations; i++)
+				{
+					for (const auto& p : *list)
+					{
+						exporter.writeRow(p, i, 0);
+					}
+
+					out.flush();
+				}
+			});
+	}
+
+	runner.add("export/arrow_" + suffix, n, [list, sink](std::uint64_t iterations)
+		{
+			OutputBuffer out(sink->get());
+			ArrowStreamWriter writer(out);
+
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				writer.writeBatch(*list, i, 0);
+				out.flush();
+			}
+		});
+
+	runner.add("end_to_end/tick_" + suffix, n, [list, accounts, sink](std::uint64_t iterations)
+		{
+			OutputBuffer out(sink->get());
+
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				processTick(*list, *accounts, out);
+			}
+		});
+}
+
+/// <summary>
+/// Generates a command line per process: processes with a common name share one of a few command lines, like services
+/// started by one host or workers of one pool, and the others get a unique one.
+/// </summary>
+/// <param name="processes">The processes.</param>
+/// <returns>The command lines, in the order of processes.</returns>
+static std::vector<std::wstring> makeCommandLines(const std::vector<ProcessInfo>& processes)
+{
+	constexpr const wchar_t* SHARED_ARGUMENTS[] = {
+		L" -k netsvcs -p",
+		L" -k LocalServiceNetworkRestricted -p",
+		L" --type=renderer --lang=en-US --renderer-client-id=7 --launch-time-ticks=1234567890 --field-trial-handle=1234,i,567,890",
+		L" --type=utility --utility-sub-type=network.mojom.NetworkService --lang=en-US --service-sandbox-type=none",
+	};
+
+	std::vector<std::wstring> commandLines;
+	commandLines.reserve(processes.size());
+
+	for (const auto& p : processes)
+	{
+		if (p.name.starts_with(L"app"))
+		{
+			commandLines.push_back(L"\"C:\\Program Files\\Apps\\" + p.name + L"\" --config \"C:\\ProgramData\\Apps\\" + p.name + L".json\"");
+		}
+		else
+		{
+			commandLines.push_back(L"\"C:\\Windows\\System32\\" + p.name + L"\"" + SHARED_ARGUMENTS[p.pid % std::size(SHARED_ARGUMENTS)]);
+		}
+	}
+
+	return commandLines;
+}
+
+/// <summary>
+/// Registers the command line storage benchmarks: one std::wstring per process against CommandLineArena. Each iteration
+/// stores the command lines of every process from scratch, so the allocated bytes per iteration (counters.allocated_bytes)
+/// are the memory needed per processes.size() processes, e.g. per 10k for the synthetic list.
+/// </summary>
+/// <param name="runner">The runner.</param>
+/// <param name="processes">The processes to generate command lines for.</param>
+static void registerCommandLineBenchmarks(BenchmarkRunner& runner, const std::vector<ProcessInfo>& processes)
+{
+	const auto commandLines = std::make_shared<std::vector<std::wstring>>(makeCommandLines(processes));
+	const std::size_t n = commandLines->size();
+
+	runner.add("resolve/command_lines_copied", n, [commandLines](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				std::vector<std::wstring> copies;
+				copies.reserve(commandLines->size());
+
+				for (const auto& commandLine : *commandLines)
+				{
+					copies.emplace_back(commandLine);
+				}
+
+				doNotOptimize(copies);
+			}
+		});
+
+	runner.add("resolve/command_lines_arena", n, [commandLines](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				CommandLineArena arena;
+				std::vector<std::wstring_view> views;
+				views.reserve(commandLines->size());
+
+				for (const auto& commandLine : *commandLines)
+				{
+					views.push_back(arena.intern(commandLine));
+				}
+
+				doNotOptimize(views);
+			}
+		});
+}
+
+/// <summary>
+/// Registers the parsing benchmarks: the command line and a serialized quantile sketch.
+/// </summary>
+/// <param name="runner">The runner.</param>
+/// <param name="processes">Values for the sketch.</param>
+static void registerParsingBenchmarks(BenchmarkRunner& runner, const std::vector<ProcessInfo>& processes)
+{
+	runner.add("parse/command_line", 1, [](std::uint64_t iterations)
+		{
+			std::wstring args[] = { L"ProcessMemorySniffer", L"--top", L"25", L"--ticks", L"10", L"--interval", L"500",
+				L"--columns", L"memory", L"--by-user", L"--heavy-hitters", L"64" };
+			std::vector<wchar_t*> argv;
+
+			for (auto& arg : args)
+			{
+				argv.push_back(arg.data());
+			}
+
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				doNotOptimize(parseCommandLine(static_cast<int>(argv.size()), argv.data()));
+			}
+		});
+
+	QuantileSketch sketch;
+
+	for (const auto& p : processes)
+	{
+		sketch.add(p.workingSetBytes);
+	}
+
+	auto text = std::make_shared<std::string>();
+	sketch.serialize(*text);
+
+	runner.add("parse/quantile_sketch", 1, [text](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				QuantileSketch parsed;
+
+				if (!QuantileSketch::parse(*text, parsed))
+				{
+					throw std::runtime_error("Serialized sketch did not parse.");
+				}
+
+				doNotOptimize(parsed);
+			}
+		});
+}
+
+/// <summary>
+/// Registers the address lookup benchmarks: independent AddressIndex::find calls against one AddressIndex::findSorted merge
+/// over the same sorted addresses, spread uniformly over a synthetic address space so that some land in gaps.
+/// </summary>
+/// <param name="runner">The runner.</param>
+static void registerAddressIndexBenchmarks(BenchmarkRunner& runner)
+{
+	const auto index = std::make_shared<AddressIndex>(makeSyntheticRegions(SYNTHETIC_REGIONS, 1));
+	const auto addresses = std::make_shared<std::vector<std::uintptr_t>>();
+	const std::uintptr_t first = index->regions().front().base;
+	const std::uintptr_t span = index->regions().back().end() - first;
+
+	for (std::size_t i = 0; i < LOOKUP_ADDRESSES; i++)
+	{
+		addresses->push_back(first + span / LOOKUP_ADDRESSES * i);
+	}
+
+	runner.add("lookup/address_index_find", LOOKUP_ADDRESSES, [index, addresses](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				for (const std::uintptr_t address : *addresses)
+				{
+					doNotOptimize(index->find(address));
+				}
+			}
+		});
+
+	runner.add("lookup/address_index_find_sorted", LOOKUP_ADDRESSES, [index, addresses](std::uint64_t iterations)
+		{
+			std::vector<const MemoryRegion*> results;
+
+			for (std::uint64_t i = 0; i < iterations; i++)
+			{
+				index->findSorted(*addresses, results);
+				doNotOptimize(results);
+			}
+		});
+}
+
+/// <summary>
+/// Registers every benchmark. Inputs are prepared here, outside the timed bodies.
+/// </summary>
+/// <param name="runner">The runner.</param>
+/// <param name="inputs">The process lists for the collection-independent benchmarks.</param>
+void registerBenchmarks(BenchmarkRunner& runner, const BenchmarkInputs& inputs)
+{
+	registerCollectionBenchmarks(runner);
+	registerParsingBenchmarks(runner, inputs.synthetic);
+	registerListBenchmarks(runner, "synthetic", inputs.synthetic);
+	registerCommandLineBenchmarks(runner, inputs.synthetic);
+	registerAddressIndexBenchmarks(runner);
+
+	if (!inputs.recorded.empty())
+	{
+		registerListBenchmarks(runner, "recorded", inputs.recorded);
+	}
+}
\ No newline at end of file
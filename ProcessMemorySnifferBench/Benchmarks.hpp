@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "ProcessInfo.hpp"
+
+/// <summary>
+/// The process lists the collection-independent benchmarks run against.
+/// </summary>
+struct BenchmarkInputs
+{
+	/// <summary>
+	/// A generated list, the same on every machine (see makeSyntheticProcesses()).
+	/// </summary>
+	std::vector<ProcessInfo>	synthetic;
+
+	/// <summary>
+	/// A recorded snapshot loaded with loadSnapshot(); the recorded benchmarks are skipped if empty.
+	/// </summary>
+	std::vector<ProcessInfo>	recorded;
+};
+
+void registerBenchmarks(BenchmarkRunner& runner, const BenchmarkInputs& inputs);
\ No newline at end of file
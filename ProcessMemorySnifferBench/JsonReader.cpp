@@ -0,0 +1,373 @@
+#include <cstdlib>
+#include <stdexcept>
+
+#include "JsonReader.hpp"
+
+/// <summary>
+/// Maximum nesting of arrays and objects, so malformed input cannot exhaust the stack.
+/// </summary>
+constexpr int MAX_DEPTH = 64;
+
+/// <summary>
+/// Recursive descent parser over a complete JSON document. Throws std::runtime_error with the byte offset on malformed input.
+/// </summary>
+class JsonParser
+{
+public:
+	explicit JsonParser(std::string_view text) noexcept : text_(text)
+	{ }
+
+	/// <summary>
+	/// Parses the document; trailing content other than whitespace is an error.
+	/// </summary>
+	/// <returns>The root value.</returns>
+	JsonValue parseDocument()
+	{
+		JsonValue value = parseValue(0);
+		skipWhitespace();
+
+		if (pos_ != text_.size())
+		{
+			fail("trailing characters");
+		}
+
+		return value;
+	}
+
+private:
+	/// <summary>
+	/// Throws a std::runtime_error describing the error at the current offset.
+	/// </summary>
+	[[noreturn]] void fail(const char* what) const
+	{
+		throw std::runtime_error(std::string("Invalid JSON at offset ") + std::to_string(pos_) + ": " + what);
+	}
+
+	/// <summary>
+	/// Advances past insignificant whitespace.
+	/// </summary>
+	void skipWhitespace() noexcept
+	{
+		while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r'))
+		{
+			pos_++;
+		}
+	}
+
+	/// <summary>
+	/// Skips whitespace and consumes c if it is next.
+	/// </summary>
+	bool consume(char c) noexcept
+	{
+		skipWhitespace();
+
+		if (pos_ < text_.size() && text_[pos_] == c)
+		{
+			pos_++;
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Consumes c or fails.
+	/// </summary>
+	void expect(char c)
+	{
+		if (!consume(c))
+		{
+			fail("unexpected character");
+		}
+	}
+
+	/// <summary>
+	/// Consumes a literal such as "true" if it is next.
+	/// </summary>
+	bool consumeLiteral(std::string_view literal) noexcept
+	{
+		if (text_.substr(pos_, literal.size()) == literal)
+		{
+			pos_ += literal.size();
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Parses any value; depth is the current nesting.
+	/// </summary>
+	JsonValue parseValue(int depth)
+	{
+		if (depth > MAX_DEPTH)
+		{
+			fail("nesting too deep");
+		}
+
+		skipWhitespace();
+
+		if (pos_ >= text_.size())
+		{
+			fail("unexpected end of input");
+		}
+
+		JsonValue value;
+		const char c = text_[pos_];
+
+		if (c == '{')
+		{
+			pos_++;
+			value.kind = JsonValue::Kind::Object;
+
+			if (consume('}'))
+			{
+				return value;
+			}
+
+			do
+			{
+				skipWhitespace();
+
+				if (pos_ >= text_.size() || text_[pos_] != '"')
+				{
+					fail("expected member name");
+				}
+
+				std::string name = parseString();
+				expect(':');
+				value.object.emplace_back(std::move(name), parseValue(depth + 1));
+			} while (consume(','));
+
+			expect('}');
+		}
+		else if (c == '[')
+		{
+			pos_++;
+			value.kind = JsonValue::Kind::Array;
+
+			if (consume(']'))
+			{
+				return value;
+			}
+
+			do
+			{
+				value.array.push_back(parseValue(depth + 1));
+			} while (consume(','));
+
+			expect(']');
+		}
+		else if (c == '"')
+		{
+			value.kind = JsonValue::Kind::String;
+			value.string = parseString();
+		}
+		else if (consumeLiteral("true") || consumeLiteral("false"))
+		{
+			value.kind = JsonValue::Kind::Boolean;
+			value.boolean = c == 't';
+		}
+		else if (consumeLiteral("null"))
+		{
+			value.kind = JsonValue::Kind::Null;
+		}
+		else
+		{
+			value.kind = JsonValue::Kind::Number;
+			value.number = parseNumber();
+		}
+
+		return value;
+	}
+
+	/// <summary>
+	/// Parses a number.
+	/// </summary>
+	double parseNumber()
+	{
+		const std::size_t start = pos_;
+
+		while (pos_ < text_.size() && std::string_view("+-0123456789.eE").find(text_[pos_]) != std::string_view::npos)
+		{
+			pos_++;
+		}
+
+		const std::string number(text_.substr(start, pos_ - start));
+		char* end = nullptr;
+		const double result = std::strtod(number.c_str(), &end);
+
+		if (number.empty() || end != number.c_str() + number.size())
+		{
+			pos_ = start;
+			fail("invalid number");
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Parses the four hex digits of a \u escape.
+	/// </summary>
+	unsigned parseHex4()
+	{
+		if (pos_ + 4 > text_.size())
+		{
+			fail("truncated \\u escape");
+		}
+
+		unsigned code = 0;
+
+		for (int i = 0; i < 4; i++)
+		{
+			const char h = text_[pos_++];
+			code <<= 4;
+
+			if (h >= '0' && h <= '9')
+			{
+				code |= static_cast<unsigned>(h - '0');
+			}
+			else if (h >= 'a' && h <= 'f')
+			{
+				code |= static_cast<unsigned>(h - 'a' + 10);
+			}
+			else if (h >= 'A' && h <= 'F')
+			{
+				code |= static_cast<unsigned>(h - 'A' + 10);
+			}
+			else
+			{
+				fail("invalid \\u escape");
+			}
+		}
+
+		return code;
+	}
+
+	/// <summary>
+	/// Appends a code point as UTF-8.
+	/// </summary>
+	static void appendUtf8(std::string& out, unsigned code)
+	{
+		if (code < 0x80)
+		{
+			out += static_cast<char>(code);
+		}
+		else if (code < 0x800)
+		{
+			out += static_cast<char>(0xC0 | (code >> 6));
+			out += static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else if (code < 0x10000)
+		{
+			out += static_cast<char>(0xE0 | (code >> 12));
+			out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (code & 0x3F));
+		}
+		else
+		{
+			out += static_cast<char>(0xF0 | (code >> 18));
+			out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (code & 0x3F));
+		}
+	}
+
+	/// <summary>
+	/// Parses a string, decoding escapes; unpaired surrogates become U+FFFD.
+	/// </summary>
+	std::string parseString()
+	{
+		pos_++;
+		std::string result;
+
+		while (true)
+		{
+			if (pos_ >= text_.size())
+			{
+				fail("unterminated string");
+			}
+
+			const char c = text_[pos_++];
+
+			if (c == '"')
+			{
+				return result;
+			}
+
+			if (c != '\\')
+			{
+				result += c;
+				continue;
+			}
+
+			if (pos_ >= text_.size())
+			{
+				fail("unterminated escape");
+			}
+
+			switch (const char e = text_[pos_++])
+			{
+			case '"':
+			case '\\':
+			case '/':
+				result += e;
+				break;
+			case 'b':
+				result += '\b';
+				break;
+			case 'f':
+				result += '\f';
+				break;
+			case 'n':
+				result += '\n';
+				break;
+			case 'r':
+				result += '\r';
+				break;
+			case 't':
+				result += '\t';
+				break;
+			case 'u':
+			{
+				unsigned code = parseHex4();
+
+				if (code >= 0xD800 && code < 0xDC00 && consumeLiteral("\\u"))
+				{
+					const unsigned low = parseHex4();
+					code = low >= 0xDC00 && low < 0xE000 ? 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00) : 0xFFFD;
+				}
+				else if (code >= 0xD800 && code < 0xE000)
+				{
+					code = 0xFFFD;
+				}
+
+				appendUtf8(result, code);
+				break;
+			}
+			default:
+				fail("invalid escape");
+			}
+		}
+	}
+
+	/// <summary>
+	/// The document.
+	/// </summary>
+	std::string_view	text_;
+
+	/// <summary>
+	/// The current byte offset.
+	/// </summary>
+	std::size_t			pos_{ 0 };
+};
+
+/// <summary>
+/// Parses a JSON document. Throws std::runtime_error if the text is not valid JSON.
+/// </summary>
+/// <param name="text">The document.</param>
+/// <returns>The root value.</returns>
+JsonValue parseJson(std::string_view text)
+{
+	return JsonParser(text).parseDocument();
+}
\ No newline at end of file
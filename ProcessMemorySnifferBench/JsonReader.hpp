@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// A parsed JSON value. Just enough JSON to read back the benchmark result files this tool writes: numbers are doubles,
+/// strings are kept as UTF-8 with escapes decoded, and object members keep their order.
+/// </summary>
+struct JsonValue
+{
+	/// <summary>
+	/// The kind of value.
+	/// </summary>
+	enum class Kind
+	{
+		Null,
+		Boolean,
+		Number,
+		String,
+		Array,
+		Object
+	};
+
+	Kind										kind{ Kind::Null };
+	bool										boolean{ false };
+	double										number{ 0.0 };
+	std::string									string;
+	std::vector<JsonValue>						array;
+	std::vector<std::pair<std::string, JsonValue>>	object;
+
+	/// <summary>
+	/// Looks up an object member.
+	/// </summary>
+	/// <param name="key">The member name.</param>
+	/// <returns>The member, or nullptr if this is not an object or has no such member.</returns>
+	[[nodiscard]] const JsonValue* find(std::string_view key) const noexcept
+	{
+		for (const auto& [name, value] : object)
+		{
+			if (name == key)
+			{
+				return &value;
+			}
+		}
+
+		return nullptr;
+	}
+};
+
+[[nodiscard]] JsonValue parseJson(std::string_view text);
\ No newline at end of file
@@ -0,0 +1,878 @@
+#define NOMINMAX
+#include <Windows.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SelfChecks.hpp"
+#include "AddressIndex.hpp"
+#include "ArrowStreamReader.hpp"
+#include "ArrowStreamWriter.hpp"
+#include "HeavyHitters.hpp"
+#include "OutputBuffer.hpp"
+#include "RowExporter.hpp"
+#include "Snapshot.hpp"
+#include "TextEncoding.hpp"
+#include "Win32Error.hpp"
+
+/// <summary>
+/// Owns a temporary file that is deleted when closed, so a check can write through an OutputBuffer and read the bytes back.
+/// </summary>
+class TemporaryFile
+{
+public:
+	TemporaryFile()
+	{
+		wchar_t directory[MAX_PATH + 1];
+		wchar_t path[MAX_PATH + 1];
+
+		if (::GetTempPathW(MAX_PATH + 1, directory) == 0 || ::GetTempFileNameW(directory, L"pms", 0, path) == 0)
+		{
+			throw Win32Error("Failed to create a temporary file name.");
+		}
+
+		handle_ = ::CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+
+		if (handle_ == INVALID_HANDLE_VALUE)
+		{
+			throw Win32Error("CreateFileW(temporary file) failed.");
+		}
+	}
+
+	TemporaryFile(const TemporaryFile&) = delete;
+	TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+	~TemporaryFile() noexcept
+	{
+		::CloseHandle(handle_);
+	}
+
+	[[nodiscard]] HANDLE get() const noexcept
+	{
+		return handle_;
+	}
+
+	/// <summary>
+	/// Reads the whole file from the start.
+	/// </summary>
+	/// <returns>The file contents.</returns>
+	[[nodiscard]] std::vector<std::uint8_t> readAll() const
+	{
+		LARGE_INTEGER start{};
+		LARGE_INTEGER size{};
+
+		if (!::SetFilePointerEx(handle_, start, nullptr, FILE_BEGIN) || !::GetFileSizeEx(handle_, &size))
+		{
+			throw Win32Error("Failed to rewind the temporary file.");
+		}
+
+		std::vector<std::uint8_t> bytes(static_cast<std::size_t>(size.QuadPart));
+		std::size_t offset = 0;
+
+		while (offset < bytes.size())
+		{
+			DWORD read = 0;
+
+			if (!::ReadFile(handle_, bytes.data() + offset, static_cast<DWORD>(bytes.size() - offset), &read, nullptr) || read == 0)
+			{
+				throw Win32Error("ReadFile(temporary file) failed.");
+			}
+
+			offset += read;
+		}
+
+		return bytes;
+	}
+
+private:
+	HANDLE	handle_{ INVALID_HANDLE_VALUE };
+};
+
+/// <summary>
+/// Throws std::runtime_error naming a failed expectation of the Arrow round trip.
+/// </summary>
+/// <param name="condition">The expectation.</param>
+/// <param name="what">What was expected, for the message.</param>
+static void requireArrow(bool condition, const std::string& what)
+{
+	if (!condition)
+	{
+		throw std::runtime_error("Arrow round trip: " + what);
+	}
+}
+
+/// <summary>
+/// Reads one fixed-width value of a column buffer.
+/// </summary>
+/// <param name="buffer">The values buffer.</param>
+/// <param name="index">The row.</param>
+/// <returns>The value.</returns>
+template <typename T>
+static T arrowValue(std::span<const std::uint8_t> buffer, std::size_t index)
+{
+	requireArrow((index + 1) * sizeof(T) <= buffer.size(), "value " + std::to_string(index) + " past the end of its buffer");
+
+	T value;
+	std::memcpy(&value, buffer.data() + index * sizeof(T), sizeof(T));
+	return value;
+}
+
+/// <summary>
+/// Resolves an address with a linear scan over a region list; the reference the index is checked against.
+/// </summary>
+/// <param name="regions">The regions.</param>
+/// <param name="address">The address to resolve.</param>
+/// <returns>A pointer to the region containing address, or nullptr.</returns>
+static const MemoryRegion* findLinear(const std::vector<MemoryRegion>& regions, std::uintptr_t address) noexcept
+{
+	for (const auto& region : regions)
+	{
+		if (region.base <= address && address < region.end())
+		{
+			return &region;
+		}
+	}
+
+	return nullptr;
+}
+
+/// <summary>
+/// Collects the addresses worth probing for a region list, in ascending order: zero, the bytes around every region boundary
+/// (so both sides of each gap and of each pair of adjacent regions), the middle of every region and gap, and the largest address.
+/// </summary>
+/// <param name="regions">The regions, sorted by base address.</param>
+/// <returns>The addresses, sorted, possibly with duplicates.</returns>
+static std::vector<std::uintptr_t> probeAddresses(const std::vector<MemoryRegion>& regions)
+{
+	std::vector<std::uintptr_t> addresses{ 0 };
+
+	for (std::size_t i = 0; i < regions.size(); i++)
+	{
+		const MemoryRegion& region = regions[i];
+		addresses.push_back(region.base - 1);
+		addresses.push_back(region.base);
+		addresses.push_back(region.base + region.size / 2);
+		addresses.push_back(region.end() - 1);
+		addresses.push_back(region.end());
+
+		if (i + 1 < regions.size() && regions[i + 1].base > region.end())
+		{
+			addresses.push_back(region.end() + (regions[i + 1].base - region.end()) / 2);
+		}
+	}
+
+	addresses.push_back(std::numeric_limits<std::uintptr_t>::max());
+
+	// Around adjacent regions the bytes before a base come after the end of the previous region; findSorted needs them in order.
+	std::sort(addresses.begin(), addresses.end());
+
+	return addresses;
+}
+
+/// <summary>
+/// Checks AddressIndex::find and AddressIndex::findSorted against a linear scan: an empty list, a single region, two and three
+/// regions, lists whose size is or is next to a power of two (full and partial last levels of the Eytzinger tree), and a
+/// large list. Throws std::runtime_error on the first mismatch.
+/// </summary>
+/// <param name="log">Receives one line per checked list size.</param>
+static void checkAddressIndex(std::ostream& log)
+{
+	constexpr std::size_t SIZES[] = { 0, 1, 2, 3, 7, 8, 9, 100, 1023, 1024, 10'000 };
+
+	for (const std::size_t size : SIZES)
+	{
+		const AddressIndex index(makeSyntheticRegions(size, static_cast<std::uint32_t>(size) + 1));
+		const std::vector<MemoryRegion>& regions = index.regions();
+		const std::vector<std::uintptr_t> addresses = probeAddresses(regions);
+
+		std::vector<const MemoryRegion*> sorted;
+		index.findSorted(std::span<const std::uintptr_t>(addresses), sorted);
+
+		if (sorted.size() != addresses.size())
+		{
+			throw std::runtime_error("AddressIndex::findSorted returned " + std::to_string(sorted.size()) + " results for "
+				+ std::to_string(addresses.size()) + " addresses.");
+		}
+
+		for (std::size_t i = 0; i < addresses.size(); i++)
+		{
+			const MemoryRegion* expected = findLinear(regions, addresses[i]);
+
+			if (index.find(addresses[i]) != expected || sorted[i] != expected)
+			{
+				throw std::runtime_error("AddressIndex disagrees with a linear scan for address " + std::to_string(addresses[i])
+					+ " in a list of " + std::to_string(size) + " regions.");
+			}
+		}
+
+		log << "  address_index: " << size << " regions, " << addresses.size() << " addresses ok\n";
+	}
+}
+
+/// <summary>
+/// Checks the columns of the Schema message against the layout ArrowStreamWriter documents.
+/// </summary>
+/// <param name="schema">The Schema message.</param>
+static void checkArrowSchema(const ArrowMessage& schema)
+{
+	struct ExpectedField
+	{
+		const char*		name;
+		std::uint8_t	typeType;
+		std::int32_t	bitWidth;
+		bool			nullable;
+		std::int64_t	dictionaryId;
+	};
+
+	// Type codes: 2 = Int, 5 = Utf8 (the value type of the dictionary columns), 10 = Timestamp.
+	constexpr ExpectedField EXPECTED[] = {
+		{ "tick", 2, 64, false, -1 },
+		{ "timestamp", 10, 0, false, -1 },
+		{ "pid", 2, 32, false, -1 },
+		{ "name", 5, 0, true, 0 },
+		{ "user_sid", 5, 0, true, 1 },
+		{ "working_set_bytes", 2, 64, false, -1 },
+		{ "private_bytes", 2, 64, false, -1 },
+	};
+
+	requireArrow(schema.type == ArrowMessageType::Schema, "the stream does not start with a Schema message");
+	requireArrow(schema.version == 4, "metadata version is not V5");
+	requireArrow(schema.fields.size() == std::size(EXPECTED), "the schema does not have seven columns");
+
+	for (std::size_t i = 0; i < std::size(EXPECTED); i++)
+	{
+		const ArrowField& field = schema.fields[i];
+		const ExpectedField& expected = EXPECTED[i];
+		const std::string column = "column " + std::to_string(i) + " (" + field.name + ")";
+
+		requireArrow(field.name == expected.name, column + " is not " + expected.name);
+		requireArrow(field.typeType == expected.typeType, column + " has the wrong type");
+		requireArrow(field.bitWidth == expected.bitWidth && field.isSigned == false, column + " has the wrong integer width");
+		requireArrow(field.nullable == expected.nullable, column + " has the wrong nullability");
+		requireArrow(field.dictionaryId == expected.dictionaryId, column + " has the wrong dictionary");
+		requireArrow(field.dictionaryId < 0 || field.indexBitWidth == 32, column + " does not have int32 indices");
+	}
+
+	requireArrow(schema.fields[1].timeUnit == 1 && schema.fields[1].timezone == "UTC", "timestamp is not timestamp[ms, UTC]");
+}
+
+/// <summary>
+/// Checks the alignment of a message body: the body starts 8-byte aligned in the stream, and every buffer starts on a
+/// 64-byte boundary of the body, whose length is padded to a multiple of 64.
+/// </summary>
+/// <param name="message">The message.</param>
+static void checkArrowAlignment(const ArrowMessage& message)
+{
+	requireArrow(message.bodyPosition % 8 == 0, "a message body is not 8-byte aligned in the stream");
+	requireArrow(message.body.size() % 64 == 0, "a message body is not padded to 64 bytes");
+
+	for (std::size_t i = 0; i < message.buffers.size(); i++)
+	{
+		requireArrow(message.buffers[i].offset % 64 == 0, "buffer " + std::to_string(i) + " is not 64-byte aligned");
+		static_cast<void>(message.buffer(i));
+	}
+}
+
+/// <summary>
+/// Decodes the utf8 values of a DictionaryBatch message.
+/// </summary>
+/// <param name="message">The DictionaryBatch message.</param>
+/// <returns>The values.</returns>
+static std::vector<std::string> decodeArrowDictionary(const ArrowMessage& message)
+{
+	requireArrow(message.nodes.size() == 1 && message.buffers.size() == 3, "a dictionary batch is not a single utf8 column");
+	requireArrow(message.nodes[0].length == message.length && message.nodes[0].nullCount == 0, "a dictionary batch has nulls");
+
+	const auto offsets = message.buffer(1);
+	const auto data = message.buffer(2);
+	const auto length = static_cast<std::size_t>(message.length);
+	std::vector<std::string> values;
+
+	for (std::size_t i = 0; i < length; i++)
+	{
+		const auto begin = arrowValue<std::int32_t>(offsets, i);
+		const auto end = arrowValue<std::int32_t>(offsets, i + 1);
+		requireArrow(0 <= begin && begin <= end && static_cast<std::size_t>(end) <= data.size(), "dictionary offsets out of order");
+		values.emplace_back(reinterpret_cast<const char*>(data.data()) + begin, static_cast<std::size_t>(end - begin));
+	}
+
+	return values;
+}
+
+/// <summary>
+/// Decodes a RecordBatch message row by row and compares it with the processes it was written from.
+/// </summary>
+/// <param name="batch">The RecordBatch message.</param>
+/// <param name="processes">The processes passed to ArrowStreamWriter::writeBatch().</param>
+/// <param name="tick">The tick passed with them.</param>
+/// <param name="timestampMs">The timestamp passed with them.</param>
+/// <param name="names">The name dictionary received so far.</param>
+/// <param name="users">The user_sid dictionary received so far.</param>
+static void checkArrowBatch(const ArrowMessage& batch, const std::vector<ProcessInfo>& processes, std::size_t tick,
+	std::uint64_t timestampMs, const std::vector<std::string>& names, const std::vector<std::string>& users)
+{
+	const std::size_t n = processes.size();
+	const std::string where = "batch " + std::to_string(tick);
+
+	requireArrow(batch.length == static_cast<std::int64_t>(n), where + " has the wrong row count");
+	requireArrow(batch.nodes.size() == 7 && batch.buffers.size() == 14, where + " does not have seven columns of two buffers");
+
+	// Pending rows have a null name and SID; rows with an unknown owner only a null SID.
+	const auto nameNulls = static_cast<std::int64_t>(std::count_if(processes.begin(), processes.end(),
+		[](const ProcessInfo& p)
+		{
+			return p.metadataPending;
+		}));
+	const auto userNulls = static_cast<std::int64_t>(std::count_if(processes.begin(), processes.end(),
+		[](const ProcessInfo& p)
+		{
+			return p.userSid.empty() || p.metadataPending;
+		}));
+
+	for (std::size_t column = 0; column < 7; column++)
+	{
+		const std::int64_t nulls = column == 3 ? nameNulls : column == 4 ? userNulls : 0;
+		requireArrow(batch.nodes[column].length == batch.length, where + " has a column of the wrong length");
+		requireArrow(batch.nodes[column].nullCount == nulls, where + " has the wrong null count in column " + std::to_string(column));
+	}
+
+	// A column without nulls may omit its validity bitmap; the writer omits it exactly then.
+	const auto nameValidity = batch.buffer(6);
+	const auto userValidity = batch.buffer(8);
+	requireArrow(nameValidity.size() == (nameNulls > 0 ? (n + 7) / 8 : 0), where + " has a name validity bitmap of the wrong size");
+	requireArrow(userValidity.size() == (userNulls > 0 ? (n + 7) / 8 : 0), where + " has a user_sid validity bitmap of the wrong size");
+
+	const auto isValid = [](std::span<const std::uint8_t> validity, std::size_t i)
+		{
+			return validity.empty() || ((validity[i / 8] >> (i % 8)) & 1) != 0;
+		};
+
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const ProcessInfo& p = processes[i];
+		const std::string row = where + " row " + std::to_string(i);
+
+		requireArrow(arrowValue<std::uint64_t>(batch.buffer(1), i) == tick, row + ": tick");
+		requireArrow(arrowValue<std::int64_t>(batch.buffer(3), i) == static_cast<std::int64_t>(timestampMs), row + ": timestamp");
+		requireArrow(arrowValue<std::uint32_t>(batch.buffer(5), i) == p.pid, row + ": pid");
+		requireArrow(arrowValue<std::uint64_t>(batch.buffer(11), i) == p.workingSetBytes, row + ": working_set_bytes");
+		requireArrow(arrowValue<std::uint64_t>(batch.buffer(13), i) == p.privateBytes, row + ": private_bytes");
+
+		const bool nameValid = isValid(nameValidity, i);
+		requireArrow(nameValid == !p.metadataPending, row + ": name validity");
+
+		if (nameValid)
+		{
+			const auto name = arrowValue<std::int32_t>(batch.buffer(7), i);
+			requireArrow(name >= 0 && static_cast<std::size_t>(name) < names.size(), row + ": name index outside the dictionary");
+			requireArrow(names[static_cast<std::size_t>(name)] == toUtf8(p.name), row + ": name");
+		}
+
+		const bool userValid = isValid(userValidity, i);
+		requireArrow(userValid == !(p.userSid.empty() || p.metadataPending), row + ": user_sid validity");
+
+		if (userValid)
+		{
+			const auto user = arrowValue<std::int32_t>(batch.buffer(9), i);
+			requireArrow(user >= 0 && static_cast<std::size_t>(user) < users.size(), row + ": user_sid index outside the dictionary");
+			requireArrow(users[static_cast<std::size_t>(user)] == toUtf8(p.userSid), row + ": user_sid");
+		}
+	}
+}
+
+/// <summary>
+/// Writes a synthetic multi-tick run with ArrowStreamWriter and reads it back with ArrowStreamReader: the schema, every
+/// dictionary and record batch, the validity bitmaps and the 64-byte buffer alignment. The run has a batch with null SIDs,
+/// an empty batch, a batch that introduces a new name and SID (including non-ASCII text) as delta dictionaries and has a row
+/// whose metadata is pending, and a batch without nulls or new entries. Throws std::runtime_error on the first mismatch.
+/// </summary>
+/// <param name="log">Receives one line per decoded record batch.</param>
+static void checkArrowStream(std::ostream& log)
+{
+	constexpr std::uint64_t FIRST_TIMESTAMP_MS = 1'700'000'000'000;
+
+	std::vector<std::vector<ProcessInfo>> ticks(4);
+	ticks[0] = makeSyntheticProcesses(200, 11);
+	ticks[2] = ticks[0];
+
+	ProcessInfo added;
+	added.pid = 100'000;
+	added.name = L"\u00dcbersicht-\u65e5\u672c.exe";
+	added.userSid = L"S-1-5-21-3623811015-3361044348-30300820-1013";
+	added.workingSetBytes = 123'456'789;
+	added.privateBytes = 98'765'432;
+	ticks[2].push_back(added);
+
+	ProcessInfo pending;
+	pending.pid = 100'004;
+	pending.name = PENDING_METADATA;
+	pending.userSid = PENDING_METADATA;
+	pending.metadataPending = true;
+	pending.workingSetBytes = 4096;
+	ticks[2].push_back(pending);
+
+	ticks[3] = ticks[0];
+	std::erase_if(ticks[3], [](const ProcessInfo& p)
+		{
+			return p.userSid.empty();
+		});
+
+	TemporaryFile file;
+	OutputBuffer out(file.get());
+	ArrowStreamWriter writer(out);
+
+	for (std::size_t tick = 0; tick < ticks.size(); tick++)
+	{
+		writer.writeBatch(ticks[tick], tick, FIRST_TIMESTAMP_MS + tick * 1000);
+	}
+
+	writer.finish();
+
+	const std::vector<std::uint8_t> stream = file.readAll();
+	ArrowStreamReader reader(stream);
+	ArrowMessage message;
+
+	requireArrow(reader.next(message), "the stream is empty");
+	checkArrowSchema(message);
+
+	// The values received per dictionary id, and how many arrived since the last record batch.
+	std::vector<std::string> dictionaries[2];
+	std::size_t received[2] = {};
+	bool started[2] = {};
+
+	// The distinct names and SIDs of the ticks decoded so far, to derive which entries each delta must carry.
+	std::set<std::wstring> seenNames;
+	std::set<std::wstring> seenUsers;
+	std::size_t tick = 0;
+
+	while (reader.next(message))
+	{
+		checkArrowAlignment(message);
+
+		if (message.type == ArrowMessageType::DictionaryBatch)
+		{
+			requireArrow(message.dictionaryId == 0 || message.dictionaryId == 1, "unknown dictionary id");
+			const auto id = static_cast<std::size_t>(message.dictionaryId);
+
+			requireArrow(message.isDelta == started[id], "only the first batch of a dictionary may replace it");
+			requireArrow(!message.isDelta || message.length > 0, "an empty delta dictionary was written");
+			started[id] = true;
+
+			for (auto& value : decodeArrowDictionary(message))
+			{
+				dictionaries[id].push_back(std::move(value));
+				received[id]++;
+			}
+
+			continue;
+		}
+
+		requireArrow(message.type == ArrowMessageType::RecordBatch, "unexpected message type");
+		requireArrow(tick < ticks.size(), "more record batches than ticks");
+		requireArrow(started[0] && started[1], "a record batch precedes its dictionaries");
+
+		std::set<std::wstring> newNames;
+		std::set<std::wstring> newUsers;
+
+		for (const auto& p : ticks[tick])
+		{
+			if (p.metadataPending)
+			{
+				continue;
+			}
+
+			if (!seenNames.contains(p.name))
+			{
+				newNames.insert(p.name);
+			}
+
+			if (!p.userSid.empty() && !seenUsers.contains(p.userSid))
+			{
+				newUsers.insert(p.userSid);
+			}
+		}
+
+		requireArrow(received[0] == newNames.size(), "batch " + std::to_string(tick) + " was preceded by the wrong number of new names");
+		requireArrow(received[1] == newUsers.size(), "batch " + std::to_string(tick) + " was preceded by the wrong number of new SIDs");
+
+		checkArrowBatch(message, ticks[tick], tick, FIRST_TIMESTAMP_MS + tick * 1000, dictionaries[0], dictionaries[1]);
+
+		log << "  arrow_stream: batch " << tick << ", " << ticks[tick].size() << " rows, " << received[0] << " new names, "
+			<< received[1] << " new SIDs ok\n";
+
+		seenNames.insert(newNames.begin(), newNames.end());
+		seenUsers.insert(newUsers.begin(), newUsers.end());
+		received[0] = 0;
+		received[1] = 0;
+		tick++;
+	}
+
+	requireArrow(tick == ticks.size(), "fewer record batches than ticks");
+
+	for (const auto& dictionary : dictionaries)
+	{
+		requireArrow(std::find(dictionary.begin(), dictionary.end(), toUtf8(PENDING_METADATA)) == dictionary.end(),
+			"the pending placeholder was written to a dictionary");
+	}
+
+	requireArrow(reader.remaining() == 0, "bytes after the end-of-stream marker");
+}
+
+/// <summary>
+/// Exports rows with RowExporter into a temporary file and returns the bytes written.
+/// </summary>
+/// <param name="format">The row format.</param>
+/// <param name="processes">The rows, all written as tick 0 with timestamp 0.</param>
+/// <returns>The exported text, without a CSV header.</returns>
+static std::string exportRows(ExportFormat format, const std::vector<ProcessInfo>& processes)
+{
+	TemporaryFile file;
+
+	{
+		OutputBuffer out(file.get());
+		RowExporter exporter(format, out);
+
+		for (const auto& p : processes)
+		{
+			exporter.writeRow(p, 0, 0);
+		}
+
+		out.flush();
+	}
+
+	const std::vector<std::uint8_t> bytes = file.readAll();
+	return std::string(bytes.begin(), bytes.end());
+}
+
+/// <summary>
+/// Checks that RowExporter writes a row whose metadata is pending with a null name and SID in both formats, next to a resolved
+/// row and one with an unknown owner, and never the PENDING_METADATA placeholder. Throws std::runtime_error on a mismatch.
+/// </summary>
+/// <param name="log">Receives one line when the check passes.</param>
+static void checkPendingExport(std::ostream& log)
+{
+	std::vector<ProcessInfo> processes(3);
+	processes[0].pid = 4;
+	processes[0].name = L"svchost.exe";
+	processes[0].userSid = L"S-1-5-18";
+	processes[0].workingSetBytes = 1000;
+	processes[0].privateBytes = 500;
+	processes[1].pid = 8;
+	processes[1].name = L"idle.exe";
+	processes[1].workingSetBytes = 10;
+	processes[2].pid = 12;
+	processes[2].name = PENDING_METADATA;
+	processes[2].userSid = PENDING_METADATA;
+	processes[2].metadataPending = true;
+	processes[2].workingSetBytes = 2000;
+	processes[2].privateBytes = 700;
+
+	const std::string csv = exportRows(ExportFormat::Csv, processes);
+	const std::string expectedCsv =
+		"0,0,4,\"svchost.exe\",\"S-1-5-18\",1000,500\n"
+		"0,0,8,\"idle.exe\",\"\",10,0\n"
+		"0,0,12,,,2000,700\n";
+
+	if (csv != expectedCsv)
+	{
+		throw std::runtime_error("RowExporter CSV with a pending row:\n" + csv);
+	}
+
+	const std::string json = exportRows(ExportFormat::Ndjson, processes);
+	const std::string expectedJson =
+		"{\"tick\":0,\"timestamp_ms\":0,\"pid\":4,\"name\":\"svchost.exe\",\"user_sid\":\"S-1-5-18\",\"working_set_bytes\":1000,\"private_bytes\":500}\n"
+		"{\"tick\":0,\"timestamp_ms\":0,\"pid\":8,\"name\":\"idle.exe\",\"user_sid\":\"\",\"working_set_bytes\":10,\"private_bytes\":0}\n"
+		"{\"tick\":0,\"timestamp_ms\":0,\"pid\":12,\"name\":null,\"user_sid\":null,\"working_set_bytes\":2000,\"private_bytes\":700}\n";
+
+	if (json != expectedJson)
+	{
+		throw std::runtime_error("RowExporter NDJSON with a pending row:\n" + json);
+	}
+
+	log << "  row_export: pending rows exported as null ok\n";
+}
+
+/// <summary>
+/// Appends a code point to a string as UTF-8.
+/// </summary>
+/// <param name="out">The string.</param>
+/// <param name="cp">The code point; surrogates must have been replaced.</param>
+static void appendUtf8(std::string& out, std::uint32_t cp)
+{
+	if (cp < 0x80)
+	{
+		out += static_cast<char>(cp);
+	}
+	else if (cp < 0x800)
+	{
+		out += static_cast<char>(0xC0 | (cp >> 6));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	else if (cp < 0x10000)
+	{
+		out += static_cast<char>(0xE0 | (cp >> 12));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	else
+	{
+		out += static_cast<char>(0xF0 | (cp >> 18));
+		out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+}
+
+/// <summary>
+/// The reference for RowExporter's string fields: one code point at a time, with no blocks and no SIMD. Decodes UTF-16 (an
+/// unpaired surrogate becomes U+FFFD), escapes quotes, backslashes and control characters per format and encodes UTF-8.
+/// </summary>
+/// <param name="text">The UTF-16 code units, one per wchar_t.</param>
+/// <param name="json">true for NDJSON; false for CSV.</param>
+/// <returns>The quoted field.</returns>
+static std::string escapeReference(std::wstring_view text, bool json)
+{
+	std::string out = "\"";
+
+	for (std::size_t i = 0; i < text.size(); i++)
+	{
+		std::uint32_t cp = static_cast<std::uint16_t>(text[i]);
+
+		if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < text.size())
+		{
+			const std::uint32_t low = static_cast<std::uint16_t>(text[i + 1]);
+
+			if (low >= 0xDC00 && low <= 0xDFFF)
+			{
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+				i++;
+			}
+		}
+
+		if (cp >= 0xD800 && cp <= 0xDFFF)
+		{
+			cp = 0xFFFD;
+		}
+
+		if (cp == '"')
+		{
+			out += json ? "\\\"" : "\"\"";
+		}
+		else if (cp == '\\')
+		{
+			out += json ? "\\\\" : "\\";
+		}
+		else if (cp < 0x20 && json)
+		{
+			constexpr char hex[] = "0123456789abcdef";
+			out += "\\u00";
+			out += hex[cp >> 4];
+			out += hex[cp & 0xF];
+		}
+		else
+		{
+			appendUtf8(out, cp);
+		}
+	}
+
+	out += '"';
+	return out;
+}
+
+/// <summary>
+/// Checks RowExporter's string escaping, whose plain-ASCII blocks take an SSE2 path on x86, against escapeReference() in both
+/// formats. The strings place quotes, backslashes, control characters, DEL, code units at the signed-compare edge (0x7F, 0x80,
+/// 0x7FFF, 0x8000, 0xFFFF), surrogate pairs and unpaired surrogates at every offset of strings 0 to 40 units long, which covers
+/// both sides of the 8-unit block and of 16- and 24-unit runs; pairs that straddle a block boundary are included, as are
+/// random strings over the same alphabet. Throws std::runtime_error on the first row that differs.
+/// </summary>
+/// <param name="log">Receives one line when the check passes.</param>
+static void checkEscaping(std::ostream& log)
+{
+	constexpr std::size_t MAX_LENGTH = 40;
+	constexpr std::size_t RANDOM_STRINGS = 2'000;
+
+	// Each special sequence is inserted into a plain ASCII string; the two-unit ones are valid surrogate pairs.
+	const std::vector<std::wstring> specials = {
+		L"\"", L"\\", L"\x01", L"\n", L"\x1F", L" ", L"~", L"\x7F",
+		std::wstring(1, static_cast<wchar_t>(0x80)), std::wstring(1, static_cast<wchar_t>(0xE9)),
+		std::wstring(1, static_cast<wchar_t>(0x7FF)), std::wstring(1, static_cast<wchar_t>(0x800)),
+		std::wstring(1, static_cast<wchar_t>(0x7FFF)), std::wstring(1, static_cast<wchar_t>(0x8000)),
+		std::wstring(1, static_cast<wchar_t>(0x20AC)), std::wstring(1, static_cast<wchar_t>(0xFFFF)),
+		std::wstring(1, static_cast<wchar_t>(0xD83D)), std::wstring(1, static_cast<wchar_t>(0xDE00)),
+		std::wstring{ static_cast<wchar_t>(0xD83D), static_cast<wchar_t>(0xDE00) },
+		std::wstring{ static_cast<wchar_t>(0xDBFF), static_cast<wchar_t>(0xDFFF) },
+		std::wstring{ static_cast<wchar_t>(0xDE00), static_cast<wchar_t>(0xD83D) } };
+
+	std::vector<std::wstring> strings;
+
+	for (std::size_t length = 0; length <= MAX_LENGTH; length++)
+	{
+		std::wstring plain(length, L' ');
+
+		for (std::size_t k = 0; k < length; k++)
+		{
+			plain[k] = static_cast<wchar_t>(L'a' + k % 26);
+		}
+
+		strings.push_back(plain);
+
+		for (const auto& special : specials)
+		{
+			for (std::size_t at = 0; at + special.size() <= length; at++)
+			{
+				std::wstring text = plain;
+				text.replace(at, special.size(), special);
+				strings.push_back(std::move(text));
+			}
+		}
+	}
+
+	std::mt19937 random(11);
+	std::uniform_int_distribution<std::size_t> lengths(0, MAX_LENGTH);
+	std::uniform_int_distribution<std::size_t> picks(0, specials.size() * 2 - 1);
+
+	for (std::size_t n = 0; n < RANDOM_STRINGS; n++)
+	{
+		std::wstring text;
+		const std::size_t length = lengths(random);
+
+		while (text.size() < length)
+		{
+			// Half of the picks are plain letters, so plain blocks and special ones alternate.
+			const std::size_t pick = picks(random);
+			text += pick < specials.size() ? specials[pick] : std::wstring(1, static_cast<wchar_t>(L'A' + pick % 26));
+		}
+
+		strings.push_back(std::move(text));
+	}
+
+	for (const bool json : { false, true })
+	{
+		std::vector<ProcessInfo> processes(strings.size());
+		std::vector<std::string> expected(strings.size());
+
+		for (std::size_t i = 0; i < strings.size(); i++)
+		{
+			processes[i].pid = static_cast<DWORD>(i);
+			processes[i].name = strings[i];
+			processes[i].userSid = strings[strings.size() - 1 - i];
+
+			const std::string pid = std::to_string(i);
+			const std::string name = escapeReference(processes[i].name, json);
+			const std::string sid = escapeReference(processes[i].userSid, json);
+
+			expected[i] = json
+				? "{\"tick\":0,\"timestamp_ms\":0,\"pid\":" + pid + ",\"name\":" + name + ",\"user_sid\":" + sid
+					+ ",\"working_set_bytes\":0,\"private_bytes\":0}\n"
+				: "0,0," + pid + "," + name + "," + sid + ",0,0\n";
+		}
+
+		const std::string actual = exportRows(json ? ExportFormat::Ndjson : ExportFormat::Csv, processes);
+		std::size_t offset = 0;
+
+		for (std::size_t i = 0; i < expected.size(); i++)
+		{
+			if (actual.compare(offset, expected[i].size(), expected[i]) != 0)
+			{
+				throw std::runtime_error(std::string("RowExporter ") + (json ? "NDJSON" : "CSV") + " escaping differs from the reference at row "
+					+ std::to_string(i) + ":\n  expected " + expected[i] + "  actual   " + actual.substr(offset, expected[i].size()));
+			}
+
+			offset += expected[i].size();
+		}
+
+		if (offset != actual.size())
+		{
+			throw std::runtime_error("RowExporter wrote more than the reference rows.");
+		}
+	}
+
+	log << "  row_export: " << strings.size() << " strings escaped like the reference ok\n";
+}
+
+/// <summary>
+/// Checks HeavyHitters::merge: two summaries of skewed streams with different capacities are merged, and every monitored key's
+/// estimate must still bound its true weight from above, with the true weight no lower than the estimate minus its error, and
+/// the total weight must be the sum of both. Throws std::runtime_error on the first violation.
+/// </summary>
+/// <param name="log">Receives one line when the check passes.</param>
+static void checkHeavyHitters(std::ostream& log)
+{
+	constexpr std::size_t KEYS = 500;
+	constexpr std::size_t SAMPLES = 20'000;
+
+	std::mt19937 random(5);
+	std::map<std::wstring, double> exact;
+	HeavyHitters first(32);
+	HeavyHitters second(48);
+
+	// Keys drawn log-uniformly, so a few keys carry most of the weight, as a few executables do; the two halves of the stream
+	// are skewed towards different keys so the merge has to combine counters that only one side monitors.
+	std::uniform_real_distribution<double> logKey(0.0, std::log2(static_cast<double>(KEYS)));
+	std::uniform_real_distribution<double> weight(1.0, 1000.0);
+
+	for (std::size_t i = 0; i < 2 * SAMPLES; i++)
+	{
+		const auto rank = static_cast<std::size_t>(std::exp2(logKey(random))) - 1;
+		const std::wstring key = L"app" + std::to_wstring(i < SAMPLES ? rank : KEYS - 1 - rank) + L".exe";
+		const double w = weight(random);
+
+		(i < SAMPLES ? first : second).add(key, w);
+		exact[key] += w;
+	}
+
+	const double total = first.totalWeight() + second.totalWeight();
+	first.merge(second);
+
+	if (std::abs(first.totalWeight() - total) > total * 1e-12)
+	{
+		throw std::runtime_error("HeavyHitters::merge lost total weight.");
+	}
+
+	const auto merged = first.top(KEYS);
+
+	if (merged.size() != 32)
+	{
+		throw std::runtime_error("HeavyHitters::merge did not keep its capacity.");
+	}
+
+	for (const auto& hitter : merged)
+	{
+		const double truth = exact[hitter.key];
+		const double slack = 1e-9 * total;
+
+		if (hitter.weight + slack < truth || hitter.weight - hitter.error > truth + slack)
+		{
+			throw std::runtime_error("HeavyHitters::merge estimate for " + toUtf8(hitter.key) + " does not bound its true weight.");
+		}
+	}
+
+	log << "  heavy_hitters: merged " << merged.size() << " counters ok\n";
+}
+
+/// <summary>
+/// Runs the self-checks: correctness checks of code paths the benchmarks time, against simple reference implementations.
+/// Throws std::runtime_error on the first failure.
+/// </summary>
+/// <param name="log">Receives progress lines.</param>
+void runSelfChecks(std::ostream& log)
+{
+	checkAddressIndex(log);
+	checkArrowStream(log);
+	checkPendingExport(log);
+	checkEscaping(log);
+	checkHeavyHitters(log);
+}
\ No newline at end of file
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <ostream>
+
+void runSelfChecks(std::ostream& log);
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include <Windows.h>
+
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "Snapshot.hpp"
+#include "TextEncoding.hpp"
+
+/// <summary>
+/// Columns of a CSV export, see RowExporter.
+/// </summary>
+constexpr std::size_t CSV_COLUMNS = 7;
+
+/// <summary>
+/// Splits one CSV record into fields, undoing RowExporter's quoting ("" inside quoted fields).
+/// </summary>
+/// <param name="line">The record without its line break.</param>
+/// <param name="fields">Receives the fields.</param>
+/// <returns>true if the record has exactly CSV_COLUMNS fields.</returns>
+static bool splitCsvRecord(std::string_view line, std::array<std::string, CSV_COLUMNS>& fields)
+{
+	std::size_t column = 0;
+	std::size_t i = 0;
+
+	for (auto& field : fields)
+	{
+		field.clear();
+	}
+
+	while (true)
+	{
+		if (column == CSV_COLUMNS)
+		{
+			return false;
+		}
+
+		std::string& field = fields[column];
+
+		if (i < line.size() && line[i] == '"')
+		{
+			for (i++; i < line.size(); i++)
+			{
+				if (line[i] == '"')
+				{
+					if (i + 1 < line.size() && line[i + 1] == '"')
+					{
+						field += '"';
+						i++;
+						continue;
+					}
+
+					i++;
+					break;
+				}
+
+				field += line[i];
+			}
+		}
+		else
+		{
+			for (; i < line.size() && line[i] != ','; i++)
+			{
+				field += line[i];
+			}
+		}
+
+		column++;
+
+		if (i >= line.size())
+		{
+			return column == CSV_COLUMNS;
+		}
+
+		if (line[i] != ',')
+		{
+			return false;
+		}
+
+		i++;
+	}
+}
+
+/// <summary>
+/// Parses an unsigned decimal field.
+/// </summary>
+/// <param name="text">The field.</param>
+/// <param name="value">Receives the value.</param>
+/// <returns>true if the field is a non-empty run of digits that fits in 64 bits.</returns>
+static bool parseUnsigned(std::string_view text, std::uint64_t& value)
+{
+	if (text.empty() || text.size() > 20)
+	{
+		return false;
+	}
+
+	value = 0;
+
+	for (const char c : text)
+	{
+		if (c < '0' || c > '9')
+		{
+			return false;
+		}
+
+		const std::uint64_t digit = static_cast<std::uint64_t>(c - '0');
+
+		if (value > (UINT64_MAX - digit) / 10)
+		{
+			return false;
+		}
+
+		value = value * 10 + digit;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Loads a recorded snapshot: the first tick of a CSV file written by "ProcessMemorySniffer --format csv".
+/// Recorded snapshots let collection-independent benchmarks run against a real process mix from another machine.
+/// Throws std::runtime_error if the file cannot be read or is not a CSV export.
+/// </summary>
+/// <param name="path">The path of the CSV file.</param>
+/// <returns>The processes of the first tick in the file.</returns>
+std::vector<ProcessInfo> loadSnapshot(const std::wstring& path)
+{
+	std::ifstream in(std::filesystem::path(path), std::ios::binary);
+
+	if (!in)
+	{
+		throw std::runtime_error("Failed to open snapshot: " + toUtf8(path));
+	}
+
+	std::string line;
+
+	if (!std::getline(in, line) || !line.starts_with("tick,timestamp_ms,pid,name,user_sid,working_set_bytes,private_bytes"))
+	{
+		throw std::runtime_error("Not a CSV export: " + toUtf8(path));
+	}
+
+	std::vector<ProcessInfo> processes;
+	std::array<std::string, CSV_COLUMNS> fields;
+	std::uint64_t firstTick = 0;
+	std::size_t lineNumber = 1;
+
+	while (std::getline(in, line))
+	{
+		lineNumber++;
+
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		if (line.empty())
+		{
+			continue;
+		}
+
+		std::uint64_t tick = 0;
+		std::uint64_t pid = 0;
+		std::uint64_t workingSet = 0;
+		std::uint64_t privateBytes = 0;
+
+		if (!splitCsvRecord(line, fields) || !parseUnsigned(fields[0], tick) || !parseUnsigned(fields[2], pid)
+			|| !parseUnsigned(fields[5], workingSet) || !parseUnsigned(fields[6], privateBytes))
+		{
+			throw std::runtime_error("Malformed record on line " + std::to_string(lineNumber) + " of " + toUtf8(path));
+		}
+
+		if (processes.empty())
+		{
+			firstTick = tick;
+		}
+		else if (tick != firstTick)
+		{
+			break;
+		}
+
+		ProcessInfo info;
+		info.pid = static_cast<DWORD>(pid);
+		info.name = fromUtf8(fields[3]);
+		info.userSid = fromUtf8(fields[4]);
+		info.workingSetBytes = static_cast<Bytes>(workingSet);
+		info.privateBytes = static_cast<Bytes>(privateBytes);
+		info.peakWorkingSetBytes = info.workingSetBytes;
+		processes.push_back(std::move(info));
+	}
+
+	return processes;
+}
+
+/// <summary>
+/// Generates a deterministic synthetic process list with a realistic shape: many instances of a few common executables,
+/// a long tail of unique names, a handful of owners, and log-uniform working sets between 64 KiB and 4 GiB.
+/// </summary>
+/// <param name="count">The number of processes.</param>
+/// <param name="seed">The random seed; equal seeds give equal lists.</param>
+/// <returns>The processes.</returns>
+std::vector<ProcessInfo> makeSyntheticProcesses(std::size_t count, std::uint32_t seed)
+{
+	constexpr const wchar_t* COMMON_NAMES[] = {
+		L"svchost.exe", L"chrome.exe", L"msedge.exe", L"RuntimeBroker.exe", L"conhost.exe",
+		L"dllhost.exe", L"explorer.exe", L"Code.exe", L"WmiPrvSE.exe", L"SearchHost.exe",
+	};
+	constexpr const wchar_t* SIDS[] = {
+		L"S-1-5-18", L"S-1-5-19", L"S-1-5-20", L"S-1-5-21-1004336348-1177238915-682003330-1001", L"",
+	};
+
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<std::size_t> nameChoice(0, std::size(COMMON_NAMES) * 2 - 1);
+	std::uniform_int_distribution<std::size_t> sidChoice(0, std::size(SIDS) - 1);
+	std::uniform_real_distribution<double> log2Size(16.0, 32.0);
+
+	std::vector<ProcessInfo> processes;
+	processes.reserve(count);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		ProcessInfo info;
+		info.pid = static_cast<DWORD>(4 * (i + 1));
+
+		// Half of the draws land on a common name, the rest get a unique one.
+		const std::size_t name = nameChoice(random);
+		info.name = name < std::size(COMMON_NAMES) ? COMMON_NAMES[name] : L"app" + std::to_wstring(i) + L".exe";
+		info.userSid = SIDS[sidChoice(random)];
+		info.workingSetBytes = static_cast<Bytes>(std::exp2(log2Size(random)));
+		info.privateBytes = static_cast<Bytes>(std::exp2(log2Size(random)));
+		info.peakWorkingSetBytes = info.workingSetBytes + info.workingSetBytes / 4;
+		processes.push_back(std::move(info));
+	}
+
+	return processes;
+}
+
+/// <summary>
+/// Generates a deterministic synthetic region list shaped like a process address space: sorted, non-overlapping regions of
+/// one to 256 pages, about half of them directly followed by the next region and the rest by a free gap of up to 64 pages.
+/// </summary>
+/// <param name="count">The number of regions.</param>
+/// <param name="seed">The random seed; equal seeds give equal lists.</param>
+/// <returns>The regions, sorted by base address.</returns>
+std::vector<MemoryRegion> makeSyntheticRegions(std::size_t count, std::uint32_t seed)
+{
+	constexpr std::uintptr_t PAGE = 0x1000;
+
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<std::uintptr_t> pages(1, 256);
+	std::uniform_int_distribution<std::uintptr_t> gapPages(0, 128);
+
+	std::vector<MemoryRegion> regions;
+	regions.reserve(count);
+
+	// Start above the null page so that addresses below the first region exist.
+	std::uintptr_t next = 0x10000;
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		MemoryRegion region;
+		region.base = next;
+		region.allocationBase = next;
+		region.size = static_cast<Bytes>(pages(random) * PAGE);
+		region.state = i % 3 == 0 ? RegionState::Reserved : RegionState::Committed;
+		region.protect = region.state == RegionState::Committed ? PAGE_READWRITE : 0;
+		regions.push_back(region);
+
+		// Draws above 64 pages mean no gap, so about half of the regions are adjacent to the next one.
+		const std::uintptr_t gap = gapPages(random);
+		next = region.end() + (gap > 64 ? 0 : gap * PAGE);
+	}
+
+	return regions;
+}
\ No newline at end of file
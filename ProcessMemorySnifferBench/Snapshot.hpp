@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MemoryRegion.hpp"
+#include "ProcessInfo.hpp"
+
+[[nodiscard]] std::vector<ProcessInfo> loadSnapshot(const std::wstring& path);
+
+[[nodiscard]] std::vector<ProcessInfo> makeSyntheticProcesses(std::size_t count, std::uint32_t seed);
+
+[[nodiscard]] std::vector<MemoryRegion> makeSyntheticRegions(std::size_t count, std::uint32_t seed);
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Benchmark.hpp"
+#include "BenchmarkComparison.hpp"
+#include "Benchmarks.hpp"
+#include "SelfChecks.hpp"
+#include "Snapshot.hpp"
+#include "TextEncoding.hpp"
+#include "Win32Error.hpp"
+
+/// <summary>
+/// The number of processes in the synthetic list; an order of magnitude above a typical desktop so per-item costs dominate.
+/// </summary>
+constexpr std::size_t SYNTHETIC_PROCESSES = 10'000;
+
+/// <summary>
+/// Exit code when the comparison with a baseline finds a significant regression.
+/// </summary>
+constexpr int EXIT_REGRESSION = 2;
+
+/// <summary>
+/// Options of a benchmark run.
+/// </summary>
+struct BenchOptions
+{
+	/// <summary>
+	/// Only benchmarks whose name contains this string are run.
+	/// </summary>
+	std::string					filter;
+
+	/// <summary>
+	/// The minimum timed duration per benchmark.
+	/// </summary>
+	std::chrono::milliseconds	minTime{ 500 };
+
+	/// <summary>
+	/// The number of timed batches (samples) per benchmark.
+	/// </summary>
+	std::size_t					repetitions{ 10 };
+
+	/// <summary>
+	/// If not empty, a CSV export to run the "recorded" benchmarks against.
+	/// </summary>
+	std::wstring				snapshotFile;
+
+	/// <summary>
+	/// If not empty, the results are written to this file instead of standard output.
+	/// </summary>
+	std::wstring				outputFile;
+
+	/// <summary>
+	/// If not empty, the results are also stored to this file as a baseline for later comparisons.
+	/// </summary>
+	std::wstring				saveBaselineFile;
+
+	/// <summary>
+	/// If not empty, a stored baseline the results are compared with.
+	/// </summary>
+	std::wstring				baselineFile;
+
+	/// <summary>
+	/// The smallest relative slowdown that fails the comparison.
+	/// </summary>
+	double						threshold{ 0.05 };
+
+	/// <summary>
+	/// Whether to run the self-checks instead of the benchmarks.
+	/// </summary>
+	bool						runChecks{ false };
+
+	/// <summary>
+	/// Whether usage information was requested.
+	/// </summary>
+	bool						showHelp{ false };
+};
+
+/// <summary>
+/// Prints the supported options.
+/// </summary>
+static void printUsage()
+{
+	std::wcout
+		<< L"Usage: ProcessMemorySnifferBench [options]\n\n"
+		<< L"      --filter <text>    Run only benchmarks whose name contains <text>.\n"
+		<< L"      --min-time <ms>    Minimum timed duration per benchmark (default 500).\n"
+		<< L"      --repetitions <n>  Timed samples per benchmark (default 10).\n"
+		<< L"      --snapshot <file>  CSV written by ProcessMemorySniffer --format csv; adds the *_recorded benchmarks.\n"
+		<< L"      --out <file>       Write the JSON results to <file> instead of standard output.\n"
+		<< L"      --save-baseline <file>  Also store the results in <file> as a baseline.\n"
+		<< L"      --baseline <file>  Compare with a stored baseline; exits with 2 on a significant regression.\n"
+		<< L"      --threshold <pct>  Smallest slowdown in percent that counts as a regression (default 5).\n"
+		<< L"      --check            Run the self-checks instead of the benchmarks.\n"
+		<< L"  -h, --help             Show this help.\n";
+}
+
+/// <summary>
+/// Parses a decimal option value within a range. Throws std::invalid_argument if the value is not a number or out of range.
+/// </summary>
+/// <param name="option">The option name, for the error message.</param>
+/// <param name="text">The value.</param>
+/// <param name="min">The smallest accepted value.</param>
+/// <param name="max">The largest accepted value.</param>
+/// <returns>The value.</returns>
+static unsigned long parseBenchNumber(const std::wstring& option, const std::wstring& text, unsigned long min, unsigned long max)
+{
+	try
+	{
+		std::size_t used = 0;
+		const unsigned long value = std::stoul(text, &used);
+
+		if (used == text.size() && value >= min && value <= max)
+		{
+			return value;
+		}
+	}
+	catch (const std::logic_error&)
+	{
+	}
+
+	throw std::invalid_argument("Invalid value '" + toUtf8(text) + "' for " + toUtf8(option) + ".");
+}
+
+/// <summary>
+/// Parses the command line. Throws std::invalid_argument on unknown options or missing and invalid values.
+/// </summary>
+/// <param name="argc">The argument count.</param>
+/// <param name="argv">The arguments.</param>
+/// <returns>The options.</returns>
+static BenchOptions parseBenchCommandLine(int argc, wchar_t* argv[])
+{
+	BenchOptions options;
+
+	auto value = [&](int& i) -> std::wstring
+		{
+			if (i + 1 >= argc)
+			{
+				throw std::invalid_argument("Missing value for " + toUtf8(argv[i]) + ".");
+			}
+
+			return argv[++i];
+		};
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::wstring arg = argv[i];
+
+		if (arg == L"--help" || arg == L"-h")
+		{
+			options.showHelp = true;
+		}
+		else if (arg == L"--check")
+		{
+			options.runChecks = true;
+		}
+		else if (arg == L"--filter")
+		{
+			options.filter = toUtf8(value(i));
+		}
+		else if (arg == L"--min-time")
+		{
+			options.minTime = std::chrono::milliseconds(parseBenchNumber(arg, value(i), 1, 600'000));
+		}
+		else if (arg == L"--repetitions")
+		{
+			options.repetitions = parseBenchNumber(arg, value(i), 3, 1000);
+		}
+		else if (arg == L"--threshold")
+		{
+			options.threshold = static_cast<double>(parseBenchNumber(arg, value(i), 0, 1000)) / 100.0;
+		}
+		else if (arg == L"--save-baseline")
+		{
+			options.saveBaselineFile = value(i);
+		}
+		else if (arg == L"--baseline")
+		{
+			options.baselineFile = value(i);
+		}
+		else if (arg == L"--snapshot")
+		{
+			options.snapshotFile = value(i);
+		}
+		else if (arg == L"--out")
+		{
+			options.outputFile = value(i);
+		}
+		else
+		{
+			throw std::invalid_argument("Unknown option '" + toUtf8(arg) + "'.");
+		}
+	}
+
+	return options;
+}
+
+/// <summary>
+/// Writes results to a JSON file, replacing it. Throws std::runtime_error if the file cannot be written.
+/// </summary>
+/// <param name="path">The path of the file.</param>
+/// <param name="results">The results.</param>
+static void writeResultsFile(const std::wstring& path, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream out(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+	writeJson(out, results);
+
+	if (!out)
+	{
+		throw std::runtime_error("Failed to write " + toUtf8(path));
+	}
+}
+
+/// <summary>
+/// Benchmark entry point: registers the benchmarks, runs those matching the filter and writes the results as JSON, or runs the self-checks with --check.
+/// Progress goes to standard error so standard output carries only the JSON document.
+/// </summary>
+/// <param name="argc">The argument count.</param>
+/// <param name="argv">The wide-character argument vector.</param>
+/// <returns>EXIT_SUCCESS, EXIT_REGRESSION if the comparison with a baseline found a significant regression, or EXIT_FAILURE on invalid arguments, a failed benchmark or a failed self-check.</returns>
+int wmain(int argc, wchar_t* argv[])
+{
+	BenchOptions options;
+
+	try
+	{
+		options = parseBenchCommandLine(argc, argv);
+	}
+	catch (const std::invalid_argument& ex)
+	{
+		std::cerr << "Error: " << ex.what() << "\n\n";
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (options.showHelp)
+	{
+		printUsage();
+		return EXIT_SUCCESS;
+	}
+
+	try
+	{
+		if (options.runChecks)
+		{
+			std::cerr << "Running self-checks...\n";
+			runSelfChecks(std::cerr);
+			return EXIT_SUCCESS;
+		}
+
+		BenchmarkInputs inputs;
+		inputs.synthetic = makeSyntheticProcesses(SYNTHETIC_PROCESSES, 1);
+
+		if (!options.snapshotFile.empty())
+		{
+			inputs.recorded = loadSnapshot(options.snapshotFile);
+		}
+
+		// Load the baseline first, so a bad path fails before the benchmarks run.
+		std::vector<BenchmarkResult> baseline;
+
+		if (!options.baselineFile.empty())
+		{
+			baseline = loadResults(options.baselineFile);
+		}
+
+		BenchmarkRunner runner(options.minTime, options.repetitions);
+		registerBenchmarks(runner, inputs);
+
+		std::cerr << "Running benchmarks...\n";
+		const auto results = runner.run(options.filter);
+
+		for (const auto& result : results)
+		{
+			std::cerr << "  " << result.name << ": " << result.medianNs << " ns/iteration\n";
+		}
+
+		if (options.outputFile.empty())
+		{
+			writeJson(std::cout, results);
+		}
+		else
+		{
+			writeResultsFile(options.outputFile, results);
+		}
+
+		if (!options.saveBaselineFile.empty())
+		{
+			writeResultsFile(options.saveBaselineFile, results);
+		}
+
+		if (!options.baselineFile.empty())
+		{
+			const auto comparisons = compareResults(baseline, results, options.threshold);
+			printComparison(std::cerr, comparisons, options.threshold);
+
+			const bool regressed = std::any_of(comparisons.begin(), comparisons.end(),
+				[](const BenchmarkComparison& c)
+				{
+					return c.verdict == ComparisonVerdict::Regression;
+				});
+
+			if (regressed)
+			{
+				return EXIT_REGRESSION;
+			}
+		}
+	}
+	catch (const Win32Error& ex)
+	{
+		std::cerr << "Win32 error: " << ex.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	catch (const std::exception& ex)
+	{
+		std::cerr << "Error: " << ex.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file